@@ -0,0 +1,613 @@
+/*
+ * Copyright (c) 2023
+ *
+ * This software is licensed under the MIT License.
+ * SPDX-License-Identifier: MIT
+ *
+ */
+#include <mpsc/channel.hpp>
+
+#include <benchmark/benchmark.h>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <ranges>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+// Create a channel of any backend; bounded ones get a capacity large enough to rarely get in the way.
+template <typename T, typename Policy>
+auto make_bench_channel() {
+  if constexpr (std::is_same_v<typename Policy::backend, mpsc::spsc_backend>) {
+    return mpsc::make_spsc_channel<T, Policy>(4096);
+  } else if constexpr (std::is_same_v<typename Policy::backend, mpsc::mpmc_backend>) {
+    return mpsc::make_mpmc_channel<T, Policy>(4096);
+  } else if constexpr (std::is_same_v<typename Policy::backend, mpsc::broadcast_backend>) {
+    return mpsc::make_broadcast_channel<T, Policy>(4096);
+  } else if constexpr (std::is_same_v<typename Policy::backend, mpsc::bounded_backend>) {
+    return mpsc::make_bounded_channel<T, Policy>(4096);
+#if defined(__linux__)
+  } else if constexpr (std::is_same_v<typename Policy::backend, mpsc::shm_backend>) {
+    static int count = 0;
+    return mpsc::make_shm_channel<T, Policy>("/mpsc-bench-" + std::to_string(::getpid()) + "-" + std::to_string(count++),
+                                             4096);
+#endif
+  } else {
+    return mpsc::make_channel<T, Policy>();
+  }
+}
+
+// A message of `Size` bytes.
+template <std::size_t Size>
+struct Payload {
+  std::array<std::byte, Size> bytes{};
+};
+
+// The same, which an intrusive channel links through its hook.
+template <std::size_t Size>
+struct IntrusivePayload : mpsc::intrusive_hook {
+  std::array<std::byte, Size> bytes{};
+};
+
+// `Base` whose receiver is only woken up once a batch of values is waiting (see mpsc::coalesce_wakeups).
+template <typename Base>
+struct Coalescing : Base {
+  using wait_strategy = mpsc::coalesce_wakeups<>;
+};
+
+// `Base` which puts every value in a node of its own, even the small trivial ones (see Policy::inline_size).
+template <typename Base>
+struct Nodes : Base {
+  static constexpr std::size_t inline_size = 0;
+};
+
+// `Base` which stamps each value as it's sent, to measure what tracing costs (see Policy::trace_latency).
+template <typename Base>
+struct Tracing : Base {
+  static constexpr bool trace_latency = true;
+};
+
+// Latencies in nanoseconds, reported as percentiles the way HdrHistogram prints them.
+class Percentiles {
+ public:
+  explicit Percentiles(std::size_t expected) { samples.reserve(expected); }
+
+  void record(std::chrono::steady_clock::duration latency) {
+    samples.push_back(std::chrono::duration<double, std::nano>(latency).count());
+  }
+
+  void report(benchmark::State& state) {
+    if (samples.empty()) {
+      return;
+    }
+    std::sort(samples.begin(), samples.end());
+    for (const auto& [name, fraction] : {std::pair{"p50_ns", 0.5}, {"p90_ns", 0.9}, {"p99_ns", 0.99}, {"p99.9_ns", 0.999}}) {
+      state.counters[name] = samples[static_cast<std::size_t>(fraction * static_cast<double>(samples.size() - 1))];
+    }
+    state.counters["max_ns"] = samples.back();
+  }
+
+ private:
+  std::vector<double> samples;
+};
+
+constexpr std::int64_t per_producer = 100'000;
+
+// `state.range(0)` producers send to one receiver; measures messages per second through the channel, which is where
+// producers and the receiver writing the same cache lines show up. `tx` stays alive until everything is received,
+// as closing the channel would drop what is still queued.
+template <typename Policy, typename T = std::int64_t>
+void producers(benchmark::State& state) {
+  const auto producer_count = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    auto [tx, rx] = make_bench_channel<T, Policy>();
+
+    std::vector<std::jthread> threads;
+    threads.reserve(producer_count);
+    for (std::size_t i = 0; i < producer_count; ++i) {
+      threads.emplace_back([tx = tx]() mutable {
+        for (std::int64_t n = 0; n < per_producer; ++n) {
+          tx.send(T{});
+        }
+      });
+    }
+
+    for (std::int64_t i = 0; i < per_producer * static_cast<std::int64_t>(producer_count); ++i) {
+      benchmark::DoNotOptimize(rx.receive());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * per_producer * state.range(0));
+  state.SetBytesProcessed(state.iterations() * per_producer * state.range(0) * static_cast<std::int64_t>(sizeof(T)));
+}
+
+// Like producers, but each producer sends through a BufferedSender, which hands its values over 64 at a time (and
+// the rest when it's destroyed).
+template <typename Policy>
+void buffered_producers(benchmark::State& state) {
+  const auto producer_count = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    auto [tx, rx] = make_bench_channel<std::int64_t, Policy>();
+
+    std::vector<std::jthread> threads;
+    threads.reserve(producer_count);
+    for (std::size_t i = 0; i < producer_count; ++i) {
+      threads.emplace_back([buffered = mpsc::BufferedSender{tx, 64}]() mutable {
+        for (std::int64_t n = 0; n < per_producer; ++n) {
+          buffered.send(n);
+        }
+      });
+    }
+
+    for (std::int64_t i = 0; i < per_producer * static_cast<std::int64_t>(producer_count); ++i) {
+      benchmark::DoNotOptimize(rx.receive());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * per_producer * state.range(0));
+}
+
+// Two producers send to a receiver which sums the values as a range: one at a time through std::views::take for a
+// range of 0, or in batches of up to `state.range(0)` through mpsc::chunked.
+template <typename Policy>
+void receive_pipeline(benchmark::State& state) {
+  constexpr std::int64_t total = 2 * per_producer;
+
+  for (auto _ : state) {
+    auto [tx, rx] = make_bench_channel<std::int64_t, Policy>();
+
+    std::vector<std::jthread> threads;
+    for (int i = 0; i < 2; ++i) {
+      threads.emplace_back([tx = tx]() mutable {
+        for (std::int64_t n = 0; n < per_producer; ++n) {
+          tx.send(n);
+        }
+      });
+    }
+
+    std::int64_t sum = 0;
+    if (0 == state.range(0)) {
+      for (std::int64_t value : rx | std::views::take(total)) {
+        sum += value;
+      }
+    }
+    else {
+      std::int64_t left = total;
+      for (const auto& chunk : rx | mpsc::chunked(static_cast<std::size_t>(state.range(0)))) {
+        sum  = std::accumulate(chunk.begin(), chunk.end(), sum);
+        left -= static_cast<std::int64_t>(chunk.size());
+        if (0 == left) {
+          break;
+        }
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * 2 * per_producer);
+}
+
+// Two producers send to a WorkerPool of `state.range(0)` workers, whose handler does a little work for each value.
+template <typename Policy>
+void worker_pool(benchmark::State& state) {
+  const auto workers = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    auto [tx, rx] = make_bench_channel<std::int64_t, Policy>();
+    std::atomic<std::int64_t> handled{0};
+    {
+      mpsc::WorkerPool pool{std::move(rx),
+                            [&handled](std::int64_t value) {
+                              for (int i = 0; i < 100; ++i) {
+                                benchmark::DoNotOptimize(value += i);
+                              }
+                              handled.fetch_add(1, std::memory_order_relaxed);
+                            },
+                            workers};
+      {
+        std::vector<std::jthread> threads;
+        for (int i = 0; i < 2; ++i) {
+          threads.emplace_back([tx = tx]() mutable {
+            for (std::int64_t n = 0; n < per_producer; ++n) {
+              tx.send(n);
+            }
+          });
+        }
+      }
+      // Closing drops what is still queued, unless drain_on_close is set.
+      while (handled.load(std::memory_order_relaxed) < 2 * per_producer) {
+        std::this_thread::yield();
+      }
+      tx.close();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 2 * per_producer);
+}
+
+// A single producer thread; the one the SPSC backend is made for.
+template <typename Policy>
+void one_to_one(benchmark::State& state) {
+  for (auto _ : state) {
+    auto [tx, rx] = make_bench_channel<std::int64_t, Policy>();
+
+    std::jthread producer{[&tx] {
+      for (std::int64_t n = 0; n < per_producer; ++n) {
+        tx.send(n);
+      }
+    }};
+
+    for (std::int64_t i = 0; i < per_producer; ++i) {
+      benchmark::DoNotOptimize(rx.receive());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * per_producer);
+}
+
+#if defined(__linux__)
+// One producer, and a receiver waiting in epoll_wait on native_handle() as an event loop would, draining the channel
+// with try_receive at each wakeup; to compare with one_to_one.
+template <typename Policy>
+void epoll_receiver(benchmark::State& state) {
+  const int epoll = ::epoll_create1(EPOLL_CLOEXEC);
+  for (auto _ : state) {
+    auto [tx, rx] = make_bench_channel<std::int64_t, Policy>();
+    epoll_event event{};
+    event.events  = EPOLLIN | EPOLLET;
+    event.data.fd = rx.native_handle();
+    ::epoll_ctl(epoll, EPOLL_CTL_ADD, event.data.fd, &event);
+
+    std::jthread producer{[&tx] {
+      for (std::int64_t n = 0; n < per_producer; ++n) {
+        tx.send(n);
+      }
+    }};
+
+    std::int64_t received = 0;
+    while (received < per_producer) {
+      epoll_event ready{};
+      ::epoll_wait(epoll, &ready, 1, -1);
+      while (auto value = rx.try_receive()) {
+        benchmark::DoNotOptimize(value);
+        ++received;
+      }
+    }
+    ::epoll_ctl(epoll, EPOLL_CTL_DEL, event.data.fd, nullptr);
+  }
+  ::close(epoll);
+  state.SetItemsProcessed(state.iterations() * per_producer);
+}
+#endif
+
+// One producer sends messages of `sizeof(T)` bytes.
+template <typename Policy, typename T>
+void message_size(benchmark::State& state) {
+  producers<Policy, T>(state);
+}
+
+// One producer sends 4 KiB messages behind a std::unique_ptr, which a node based channel puts in a node of its own,
+// and an intrusive channel links as they are.
+template <typename Policy, typename Message>
+void large_messages(benchmark::State& state) {
+  for (auto _ : state) {
+    auto [tx, rx] = make_bench_channel<std::unique_ptr<Message>, Policy>();
+
+    std::jthread producer{[&tx] {
+      for (std::int64_t n = 0; n < per_producer; ++n) {
+        tx.send(std::make_unique<Message>());
+      }
+    }};
+
+    for (std::int64_t i = 0; i < per_producer; ++i) {
+      benchmark::DoNotOptimize(rx.receive());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * per_producer);
+}
+
+// One producer sends batches of `state.range(0)` values with send_range, which the receiver takes with
+// receive_many; a range of 1 uses send and receive instead, for comparison.
+template <typename Policy>
+void batches(benchmark::State& state) {
+  const auto batch_size  = static_cast<std::size_t>(state.range(0));
+  const auto batch_count = per_producer / state.range(0);
+
+  for (auto _ : state) {
+    auto [tx, rx] = make_bench_channel<std::int64_t, Policy>();
+
+    std::jthread producer{[tx = tx, batch_size, batch_count]() mutable {
+      std::vector<std::int64_t> batch(batch_size);
+      for (std::int64_t n = 0; n < batch_count; ++n) {
+        if (1 == batch_size) {
+          tx.send(n);
+        } else {
+          tx.send_range(batch.begin(), batch.end());
+        }
+      }
+    }};
+
+    std::vector<std::int64_t> received(batch_size);
+    for (std::int64_t left = batch_count * state.range(0); left > 0;) {
+      if (1 == batch_size) {
+        benchmark::DoNotOptimize(rx.receive());
+        --left;
+      } else {
+        left -= static_cast<std::int64_t>(rx.receive_many(received.begin(), batch_size));
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * (per_producer / state.range(0)) * state.range(0));
+}
+
+// The same batches, which the receiver appends to a vector with drain_into, as a consumer processing whatever is
+// present at once does.
+template <typename Policy>
+void drained_batches(benchmark::State& state) {
+  const auto batch_size  = static_cast<std::size_t>(state.range(0));
+  const auto batch_count = per_producer / state.range(0);
+
+  for (auto _ : state) {
+    auto [tx, rx] = make_bench_channel<std::int64_t, Policy>();
+
+    std::jthread producer{[tx = tx, batch_size, batch_count]() mutable {
+      std::vector<std::int64_t> batch(batch_size);
+      for (std::int64_t n = 0; n < batch_count; ++n) {
+        tx.send_range(batch.begin(), batch.end());
+      }
+    }};
+
+    std::vector<std::int64_t> received;
+    for (std::int64_t left = batch_count * state.range(0); left > 0;) {
+      received.clear();
+      left -= static_cast<std::int64_t>(rx.drain_into(received));
+      benchmark::DoNotOptimize(received.data());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * (per_producer / state.range(0)) * state.range(0));
+}
+
+// A value goes back and forth between two threads over two channels; measures the round trip, i.e. twice the
+// latency of waking a waiting receiver.
+template <typename Policy>
+void ping_pong(benchmark::State& state) {
+  auto [ping_tx, ping_rx] = make_bench_channel<int, Policy>();
+  auto [pong_tx, pong_rx] = make_bench_channel<int, Policy>();
+
+  std::jthread echo{[rx = std::move(ping_rx), tx = std::move(pong_tx)]() mutable {
+    for (auto value : rx) {
+      tx.send(value);
+    }
+  }};
+
+  Percentiles round_trips{static_cast<std::size_t>(state.max_iterations)};
+  for (auto _ : state) {
+    const auto start = std::chrono::steady_clock::now();
+    ping_tx.send(1);
+    benchmark::DoNotOptimize(pong_rx.receive());
+    round_trips.record(std::chrono::steady_clock::now() - start);
+  }
+  ping_tx.close();
+  round_trips.report(state);
+}
+
+// An urgent value is sent behind a backlog of `state.range(0)` values: a priority channel hands it over first, a
+// lock-free one only after the backlog.
+template <typename Policy>
+void urgent_value(benchmark::State& state) {
+  const auto backlog = static_cast<std::int64_t>(state.range(0));
+  auto [tx, rx]      = make_bench_channel<std::int64_t, Policy>();
+
+  Percentiles latencies{static_cast<std::size_t>(state.max_iterations)};
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (std::int64_t n = 0; n < backlog; ++n) {
+      tx.send(n);
+    }
+    state.ResumeTiming();
+
+    const auto start = std::chrono::steady_clock::now();
+    if constexpr (requires { Policy::backend::lanes; }) {
+      tx.send(-1, Policy::backend::lanes - 1);
+    }
+    else {
+      tx.send(-1);
+    }
+    while (-1 != rx.receive().value()) {
+    }
+    latencies.record(std::chrono::steady_clock::now() - start);
+
+    state.PauseTiming();
+    while (rx.try_receive().has_value()) {
+    }
+    state.ResumeTiming();
+  }
+  latencies.report(state);
+}
+
+// `state.range(0)` producers and as many receivers share an MPMC channel; each value is received once.
+void competing_receivers(benchmark::State& state) {
+  const auto thread_count = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    auto [tx, rx] = make_bench_channel<std::int64_t, mpsc::mpmc_policy>();
+
+    std::vector<std::jthread> receivers;
+    for (std::size_t i = 0; i < thread_count; ++i) {
+      receivers.emplace_back([rx = rx]() mutable {
+        for (auto value : rx) {
+          benchmark::DoNotOptimize(value);
+        }
+      });
+    }
+    {
+      std::vector<std::jthread> producers;
+      for (std::size_t i = 0; i < thread_count; ++i) {
+        producers.emplace_back([&tx] {
+          for (std::int64_t n = 0; n < per_producer; ++n) {
+            tx.send(n);
+          }
+        });
+      }
+    }
+    // Closing drops what is left, so wait for the receivers to take everything first.
+    while (rx.ready()) {
+      std::this_thread::yield();
+    }
+    tx.close();
+  }
+  state.SetItemsProcessed(state.iterations() * per_producer * state.range(0));
+}
+
+// One producer sends to `state.range(0)` receivers of a broadcast channel, each of which gets every value.
+void fan_out(benchmark::State& state) {
+  const auto receiver_count = static_cast<std::int64_t>(state.range(0));
+
+  for (auto _ : state) {
+    auto [tx, rx] = make_bench_channel<std::int64_t, mpsc::broadcast_policy>();
+
+    std::vector<std::jthread> receivers;
+    for (std::int64_t i = 0; i < receiver_count; ++i) {
+      receivers.emplace_back([rx = rx]() mutable {
+        for (std::int64_t n = 0; n < per_producer; ++n) {
+          benchmark::DoNotOptimize(rx.receive());
+        }
+      });
+    }
+    // The first receiver would hold the producer back.
+    { auto first = std::move(rx); }
+
+    for (std::int64_t n = 0; n < per_producer; ++n) {
+      tx.send(n);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * per_producer * receiver_count);
+}
+
+// Every thread copies and drops a Sender, as handing one to each task does.
+void sender_copies(benchmark::State& state) {
+  static auto channel = mpsc::make_channel<int>();
+
+  for (auto _ : state) {
+    auto copy = std::get<0>(channel);
+    benchmark::DoNotOptimize(copy);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Every thread keeps sending to a closed channel, as producers racing a shutdown do: catching
+// channel_closed_exception for a range of 0, or with try_send(value, std::nothrow) for a range of 1.
+template <typename Policy>
+void sends_to_closed(benchmark::State& state) {
+  static auto channel = [] {
+    auto channel = make_bench_channel<std::int64_t, Policy>();
+    std::get<0>(channel).close();
+    return channel;
+  }();
+  auto tx = std::get<0>(channel);
+
+  for (auto _ : state) {
+    if (0 == state.range(0)) {
+      try {
+        tx.send(1);
+      }
+      catch (const mpsc::channel_closed_exception&) {
+        benchmark::ClobberMemory();
+      }
+    } else {
+      benchmark::DoNotOptimize(tx.try_send(1, std::nothrow));
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+}  // namespace
+
+BENCHMARK(producers<mpsc::default_policy>)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+BENCHMARK(producers<mpsc::lock_free_policy>)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+BENCHMARK(producers<mpsc::bounded_policy>)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+BENCHMARK(producers<mpsc::sharded_policy<8>>)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+#if defined(__linux__)
+BENCHMARK(producers<mpsc::shm_policy>)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+#endif
+BENCHMARK(producers<Coalescing<mpsc::default_policy>>)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+BENCHMARK(producers<Coalescing<mpsc::lock_free_policy>>)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+BENCHMARK(producers<Coalescing<mpsc::bounded_policy>>)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+
+BENCHMARK(buffered_producers<mpsc::default_policy>)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+BENCHMARK(buffered_producers<mpsc::lock_free_policy>)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+
+BENCHMARK(one_to_one<mpsc::default_policy>)->UseRealTime();
+BENCHMARK(one_to_one<Nodes<mpsc::default_policy>>)->UseRealTime();
+BENCHMARK(one_to_one<mpsc::lock_free_policy>)->UseRealTime();
+BENCHMARK(one_to_one<mpsc::bounded_policy>)->UseRealTime();
+BENCHMARK(one_to_one<mpsc::spsc_policy>)->UseRealTime();
+#if defined(__linux__)
+BENCHMARK(one_to_one<mpsc::shm_policy>)->UseRealTime();
+#endif
+BENCHMARK(one_to_one<Coalescing<mpsc::lock_free_policy>>)->UseRealTime();
+BENCHMARK(one_to_one<Coalescing<mpsc::spsc_policy>>)->UseRealTime();
+BENCHMARK(one_to_one<Tracing<mpsc::default_policy>>)->UseRealTime();
+BENCHMARK(one_to_one<Tracing<mpsc::lock_free_policy>>)->UseRealTime();
+#if defined(__linux__)
+BENCHMARK(epoll_receiver<mpsc::default_policy>)->UseRealTime();
+BENCHMARK(epoll_receiver<mpsc::lock_free_policy>)->UseRealTime();
+#endif
+
+BENCHMARK(message_size<mpsc::default_policy, int>)->Arg(1)->UseRealTime();
+BENCHMARK(message_size<mpsc::default_policy, Payload<64>>)->Arg(1)->UseRealTime();
+BENCHMARK(message_size<mpsc::default_policy, Payload<512>>)->Arg(1)->UseRealTime();
+BENCHMARK(message_size<mpsc::default_policy, Payload<4096>>)->Arg(1)->UseRealTime();
+BENCHMARK(message_size<mpsc::lock_free_policy, int>)->Arg(1)->UseRealTime();
+BENCHMARK(message_size<mpsc::lock_free_policy, Payload<64>>)->Arg(1)->UseRealTime();
+BENCHMARK(message_size<mpsc::lock_free_policy, Payload<512>>)->Arg(1)->UseRealTime();
+BENCHMARK(message_size<mpsc::lock_free_policy, Payload<4096>>)->Arg(1)->UseRealTime();
+BENCHMARK(message_size<mpsc::bounded_policy, int>)->Arg(1)->UseRealTime();
+BENCHMARK(message_size<mpsc::bounded_policy, Payload<64>>)->Arg(1)->UseRealTime();
+BENCHMARK(message_size<mpsc::bounded_policy, Payload<512>>)->Arg(1)->UseRealTime();
+BENCHMARK(message_size<mpsc::bounded_policy, Payload<4096>>)->Arg(1)->UseRealTime();
+
+BENCHMARK(large_messages<mpsc::lock_free_policy, Payload<4096>>)->UseRealTime();
+BENCHMARK(large_messages<mpsc::intrusive_policy, IntrusivePayload<4096>>)->UseRealTime();
+
+BENCHMARK(batches<mpsc::default_policy>)->Arg(1)->Arg(16)->Arg(256)->UseRealTime();
+BENCHMARK(batches<Nodes<mpsc::default_policy>>)->Arg(1)->Arg(16)->Arg(256)->UseRealTime();
+BENCHMARK(batches<mpsc::lock_free_policy>)->Arg(1)->Arg(16)->Arg(256)->UseRealTime();
+BENCHMARK(batches<mpsc::bounded_policy>)->Arg(1)->Arg(16)->Arg(256)->UseRealTime();
+BENCHMARK(drained_batches<mpsc::default_policy>)->Arg(16)->Arg(256)->UseRealTime();
+BENCHMARK(drained_batches<Nodes<mpsc::default_policy>>)->Arg(16)->Arg(256)->UseRealTime();
+
+BENCHMARK(receive_pipeline<mpsc::default_policy>)->Arg(0)->Arg(64)->UseRealTime();
+BENCHMARK(receive_pipeline<mpsc::lock_free_policy>)->Arg(0)->Arg(64)->UseRealTime();
+
+BENCHMARK(ping_pong<mpsc::default_policy>)->UseRealTime();
+BENCHMARK(ping_pong<mpsc::lock_free_policy>)->UseRealTime();
+BENCHMARK(ping_pong<mpsc::bounded_policy>)->UseRealTime();
+BENCHMARK(ping_pong<mpsc::spsc_policy>)->UseRealTime();
+#if defined(__linux__)
+BENCHMARK(ping_pong<mpsc::shm_policy>)->UseRealTime();
+#endif
+BENCHMARK(ping_pong<Coalescing<mpsc::lock_free_policy>>)->UseRealTime();
+
+BENCHMARK(urgent_value<mpsc::lock_free_policy>)->Arg(1)->Arg(64)->Arg(4096)->UseRealTime();
+BENCHMARK(urgent_value<mpsc::priority_policy<2>>)->Arg(1)->Arg(64)->Arg(4096)->UseRealTime();
+
+BENCHMARK(worker_pool<mpsc::lock_free_policy>)->RangeMultiplier(2)->Range(1, 4)->UseRealTime();
+BENCHMARK(competing_receivers)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK(fan_out)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+
+BENCHMARK(sender_copies)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(sends_to_closed<mpsc::default_policy>)->Arg(0)->Arg(1)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(sends_to_closed<mpsc::lock_free_policy>)->Arg(0)->Arg(1)->ThreadRange(1, 16)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -24,10 +24,23 @@
  *
  * // Send.
  * sender.send(3);
+ * sender.send_bulk(std::vector{4, 5, 6}); // Or send_range(first, last). Wakes the receiver at most once.
+ * sender.emplace(7); // Construct the value in place, from any constructor arguments.
  *
- * // Receive (both returns a std::optional<T>.)
+ * // Or fill in a value in place, and only then hand it over to the receiver.
+ * auto reservation = sender.reserve();
+ * *reservation = 8;
+ * reservation.commit();
+ *
+ * // Receive (all return a std::optional<T>.)
  * receiver.receive(); // Blocking when there is nothing present in the channel.
  * receiver.try_receive(); // Not blocking. Return immediately.
+ * receiver.receive_for(10ms); // Blocking for at most 10ms. Or receive_until(deadline).
+ *
+ * // Receive everything present at once (receive_many / try_receive_many write into an output iterator instead).
+ * std::vector<int> batch;
+ * receiver.drain_into(batch); // Blocking until at least one value is present.
+ * receiver.try_drain_into(batch); // Not blocking.
  *
  * // close() and closed()
  * sender.close();
@@ -41,352 +54,7718 @@
  *   // The loop will stop immedately after the sender called close().
  *   // Only sender can call close().
  * }
+ *
+ * // A receiver is an input range, so it composes with std::views; chunked() pulls batches through receive_many.
+ * for (const std::vector<int>& batch: receiver | mpsc::chunked(64)) {
+ *   // everything present when the batch was pulled, up to 64 values
+ * }
+ * @endcode
+ *
+ * Set `Policy::drain_on_close` to have the receiver get the values still in the channel when it's closed, and only
+ * then see the end of the stream.
+ *
+ * # Backends
+ *
+ * The second template argument of `make_channel` is a policy which selects the storage backend of the channel:
+ *
+ * - `mpsc::default_policy` (default): a `std::mutex` protecting a linked list of nodes. The receiver waits without
+ *   taking the mutex. Small trivially copyable values (`int`, `double`, small PODs; see `Policy::inline_size`) are
+ *   stored by value in segments of contiguous storage instead, which batches are copied in and out of in blocks.
+ * - `mpsc::lock_free_policy`: a Vyukov style MPSC node queue. Producers only do atomic operations, and the consumer
+ *   only parks (through `std::atomic::wait`) when the queue is actually empty.
+ *
+ * @code{.cpp}
+ * auto [sender, receiver] = mpsc::make_channel<int, mpsc::lock_free_policy>();
+ * @endcode
+ *
+ * With `mpsc::intrusive_policy`, a channel of `std::unique_ptr<Message>`, where `Message` derives from
+ * `mpsc::intrusive_hook`, links the messages themselves: sending allocates and copies nothing. Its deleter, if not the
+ * default one, can't have a state: only the message goes through the channel.
+ *
+ * @code{.cpp}
+ * struct Frame : mpsc::intrusive_hook { std::array<std::byte, 8192> bytes; };
+ * auto [sender, receiver] = mpsc::make_channel<std::unique_ptr<Frame>, mpsc::intrusive_policy>();
+ * sender.send(std::make_unique<Frame>());
+ * @endcode
+ *
+ * With `mpsc::priority_policy<Lanes>`, `sender.send(value, priority)` sends to one of `Lanes` lock-free lanes, from 0
+ * (what `send(value)` uses) to `Lanes - 1`, and the receiver always takes from the most urgent lane which isn't empty:
+ * urgent values don't wait behind a backlog of less urgent ones.
+ *
+ * With `mpsc::sharded_policy<Shards>`, each sender thread sends to one of `Shards` lock-free queues, picked from the
+ * CPU it first sent on, so that producers on different cores or NUMA nodes don't share cache lines. The receiver
+ * visits the shards in turn. Values sent by different threads are no longer received in the order they were sent.
+ *
+ * Node based backends allocate their nodes from `Policy::allocator` (an allocator instance can be passed to
+ * `make_channel`). Set `Policy::recycle_nodes` (as `mpsc::pooled_policy` does) to keep released nodes in a per-channel
+ * free list, so that a channel in a steady state doesn't allocate at all.
+ *
+ * A receiver of a node based backend parks as soon as the channel is empty, and senders only pay for a wakeup when
+ * it actually parked. Set `Policy::wait_strategy` to `mpsc::spin_then_park<Spins, Yields>` (as `mpsc::spinning_policy`
+ * does) to make it poll the channel first. With `mpsc::coalesce_wakeups<Items, IdleMicroseconds>` (as
+ * `mpsc::coalescing_policy` has), a parked receiver is only woken up once `Items` values wait for it, or after the
+ * idle timeout, so that bursts of sends pay for few wakeups.
+ *
+ * Use `mpsc::make_bounded_channel<T>(capacity)` to create a channel which never holds more than `capacity` values.
+ * Its `send` blocks while the channel is full, `try_send` gives the value back instead, and `send_for` / `send_until`
+ * give it back once the timeout expires.
+ *
+ * Use `mpsc::make_spsc_channel<T>(capacity)` for a channel with a single producer: a bounded channel backed by a
+ * wait-free ring, whose Sender can only be moved. It has no `reserve` nor `async_send`.
+ *
+ * Two bounded variants have Receivers which can be copied, and neither has `reserve`, `async_send`, `async_receive`
+ * nor works with `select`:
+ *
+ * - `mpsc::make_mpmc_channel<T>(capacity)`: the receivers compete for the values, each getting a share of them. Senders
+ *   and receivers only meet on the slots of a lock-free ring.
+ * - `mpsc::make_broadcast_channel<T>(capacity)`: every receiver gets each value, a copy starting where the receiver it
+ *   was copied from is. A value is stored once in a shared ring, which each receiver reads with a cursor of its own,
+ *   and senders wait while the slowest receiver is `capacity` values behind.
+ *
+ * @code{.cpp}
+ * auto [sender, receiver] = mpsc::make_broadcast_channel<Event>(256);
+ * std::jthread logger{[rx = receiver]() mutable { for (const Event& event : rx) log(event); }};
+ * @endcode
+ *
+ * On Linux, `mpsc::make_shm_channel<T>(name, capacity)` opens a channel between processes of the same host: a bounded
+ * ring in the POSIX shared memory region `name`, created by the first process opening it. Each process keeps the end it
+ * uses: any number of them send, one receives (another receiver throws at its first receive). The stream ends once every
+ * process which sent dropped its senders, and the region goes away with the last process. `T` must be trivially
+ * copyable; there is no `reserve`, `async_send`, `async_receive` nor `select`.
+ *
+ * Use `mpsc::select(receivers...)` to block until one of several receivers is ready, which returns its index:
+ *
+ * @code{.cpp}
+ * switch (mpsc::select(int_receiver, string_receiver)) {
+ *   case 0: handle(int_receiver.receive()); break;
+ *   case 1: handle(string_receiver.receive()); break;
+ * }
  * @endcode
  *
+ * On Linux, `receiver.native_handle()` is an eventfd which becomes readable when values arrive, so that an event loop
+ * can wait for the channel in the same `epoll_wait` (or io_uring submission) as for its sockets. Once it's readable,
+ * receive with `try_receive` until the channel is empty, which makes it unreadable again.
+ *
+ * In a coroutine, `co_await receiver.async_receive(executor)` suspends until something is present, and
+ * `co_await sender.async_send(value, executor)` (bounded channels only) while the channel is full. The executor is
+ * what resumes the coroutine (`mpsc::inline_executor` by default).
+ *
+ * A producer sending values one at a time can wrap its Sender in an `mpsc::BufferedSender`, which hands them over in
+ * batches of `batch_size`, or once the oldest one waited `max_delay`, paying for the lock and the wakeup once per batch:
+ *
+ * @code{.cpp}
+ * mpsc::BufferedSender buffered{sender, 64, 100us};
+ * buffered.send(1); // Buffered.
+ * buffered.flush(); // Sent.
+ * @endcode
+ *
+ * Set `Policy::collect_stats` to have the channel count what goes through it, read by `stats()` on the sender or the
+ * receiver as an `mpsc::channel_stats`. Without it, nothing is counted at all.
+ *
+ * Set `Policy::trace_latency` to have the node based backends stamp each value when it's sent, and read how long the
+ * values waited in the channel with `latencies()` on the receiver, as an `mpsc::latency_histogram`.
+ *
  * @note mpsc stands for Multi-Producer Single-Consumer. So Sender can be either
- * copied and moved, but Receiver can only be moved.
+ * copied and moved, but Receiver can only be moved (except for MPMC and broadcast channels).
  *
  * Feel free to explore the tests.cpp. The tests are also examples of the usage.
  *
  * Read the source if you need more information. Sorry for the lack of comments. ~( ̄▽ ̄)~
  */
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <concepts>
 #include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
 #include <exception>
 #include <iterator>
-#include <list>
 #include <memory>
 #include <mutex>
+#include <new>
 #include <optional>
-#include <queue>
+#include <ranges>
+#include <stdexcept>
 #include <tuple>
+#include <thread>
 #include <type_traits>
 #include <utility>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <climits>
+#include <ctime>
+#include <string>
+#include <system_error>
+#endif
 
 namespace mpsc {
 
-template <typename T>
-class Sender;
+/// Backend tag: `std::mutex` + a linked list of nodes.
+struct locked_backend {};
 
-template <typename T>
-class Receiver;
+/// Backend tag: lock-free intrusive MPSC node queue.
+struct lock_free_backend {};
 
-template <typename T>
-std::tuple<Sender<T>, Receiver<T>> make_channel();
+/// Backend tag: preallocated ring of slots with a fixed capacity.
+struct bounded_backend {};
 
-class channel_closed_exception : std::logic_error {
- public:
-  channel_closed_exception() : std::logic_error{"This channel has been closed."} {}
+/// Backend tag: wait-free single-producer ring with a fixed capacity. Its Sender can't be copied.
+struct spsc_backend {};
+
+/// Backend tag: lock-free multi-consumer ring with a fixed capacity. Its Receiver can be copied, and the copies compete
+/// for the values.
+struct mpmc_backend {};
+
+/// Backend tag: ring with a fixed capacity read by every receiver. Its Receiver can be copied, and each copy gets
+/// every value.
+struct broadcast_backend {};
+
+/// Backend tag: `Lanes` lock-free MPSC node queues, one per priority (see Sender::send(value, priority)), sharing the
+/// receiver's wakeup. The receiver takes from the most urgent lane which isn't empty.
+template <std::size_t Lanes>
+struct priority_backend {
+  static_assert(Lanes >= 1, "A priority channel has at least one lane.");
+  static constexpr std::size_t lanes = Lanes;
 };
 
-namespace detail {
-template <typename T>
-class Channel {  // Do NOT use this class directly.
- public:
-  void send(T&& value);
-  void send(const T& value);
+/// Shard selector of sharded_backend: the CPU a thread runs on when it first sends. A thread keeps it when it moves to
+/// another CPU, so its values stay in order; pin the senders to keep it their own. Not being on Linux, a hash of the
+/// thread.
+struct first_cpu {
+  std::size_t operator()() const noexcept {
+#if defined(__linux__)
+    static thread_local const std::size_t cpu = [] {
+      const int current = ::sched_getcpu();
+      return current < 0 ? std::size_t{0} : static_cast<std::size_t>(current);
+    }();
+#else
+    static thread_local const std::size_t cpu = std::hash<std::thread::id>{}(std::this_thread::get_id());
+#endif
+    return cpu;
+  }
+};
 
-  std::optional<T> receive();
-  std::optional<T> try_receive();
+/// Shard selector of sharded_backend: the NUMA node of the CPU a thread runs on when it first sends, so that the
+/// senders of a node share a shard, and those of different nodes don't. Kept like first_cpu. Not being on Linux, a hash
+/// of the thread.
+struct first_node {
+  std::size_t operator()() const noexcept {
+#if defined(__linux__)
+    static thread_local const std::size_t node = [] {
+      unsigned cpu     = 0;
+      unsigned current = 0;
+      return 0 == ::syscall(SYS_getcpu, &cpu, &current, nullptr) ? std::size_t{current} : std::size_t{0};
+    }();
+#else
+    static thread_local const std::size_t node = std::hash<std::thread::id>{}(std::this_thread::get_id());
+#endif
+    return node;
+  }
+};
 
-  void close();
+/// Backend tag: `Shards` lock-free MPSC node queues sharing the receiver's wakeup. Each sender thread sends to the
+/// shard `ShardOf{}() % Shards`. With first_cpu (the default), that's its first CPU modulo `Shards`: threads on
+/// different CPUs don't write the same queue while there are no more CPUs than shards, but CPUs `Shards` apart share
+/// one whatever their NUMA node. first_node gives a shard per node instead. Only the queues are sharded: every node
+/// comes from the one allocator of the channel (and its single free list with Policy::recycle_nodes). The receiver
+/// takes up to `fair_share` values from a shard before it moves on to the next one.
+template <std::size_t Shards, typename ShardOf = first_cpu>
+struct sharded_backend {
+  static_assert(Shards >= 1, "A sharded channel has at least one shard.");
+  static constexpr std::size_t shards     = Shards;
+  static constexpr std::size_t fair_share = 64;
+};
 
-  [[nodiscard]] bool closed() const;
+/// Backend tag: bounded ring in a named POSIX shared memory region, which processes on the same host open by name to
+/// send to a receiver in another process (see make_shm_channel). Linux only.
+struct shm_backend {};
 
-  Channel(const Channel<T>&) = delete;
-  Channel(Channel<T>&&) = delete;
-  Channel<T>& operator=(const Channel<T>&) = delete;
-  Channel<T>& operator=(Channel<T>&&) = delete;
+/// Backend tag: lock-free MPSC queue of `std::unique_ptr`s to messages deriving from intrusive_hook, linked through
+/// the hook. Sending allocates nothing.
+struct intrusive_backend {};
 
- private:
-  Channel() = default;
+/// Wait strategy: an empty channel parks the receiver right away, and the first value sent wakes it up.
+struct blocking_wait {
+  static constexpr unsigned spins  = 0;
+  static constexpr unsigned yields = 0;
 
-  std::queue<T, std::list<T>> queue;
-  mutable std::mutex mutex;
-  std::condition_variable condvar;
-  bool need_notify = false;
-  bool _closed     = false;
+  /// How many values a parked receiver lets queue up before it's woken, for at most `idle_timeout`.
+  static constexpr std::size_t notify_every = 1;
+  static constexpr std::chrono::microseconds idle_timeout{0};
+};
 
-  friend std::tuple<Sender<T>, Receiver<T>> make_channel<T>();
+/// Wait strategy: an empty channel is polled `Spins` times with a pause instruction, then `Yields` times yielding
+/// the CPU, before the receiver parks. Trades CPU time for latency when values arrive shortly after each other.
+template <unsigned Spins = 1024, unsigned Yields = 64>
+struct spin_then_park : blocking_wait {
+  static constexpr unsigned spins  = Spins;
+  static constexpr unsigned yields = Yields;
 };
-}  // namespace detail
 
-template <typename T>
-class Sender {
-    class ChannelCloser {
-        detail::Channel<T>& channel;
-    public:
-        explicit ChannelCloser(detail::Channel<T>& channel) : channel{channel} {}
-        ~ChannelCloser(){
-            if ( not channel.closed()) {
-                channel.close();
-            }
-        }
-    };
+/// Wait strategy: like `WaitStrategy`, but a receiver which parks is only woken up once `Items` values were sent, or
+/// once it slept for `IdleMicroseconds`, whichever comes first; it then takes them in one go. A channel which stays
+/// empty that long parks the receiver as `WaitStrategy` does, until the next value. Trades latency (up to the idle
+/// timeout) for throughput: sends during a burst rarely pay for a wakeup. Doesn't apply to the MPMC and broadcast
+/// backends, nor to timed receives.
+template <std::size_t Items = 64, unsigned IdleMicroseconds = 100, typename WaitStrategy = blocking_wait>
+struct coalesce_wakeups : WaitStrategy {
+  static_assert(Items >= 1, "A receiver is woken up for at least one value.");
+  static constexpr std::size_t notify_every = Items;
+  static constexpr std::chrono::microseconds idle_timeout{IdleMicroseconds};
+};
 
- public:
-  Sender<T>& send(T&& value) {
-    validate();
-    channel->send(std::move(value));
-    return *this;
-  }
+/// Policies configure a channel. Derive from one of them to override a part of it.
+struct default_policy {
+  using backend = locked_backend;
 
-  Sender<T>& send(const T& value) {
-    validate();
-    channel->send(value);
-    return *this;
-  }
+  /// What a receiver of a node based backend does before it parks on an empty channel.
+  using wait_strategy = blocking_wait;
 
-  void close() {
-    validate();
-    channel_closer.reset();
-  }
+  /// Node based backends allocate their nodes from this allocator, rebound to the node type.
+  using allocator = std::allocator<void>;
 
-  [[nodiscard]] bool closed() const {
-    validate();
-    return channel->closed();
-  }
+  /// Keep the nodes released by node based backends in a per-channel free list instead of deallocating them, so a
+  /// channel in a steady state doesn't allocate at all. The free list only shrinks when the channel is destroyed.
+  static constexpr bool recycle_nodes = false;
 
-  [[nodiscard]] explicit operator bool() const { return static_cast<bool>(channel); }
+  /// Locked backend only: a trivially copyable T of at most this many bytes isn't put in a node of its own, but stored
+  /// by value in segments of contiguous storage (also from `allocator`, and kept as nodes are with recycle_nodes),
+  /// which send_range and receive_many copy in and out of in blocks. 0 keeps a node per value whatever T.
+  static constexpr std::size_t inline_size = 16;
 
-  Sender(const Sender<T>&) = default;
-  Sender(Sender<T>&&) noexcept = default;
-  Sender<T>& operator=(const Sender<T>&) = default;
-  Sender<T>& operator=(Sender<T>&&) noexcept = default;
+  /// Once the channel is closed, the receiver still gets the values sent before, and only then sees the end of the
+  /// stream. By default it sees the end right away, and the values left are destroyed with the channel.
+  static constexpr bool drain_on_close = false;
 
- private:
-  explicit Sender(std::shared_ptr<detail::Channel<T>> channel)
-    : channel{ channel }
-    , channel_closer{std::make_shared<ChannelCloser>(*(this->channel))}
-    {};
+  /// Count the values going through the channel, how long the receiver waits, and how often it's woken up, in relaxed
+  /// atomics on a cache line of their own. See channel_stats.
+  static constexpr bool collect_stats = false;
 
-  std::shared_ptr<detail::Channel<T>> channel;
-  std::shared_ptr<ChannelCloser> channel_closer;
+  /// Node based backends only: stamp each node with the time it's sent, and count how long each value waited until it
+  /// was received in a histogram. See latency_histogram.
+  static constexpr bool trace_latency = false;
+};
 
-  void validate() const {
-    if (nullptr == channel) {
-      throw std::invalid_argument{"This sender has been moved out."};
-    }
-  }
+struct lock_free_policy : default_policy {
+  using backend = lock_free_backend;
+};
 
-  friend std::tuple<Sender<T>, Receiver<T>> make_channel<T>();
+struct bounded_policy : default_policy {
+  using backend = bounded_backend;
 };
 
-template <typename T>
-class Receiver {
- public:
-  std::optional<T> receive() {
-    validate();
-    return channel->receive();
-  }
+struct spsc_policy : default_policy {
+  using backend = spsc_backend;
+};
 
-  std::optional<T> try_receive() {
-    validate();
-    return channel->try_receive();
-  }
+struct mpmc_policy : default_policy {
+  using backend = mpmc_backend;
+};
 
-  [[nodiscard]] bool closed() const {
-    validate();
-    return channel->closed();
-  }
+struct broadcast_policy : default_policy {
+  using backend = broadcast_backend;
+};
 
-  [[nodiscard]] explicit operator bool() const { return static_cast<bool>(channel); }
+struct intrusive_policy : default_policy {
+  using backend = intrusive_backend;
+};
 
-  Receiver(Receiver<T>&&) noexcept = default;
-  Receiver<T>& operator=(Receiver<T>&&) noexcept = default;
-  Receiver(const Receiver<T>&) = delete;
-  Receiver<T>& operator=(const Receiver<T>&) = delete;
+struct shm_policy : default_policy {
+  using backend = shm_backend;
+};
 
- private:
-  explicit Receiver(std::shared_ptr<detail::Channel<T>> channel) : channel(channel){};
+template <std::size_t Lanes = 2>
+struct priority_policy : default_policy {
+  using backend = priority_backend<Lanes>;
+};
 
-  std::shared_ptr<detail::Channel<T>> channel;
+template <std::size_t Shards = 8, typename ShardOf = first_cpu>
+struct sharded_policy : default_policy {
+  using backend = sharded_backend<Shards, ShardOf>;
+};
 
-  void validate() const {
-    if (nullptr == channel) {
-      throw std::invalid_argument{"This receiver has been moved out."};
-    }
-  }
+struct pooled_policy : default_policy {
+  static constexpr bool recycle_nodes = true;
+};
 
-  friend std::tuple<Sender<T>, Receiver<T>> make_channel<T>();
+struct spinning_policy : default_policy {
+  using wait_strategy = spin_then_park<>;
+};
 
- public:
-  class iterator : public std::iterator<std::input_iterator_tag, T> {
-   private:
-    typedef std::iterator<std::input_iterator_tag, T> BaseIter;
+struct coalescing_policy : default_policy {
+  using wait_strategy = coalesce_wakeups<>;
+};
 
-   public:
-    using typename BaseIter::difference_type;
-    using typename BaseIter::iterator_category;
-    using typename BaseIter::pointer;
-    using typename BaseIter::reference;
-    using typename BaseIter::value_type;
+/// Executor of Receiver::async_receive / Sender::async_send which resumes the coroutine on the thread waking it up
+/// (the sender, respectively the receiver). An executor is any callable taking the std::coroutine_handle<> to
+/// resume, e.g. one posting it to a thread pool. It shouldn't throw.
+struct inline_executor {
+  void operator()(std::coroutine_handle<> handle) const { handle.resume(); }
+};
 
-    iterator() : receiver{ nullptr } {}
+/// What a channel whose policy sets `collect_stats` counted so far (see Receiver::stats). Counters are read one by one
+/// while the channel is in use, so they are only consistent with each other once it's quiet.
+struct channel_stats {
+  /// Values sent but not received yet, and the most there have been at once.
+  std::size_t depth;
+  std::size_t high_water_mark;
 
-    explicit iterator(Receiver<T>& receiver) : receiver{ &receiver } {
-      if (this->receiver->closed()) {
-        this->receiver = nullptr;
-      }
-      else {
-        next();
+  std::size_t sends;
+  std::size_t receives;
+
+  /// Receives which found nothing ready and had to wait, and how long they waited in total.
+  std::size_t blocked_receives;
+  std::chrono::nanoseconds wait_time;
+
+  /// Wakeups of a waiting receiver (blocked in receive, in mpsc::select, or a suspended async_receive).
+  std::size_t notifies;
+};
+
+/// How long the values received so far waited in a channel whose policy sets `trace_latency` (see
+/// Receiver::latencies), from their send to their receive, in buckets of powers of two: bucket `i` counts the
+/// latencies from 2^(i-1) up to 2^i nanoseconds. As channel_stats, it's only consistent once the channel is quiet.
+struct latency_histogram {
+  static constexpr std::size_t buckets = 64;
+
+  std::array<std::uint64_t, buckets> counts;
+
+  [[nodiscard]] std::uint64_t total() const noexcept {
+    std::uint64_t sum = 0;
+    for (const std::uint64_t count : counts) {
+      sum += count;
+    }
+    return sum;
+  }
+
+  /// The upper bound of the bucket of the `fraction` quantile, e.g. percentile(0.99) for the p99. Zero when empty.
+  [[nodiscard]] std::chrono::nanoseconds percentile(double fraction) const noexcept {
+    const auto rank    = static_cast<std::uint64_t>(fraction * static_cast<double>(total()));
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < buckets; ++bucket) {
+      seen += counts[bucket];
+      if (seen > rank or (seen == total() and seen > 0)) {
+        return std::chrono::nanoseconds{std::int64_t{1} << std::min<std::size_t>(bucket, 62)};
       }
     }
+    return std::chrono::nanoseconds{0};
+  }
+};
 
-    reference operator*() { return current.value(); }
+template <typename T, typename Policy = default_policy>
+class Sender;
 
-    pointer operator->() { return &current.value(); }
+template <typename T, typename Policy = default_policy>
+class Receiver;
 
-    iterator& operator++() {
-      next();
-      return *this;
-    }
+template <typename T, typename Policy = default_policy>
+class Reservation;
 
-    iterator operator++(int) = delete;
+template <typename T, typename Policy = default_policy>
+std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_channel(
+    const typename Policy::allocator& allocator = typename Policy::allocator{});
 
-    [[nodiscard]] bool operator==(const iterator& other) const noexcept {
-      return receiver == nullptr and other.receiver == nullptr;
-    }
+template <typename T, typename Policy = bounded_policy>
+std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_bounded_channel(std::size_t capacity);
 
-    [[nodiscard]] bool operator!=(iterator& other) const noexcept { return not (*this == other); }
+/// A bounded channel with a single producer: its Sender can only be moved.
+template <typename T, typename Policy = spsc_policy>
+std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_spsc_channel(std::size_t capacity);
 
-   private:
-    Receiver<T>* receiver;
-    std::optional<T> current = std::nullopt;
+/// A bounded channel whose Receiver can be copied, the copies competing for the values. The capacity is rounded up to
+/// a power of two, and to at least 2.
+template <typename T, typename Policy = mpmc_policy>
+std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_mpmc_channel(std::size_t capacity);
 
-    void next() {
-      if (!receiver) {
-        return;
-      }
+/// A bounded channel whose Receiver can be copied, every copy getting each value. The capacity is rounded up to a
+/// power of two.
+template <typename T, typename Policy = broadcast_policy>
+std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_broadcast_channel(std::size_t capacity);
 
-      while (true) {
-        if (receiver->closed()) {
-          receiver = nullptr;
-          current.reset();
-          return;
-        }
+#if defined(__linux__)
+/// A bounded channel in the POSIX shared memory region `name` (e.g. "/events"), created by the first process which
+/// opens it, with room for `capacity` values rounded up to a power of two (and to at least 2). Other processes open the
+/// same channel with the same name, `T` and capacity, and keep the end they use: one process receives, any number
+/// send. The first receive of a second receiver throws std::invalid_argument. `T` must be trivially copyable.
+template <typename T, typename Policy = shm_policy>
+std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_shm_channel(const std::string& name, std::size_t capacity);
+#endif
 
-        std::optional<T> tmp = receiver->receive();
-        if (not tmp.has_value()) {
-          continue;
-        }
+/// Block until one of `receivers` is ready (see Receiver::ready), and return its index. When several are ready, the
+/// first one wins. Must be called from the thread receiving from them.
+template <typename... Receivers>
+std::size_t select(Receivers&... receivers);
 
-        current.emplace(std::move(tmp.value()));
-        return;
-      }
-    }
-  };
+/// Like select, but return std::nullopt if none of `receivers` got ready before the deadline.
+template <typename Clock, typename Duration, typename... Receivers>
+std::optional<std::size_t> select_until(const std::chrono::time_point<Clock, Duration>& deadline,
+                                        Receivers&... receivers);
 
-  [[nodiscard]] iterator begin() { return iterator(*this); }
+template <typename Rep, typename Period, typename... Receivers>
+std::optional<std::size_t> select_for(const std::chrono::duration<Rep, Period>& timeout, Receivers&... receivers);
 
-  [[nodiscard]] iterator end() { return iterator(); }
+class channel_closed_exception : public std::logic_error {
+ public:
+  channel_closed_exception() : std::logic_error{"This channel has been closed."} {}
 };
 
-/* ======== Implementations ========= */
+/// What Sender::try_send(value, std::nothrow) did with the value.
+enum class send_status : unsigned char {
+  sent,
+  /// There was no room: the bounded channels are full, or the node based ones couldn't allocate a node.
+  full,
+  /// The channel is closed, or the sender is empty (moved from).
+  closed,
+  /// The value can't be sent to this channel at all: an empty std::unique_ptr to an intrusive one.
+  invalid,
+};
 
+/// The result of Sender::try_send(value, std::nothrow): the value is handed back unless it was sent.
 template <typename T>
-[[nodiscard]] std::tuple<Sender<T>, Receiver<T>> make_channel() {
-  static_assert(std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>,
-                "T should be copy-constructible or move-constructible.");
+struct send_result {
+  send_status status;
+  std::optional<T> value;
 
-  std::shared_ptr<detail::Channel<T>> channel{new detail::Channel<T>()};
-  Sender<T> sender{channel};
-  Receiver<T> receiver{channel};
-  return std::tuple<Sender<T>, Receiver<T>>{std::move(sender), std::move(receiver)};
-}
+  [[nodiscard]] explicit operator bool() const noexcept { return send_status::sent == status; }
+};
 
-template <typename T>
-void detail::Channel<T>::send(T&& value) {
-  std::unique_lock lock(mutex);
-  if (_closed) {
-    throw channel_closed_exception();
-  }
+namespace detail {
+template <typename T, typename Policy, typename Backend>
+class Channel;
+}  // namespace detail
 
-  queue.push(std::move(value));
+/// Base of the messages of an intrusive channel (see intrusive_policy), which carries their link in the queue: a
+/// channel of `std::unique_ptr<Message>` then just links the messages themselves. A message is in one channel at most.
+class intrusive_hook {
+ public:
+  intrusive_hook() noexcept = default;
 
-  if (need_notify) {
-    need_notify = false;
-    lock.unlock();
-    condvar.notify_one();
-  }
-}
+  // The link belongs to the channel the message is in, not to its value.
+  intrusive_hook(const intrusive_hook&) noexcept {}
+  intrusive_hook& operator=(const intrusive_hook&) noexcept { return *this; }
+
+ private:
+  std::atomic<intrusive_hook*> next{nullptr};
+
+  template <typename, typename, typename>
+  friend class detail::Channel;
+};
+
+namespace detail {
+// What the locked backend becomes for values it stores by value (see Policy::inline_size).
+struct segmented_backend {};
+
+template <typename T, typename Policy>
+inline constexpr bool segmented_storage = std::is_same_v<typename Policy::backend, locked_backend> and
+                                          std::is_trivially_copyable_v<T> and std::is_move_constructible_v<T> and
+                                          sizeof(T) <= Policy::inline_size and not Policy::trace_latency;
+
+template <typename T, typename Policy>
+using backend_of = std::conditional_t<segmented_storage<T, Policy>, segmented_backend, typename Policy::backend>;
+
+template <typename T, typename Policy, typename Backend = backend_of<T, Policy>>
+class Channel;
+
+template <typename T, typename Policy>
+class Subscription;
+
+// What a Receiver points to: its channel, except for a broadcast channel, where each receiver has a Subscription.
+template <typename T, typename Policy, typename Backend = typename Policy::backend>
+struct ReceiverTarget {
+  using type = Channel<T, Policy>;
+};
+
+template <typename T, typename Policy>
+struct ReceiverTarget<T, Policy, broadcast_backend> {
+  using type = Subscription<T, Policy>;
+};
+
+// Alignment keeping apart the parts of a channel written by different threads. Not
+// std::hardware_destructive_interference_size, which depends on tuning flags (GCC warns about using it in headers),
+// so the layout of a channel could differ between translation units.
+inline constexpr std::size_t cache_line_size = 64;
 
 template <typename T>
-void detail::Channel<T>::send(const T& value) {
-  std::unique_lock lock(mutex);
-  if (_closed) {
-    throw channel_closed_exception();
-  }
+struct Node {
+  std::atomic<Node*> next{nullptr};
+  union {
+    T value;
+  };
 
-  queue.push(value);
+  Node() {}
+  ~Node() {}
+};
 
-  if (need_notify) {
-    need_notify = false;
-    lock.unlock();
-    condvar.notify_one();
-  }
-}
+// What NodeAllocator allocates with Policy::trace_latency.
+template <typename T>
+struct TracedNode : Node<T> {
+  std::chrono::steady_clock::time_point sent;
+};
 
+// A singly linked chain of nodes, owned by whoever holds it.
 template <typename T>
-std::optional<T> detail::Channel<T>::receive() {
-  std::unique_lock lock(mutex);
+struct NodeChain {
+  Node<T>* first   = nullptr;
+  Node<T>* last    = nullptr;
+  std::size_t size = 0;
 
-  if (_closed) {
-    return std::nullopt;
+  [[nodiscard]] bool empty() const noexcept { return 0 == size; }
+
+  void push_back(Node<T>* node) noexcept {
+    if (empty()) {
+      first = node;
+    }
+    else {
+      last->next.store(node, std::memory_order_relaxed);
+    }
+    last = node;
+    ++size;
   }
 
-  if (queue.empty()) {
-    need_notify = true;
-    condvar.wait(lock, [this] { return not queue.empty() or _closed; });
+  void append(NodeChain& other) noexcept {
+    if (other.empty()) {
+      return;
+    }
+    if (empty()) {
+      first = other.first;
+    }
+    else {
+      last->next.store(other.first, std::memory_order_relaxed);
+    }
+    last = other.last;
+    size += other.size;
+    other = {};
   }
 
-  if (_closed) {
-    return {};
+  Node<T>* pop_front() noexcept {
+    Node<T>* node = first;
+    first         = node->next.load(std::memory_order_relaxed);
+    node->next.store(nullptr, std::memory_order_relaxed);
+    if (0 == --size) {
+      first = last = nullptr;
+    }
+    return node;
   }
+};
 
-  T result = std::move(queue.front());
-  queue.pop();
-  return {std::move(result)};
-}
+// Allocates the nodes of a channel from Policy::allocator. With Policy::recycle_nodes, released nodes are pushed on
+// a free list and handed out again instead.
+template <typename T, typename Policy>
+class NodeAllocator {
+ public:
+  using node_type = Node<T>;
 
-template <typename T>
-std::optional<T> detail::Channel<T>::try_receive() {
-  if (mutex.try_lock()) {
-    std::unique_lock lock{mutex, std::adopt_lock};
+  explicit NodeAllocator(const typename Policy::allocator& allocator) : allocator{allocator} {}
 
-    if (_closed) {
-      return {};
+  NodeAllocator(const NodeAllocator&) = delete;
+  NodeAllocator& operator=(const NodeAllocator&) = delete;
+
+  ~NodeAllocator();
+
+  // A node without a value.
+  node_type* make_empty();
+  // Or nullptr when it can't be allocated, whatever the allocator throws (not only std::bad_alloc).
+  node_type* try_make_empty() noexcept;
+
+  template <typename... Args>
+  node_type* make(Args&&... args);
+  // A node for each value of [first, last), linked in order. If a copy throws, the nodes made so far are destroyed.
+  template <typename InputIt>
+  NodeChain<T> make_chain(InputIt first, InputIt last);
+  // Construct the value of a node from make_empty(). The node is released if the constructor throws.
+  template <typename... Args>
+  node_type* construct(node_type* node, Args&&... args);
+
+  // Release a node without a value.
+  void release(node_type* node) noexcept;
+  // Release the nodes of chain, whose values have already been destroyed.
+  void release(NodeChain<T> chain) noexcept;
+
+  // Destroy the value, then release the node.
+  void destroy(node_type* node) noexcept;
+  void destroy(NodeChain<T> chain) noexcept;
+
+  // With Policy::trace_latency, when the node was sent: make() stamps it, stamp() again for a reservation. No-ops
+  // otherwise.
+  static void stamp(node_type* node) noexcept {
+    if constexpr (Policy::trace_latency) {
+      static_cast<storage_type*>(node)->sent = std::chrono::steady_clock::now();
     }
+  }
 
-    if (queue.empty()) {
+  static std::chrono::steady_clock::time_point sent(const node_type* node) noexcept {
+    if constexpr (Policy::trace_latency) {
+      return static_cast<const storage_type*>(node)->sent;
+    }
+    else {
       return {};
     }
-
-    T result = std::move(queue.front());
-    queue.pop();
-    return {std::move(result)};
   }
 
-  return {};
-}
+ private:
+  using storage_type   = std::conditional_t<Policy::trace_latency, TracedNode<T>, Node<T>>;
+  using allocator_type = typename std::allocator_traits<typename Policy::allocator>::template rebind_alloc<storage_type>;
+  using traits         = std::allocator_traits<allocator_type>;
 
-template <typename T>
-void detail::Channel<T>::close() {
-  std::unique_lock lock{mutex};
+  node_type* pop_free() noexcept;
+  void deallocate(node_type* node) noexcept;
 
-  _closed = true;
-  if (need_notify) {
-    need_notify = false;
-    lock.unlock();
-    condvar.notify_one();
-  }
-}
+  allocator_type allocator;
 
-template <typename T>
-bool detail::Channel<T>::closed() const {
-  std::unique_lock lock{mutex};
+  // Anybody pushes; only the thread holding `popping` pops, so a node can't be popped and pushed back while a pop
+  // is in progress (no ABA). A producer which finds `popping` taken allocates a new node instead of waiting.
+  alignas(cache_line_size) std::atomic<node_type*> free_list{nullptr};
+  std::atomic_flag popping;
+};
 
-  return _closed;
+template <typename Iterator>
+struct is_move_iterator : std::false_type {};
+
+template <typename Iterator>
+struct is_move_iterator<std::move_iterator<Iterator>> : std::true_type {};
+
+// Values of T which a block of them can be copied to (or from) with a single memcpy.
+template <typename Iterator, typename T>
+concept contiguous_iterator_of = std::contiguous_iterator<Iterator> and std::same_as<std::iter_value_t<Iterator>, T>;
+
+// Appends to a vector like std::back_insert_iterator, which Receiver::drain_into and chunked() use. The segmented
+// backend knows how many values a batch holds before it copies them, so it grows the vector once instead, and copies
+// into it a block at a time.
+template <typename T>
+class VectorAppender {
+ public:
+  using iterator_category = std::output_iterator_tag;
+  using value_type        = void;
+  using difference_type   = std::ptrdiff_t;
+  using pointer           = void;
+  using reference         = void;
+
+  explicit VectorAppender(std::vector<T>& values) noexcept : values{&values} {}
+
+  VectorAppender& operator=(const T& value) {
+    values->push_back(value);
+    return *this;
+  }
+
+  VectorAppender& operator=(T&& value) {
+    values->push_back(std::move(value));
+    return *this;
+  }
+
+  VectorAppender& operator*() noexcept { return *this; }
+  VectorAppender& operator++() noexcept { return *this; }
+  VectorAppender operator++(int) noexcept { return *this; }
+
+  std::vector<T>& container() const noexcept { return *values; }
+
+ private:
+  std::vector<T>* values;
+};
+
+template <typename Iterator>
+struct is_vector_appender : std::false_type {};
+
+template <typename T>
+struct is_vector_appender<VectorAppender<T>> : std::true_type {};
+
+// A queue of trivially copyable values stored by value, in segments of contiguous storage allocated from
+// Policy::allocator. A drained segment is kept for the next one needed (every one of them with Policy::recycle_nodes),
+// so a channel in a steady state doesn't allocate. Not thread safe: the segmented backend only uses it with its mutex held.
+template <typename T, typename Policy>
+class SegmentQueue {
+  static_assert(std::is_trivially_copyable_v<T>, "Values are copied in and out of segments as bytes.");
+
+ public:
+  explicit SegmentQueue(const typename Policy::allocator& allocator) : allocator{allocator} {}
+
+  SegmentQueue(const SegmentQueue&) = delete;
+  SegmentQueue& operator=(const SegmentQueue&) = delete;
+
+  ~SegmentQueue();
+
+  [[nodiscard]] std::size_t size() const noexcept { return count; }
+  [[nodiscard]] bool empty() const noexcept { return 0 == count; }
+
+  void push(const T& value);
+  // A contiguous range of T (also behind a std::move_iterator) is copied a block at a time. The values appended
+  // before an exception stay queued.
+  template <typename InputIt>
+  void append(InputIt first, InputIt last);
+
+  // Expects the queue not to be empty.
+  T pop() noexcept;
+  // Copy out up to `max` values, a block at a time into a contiguous `out`. Returns `out` past the last one.
+  template <typename OutputIt>
+  OutputIt take(OutputIt out, std::size_t max);
+
+ private:
+  struct Segment {
+    // About 1 KiB each.
+    static constexpr std::size_t capacity = std::max<std::size_t>(1, (1024 - sizeof(void*)) / sizeof(T));
+
+    // Bytes rather than an array of T: values are only ever copied in with memcpy, so T needn't be default
+    // constructible nor assignable.
+    T* values() noexcept { return std::launder(reinterpret_cast<T*>(storage)); }
+
+    Segment* next = nullptr;
+    alignas(T) std::byte storage[capacity * sizeof(T)];
+  };
+
+  using allocator_type = typename std::allocator_traits<typename Policy::allocator>::template rebind_alloc<Segment>;
+  using traits         = std::allocator_traits<allocator_type>;
+
+  // Start a new `tail`, from the spare segments if any.
+  void grow();
+  // Drop `head` once it's drained, or rewind an empty queue to the start of its segment.
+  void advance() noexcept;
+  void deallocate(Segment* segment) noexcept;
+
+  allocator_type allocator;
+
+  // The values are [first, capacity) of `head`, every value of the segments between, and [0, end) of `tail`; or
+  // [first, end) when `head` is `tail`.
+  Segment* head     = nullptr;
+  Segment* tail     = nullptr;
+  std::size_t first = 0;
+  std::size_t end   = 0;
+  std::size_t count = 0;
+
+  Segment* spares = nullptr;
+};
+
+// Pause instruction for spin loops.
+inline void cpu_relax() noexcept {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  _mm_pause();
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+  __builtin_ia32_pause();
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__aarch64__) || defined(__arm__))
+  asm volatile("yield");
+#endif
+}
+
+// Poll `ready` as WaitStrategy says before going to sleep. Return whether it became true.
+template <typename WaitStrategy, typename Ready>
+bool spin(Ready& ready) {
+  for (unsigned i = 0; i < WaitStrategy::spins; ++i) {
+    if (ready()) {
+      return true;
+    }
+    cpu_relax();
+  }
+  for (unsigned i = 0; i < WaitStrategy::yields; ++i) {
+    if (ready()) {
+      return true;
+    }
+    std::this_thread::yield();
+  }
+  return false;
+}
+
+// Parking spot of the single consumer of a channel. The consumer first polls `ready` as WaitStrategy says, then only
+// sleeps (on a futex where the platform has one) after announcing itself as parked and re-checking, so producers only
+// need a fence and a load when nobody is waiting. `std::atomic::wait` can't time out, so a consumer with a deadline
+// sleeps on a condition variable instead, and says so in `state`. So does a consumer waiting for a batch of
+// WaitStrategy::notify_every values (see coalesce_wakeups), which the producers count in `pending`.
+template <typename WaitStrategy>
+class Parker {
+ public:
+  template <typename Ready>
+  void park_until(Ready ready) {
+    if (spin<WaitStrategy>(ready)) {
+      return;
+    }
+    if constexpr (coalescing) {
+      if (wait_for_batch(ready)) {
+        return;
+      }
+    }
+    while (not ready()) {
+      state.store(parked, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (ready()) {
+        state.store(awake, std::memory_order_relaxed);
+        return;
+      }
+      state.wait(parked, std::memory_order_acquire);
+    }
+  }
+
+  // Return false if `ready` is still false at the deadline.
+  template <typename Ready, typename Clock, typename Duration>
+  bool park_until(Ready ready, const std::chrono::time_point<Clock, Duration>& deadline) {
+    if (spin<WaitStrategy>(ready)) {
+      return true;
+    }
+    std::unique_lock lock{mutex};
+    while (not ready()) {
+      state.store(parked_timed, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (ready()) {
+        break;
+      }
+      if (not condvar.wait_until(lock, deadline, [this] { return state.load(std::memory_order_acquire) != parked_timed; })) {
+        state.store(awake, std::memory_order_relaxed);
+        return ready();
+      }
+    }
+    state.store(awake, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Must be called after publishing whatever `ready` observes: `sent` values, or 0 for anything else (e.g. closing),
+  // which always wakes the consumer up. Return whether the receiver was parked and got woken up.
+  bool unpark(std::size_t sent = 0) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const std::uint32_t current = state.load(std::memory_order_relaxed);
+    if (current == awake) {
+      return false;
+    }
+    if constexpr (coalescing) {
+      if (current == batching and 0 != sent and
+          pending.fetch_add(sent, std::memory_order_relaxed) + sent < WaitStrategy::notify_every) {
+        return false;
+      }
+    }
+    switch (state.exchange(awake, std::memory_order_acq_rel)) {
+      case parked:
+        state.notify_one();
+        return true;
+      case parked_timed:
+      case batching:
+        // The consumer checks `state` with `mutex` held before sleeping.
+        { std::lock_guard lock{mutex}; }
+        condvar.notify_one();
+        return true;
+      default:
+        return false;
+    }
+  }
+
+ private:
+  static constexpr bool coalescing = WaitStrategy::notify_every > 1;
+
+  static constexpr std::uint32_t awake        = 0;
+  static constexpr std::uint32_t parked       = 1;
+  static constexpr std::uint32_t parked_timed = 2;
+  static constexpr std::uint32_t batching     = 3;
+
+  // Sleep until notify_every values were sent, or for WaitStrategy::idle_timeout. Return whether `ready`; if not, the
+  // channel is idle and the consumer parks until the next value.
+  template <typename Ready>
+  bool wait_for_batch(Ready& ready) {
+    const auto deadline = std::chrono::steady_clock::now() + WaitStrategy::idle_timeout;
+    std::unique_lock lock{mutex};
+    pending.store(0, std::memory_order_relaxed);
+    state.store(batching, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (not ready()) {
+      condvar.wait_until(lock, deadline, [this] { return state.load(std::memory_order_acquire) != batching; });
+    }
+    state.store(awake, std::memory_order_relaxed);
+    return ready();
+  }
+
+  std::atomic<std::uint32_t> state{awake};
+  std::atomic<std::size_t> pending{0};
+  std::mutex mutex;
+  std::condition_variable condvar;
+};
+
+// Where any number of threads wait for `ready`, which other threads make true. A waiter announces itself and checks
+// `ready` again with `mutex` held before sleeping, so waking them only costs a fence and a load while nobody waits.
+class WaitQueue {
+ public:
+  template <typename Ready>
+  void wait(Ready ready) {
+    std::unique_lock lock{mutex};
+    waiters.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    condvar.wait(lock, ready);
+    waiters.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  // Return false if `ready` is still false at the deadline.
+  template <typename Ready, typename Clock, typename Duration>
+  bool wait_until(Ready ready, const std::chrono::time_point<Clock, Duration>& deadline) {
+    std::unique_lock lock{mutex};
+    waiters.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const bool result = condvar.wait_until(lock, deadline, ready);
+    waiters.fetch_sub(1, std::memory_order_relaxed);
+    return result;
+  }
+
+  // Must be called after publishing whatever `ready` observes. Return whether anybody was waiting.
+  bool notify_one() {
+    if (not has_waiters()) {
+      return false;
+    }
+    { std::lock_guard lock{mutex}; }
+    condvar.notify_one();
+    return true;
+  }
+
+  bool notify_all() {
+    if (not has_waiters()) {
+      return false;
+    }
+    { std::lock_guard lock{mutex}; }
+    condvar.notify_all();
+    return true;
+  }
+
+ private:
+  bool has_waiters() noexcept {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return 0 != waiters.load(std::memory_order_relaxed);
+  }
+
+  std::atomic<std::size_t> waiters{0};
+  std::mutex mutex;
+  std::condition_variable condvar;
+};
+
+// What mpsc::select parks on, attached to each of the channels it waits for.
+using SelectWaiter = Parker<blocking_wait>;
+
+// A suspended coroutine, handed to its executor by wake().
+struct AsyncWaiter {
+  void (*resume)(AsyncWaiter&);
+
+  void wake() { resume(*this); }
+};
+
+// Where a channel tells whoever waits for it besides Channel::receive about new values: an attached SelectWaiter, an
+// armed AsyncWaiter, or (on Linux) the eventfd of Receiver::native_handle.
+//
+// Producers only take `mutex` while a SelectWaiter is attached, so detach() guarantees that nobody touches it anymore.
+// An AsyncWaiter is woken once, by whoever takes it out of `async_waiter` (which can also be disarm()).
+//
+// The eventfd is only written by whoever sets `signalled`, so once per wakeup rather than once per value. The receiver
+// clears it in rearm() when it finds the channel empty; both are read-modify-writes of `signalled`, so either the next
+// producer sees it cleared and writes, or the receiver sees that producer's value and signals itself.
+class ReceiveHook {
+ public:
+#if defined(__linux__)
+  ReceiveHook() = default;
+
+  ~ReceiveHook() {
+    if (const int fd = event_fd.load(std::memory_order_relaxed); -1 != fd) {
+      ::close(fd);
+    }
+  }
+
+  // The eventfd, created on first use. It starts readable, as values may have been sent before it existed.
+  int event_handle() {
+    std::lock_guard lock{mutex};
+    if (const int fd = event_fd.load(std::memory_order_relaxed); -1 != fd) {
+      return fd;
+    }
+
+    const int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (-1 == fd) {
+      throw std::system_error{errno, std::system_category(), "eventfd"};
+    }
+    event_fd.store(fd, std::memory_order_relaxed);
+    signal(fd);
+    return fd;
+  }
+
+  // Called by the receiver once it found the channel empty: make the eventfd unreadable again, unless `ready` says
+  // values slipped in meanwhile.
+  template <typename Ready>
+  void rearm(const Ready& ready) {
+    const int fd = event_fd.load(std::memory_order_relaxed);
+    if (-1 == fd or not signalled.load(std::memory_order_relaxed)) {
+      return;
+    }
+
+    std::uint64_t count = 0;
+    [[maybe_unused]] const ::ssize_t drained = ::read(fd, &count, sizeof(count));
+    signalled.exchange(false, std::memory_order_acq_rel);
+    if (ready()) {
+      signal(fd);
+    }
+  }
+#endif
+
+  void attach(SelectWaiter& waiter) {
+    std::lock_guard lock{mutex};
+    this->waiter = &waiter;
+    attached.store(true, std::memory_order_relaxed);
+  }
+
+  void detach() {
+    std::lock_guard lock{mutex};
+    waiter = nullptr;
+    attached.store(false, std::memory_order_relaxed);
+  }
+
+  void arm(AsyncWaiter& waiter) noexcept { async_waiter.store(&waiter, std::memory_order_release); }
+
+  // Return false if the waiter has already been taken by a producer, which wakes it.
+  bool disarm(AsyncWaiter& waiter) noexcept {
+    AsyncWaiter* expected = &waiter;
+    return async_waiter.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel);
+  }
+
+  // Must be called after publishing, and either after a seq_cst fence (as Parker::unpark has) or after releasing the
+  // mutex the receiver checks the channel with. An AsyncWaiter may resume right away on the calling thread. Return
+  // whether anybody was waiting.
+  bool notify() {
+    bool woken = false;
+    if (attached.load(std::memory_order_relaxed)) {
+      std::lock_guard lock{mutex};
+      if (nullptr != waiter) {
+        woken = waiter->unpark();
+      }
+    }
+    if (nullptr != async_waiter.load(std::memory_order_relaxed)) {
+      if (AsyncWaiter* taken = async_waiter.exchange(nullptr, std::memory_order_acq_rel); nullptr != taken) {
+        taken->wake();
+        woken = true;
+      }
+    }
+#if defined(__linux__)
+    if (const int fd = event_fd.load(std::memory_order_relaxed); -1 != fd and signal(fd)) {
+      woken = true;
+    }
+#endif
+    return woken;
+  }
+
+ private:
+#if defined(__linux__)
+  // Make the eventfd readable, unless it already is. Return whether it wrote.
+  bool signal(int fd) noexcept {
+    if (signalled.exchange(true, std::memory_order_acq_rel)) {
+      return false;
+    }
+    const std::uint64_t one = 1;
+    [[maybe_unused]] const ::ssize_t written = ::write(fd, &one, sizeof(one));
+    return true;
+  }
+#endif
+
+  std::atomic<bool> attached{false};
+  std::mutex mutex;
+  SelectWaiter* waiter = nullptr;
+  std::atomic<AsyncWaiter*> async_waiter{nullptr};
+#if defined(__linux__)
+  std::atomic<int> event_fd{-1};
+  std::atomic<bool> signalled{false};
+#endif
+};
+
+// Awaitable of Receiver::async_receive.
+template <typename Channel, typename Executor>
+class ReceiveAwaiter : AsyncWaiter {
+ public:
+  ReceiveAwaiter(Channel& channel, Executor executor)
+    : AsyncWaiter{&resume_through}, channel{channel}, executor{std::move(executor)} {}
+
+  bool await_ready() { return channel.ready(); }
+
+  bool await_suspend(std::coroutine_handle<> handle) {
+    this->handle = handle;
+    return arm();
+  }
+
+  auto await_resume() { return channel.try_receive(); }
+
+ private:
+  // Arm the hook, unless something is ready already. Returns false if the coroutine should go on right away.
+  bool arm() {
+    // Once armed, a producer may resume the coroutine (even on another thread) and destroy the awaiter at any time.
+    Channel& channel  = this->channel;
+    ReceiveHook& hook = channel.receive_hook();
+    hook.arm(*this);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return not (channel.may_be_ready() and hook.disarm(*this));
+  }
+
+  static void resume_through(AsyncWaiter& waiter) {
+    auto& self = static_cast<ReceiveAwaiter&>(waiter);
+    // The waker may come after the value which it announced has been received already: wait again then.
+    if (not self.channel.ready() and self.arm()) {
+      return;
+    }
+    // Resuming may destroy the awaiter.
+    Executor executor = std::move(self.executor);
+    executor(self.handle);
+  }
+
+  Channel& channel;
+  Executor executor;
+  std::coroutine_handle<> handle;
+};
+
+// A coroutine waiting for room in a bounded channel. The receiver moves `value` into the room it makes, then wakes it.
+template <typename T>
+struct AsyncSendWaiter : AsyncWaiter {
+  template <typename U>
+  AsyncSendWaiter(void (*resume)(AsyncWaiter&), U&& value) : AsyncWaiter{resume}, value(std::forward<U>(value)) {}
+
+  T value;
+  AsyncSendWaiter* next = nullptr;
+  bool closed           = false;
+  std::exception_ptr error;
+};
+
+// Awaitable of Sender::async_send.
+template <typename T, typename Channel, typename Executor>
+class SendAwaiter : AsyncSendWaiter<T> {
+ public:
+  template <typename U>
+  SendAwaiter(Channel& channel, U&& value, Executor executor)
+    : AsyncSendWaiter<T>{&resume_through, std::forward<U>(value)}
+    , channel{channel}
+    , executor{std::move(executor)} {}
+
+  static bool await_ready() noexcept { return false; }
+
+  bool await_suspend(std::coroutine_handle<> handle) {
+    this->handle = handle;
+    return channel.send_or_wait(*this);
+  }
+
+  void await_resume() {
+    if (this->closed) {
+      throw channel_closed_exception();
+    }
+    if (this->error) {
+      std::rethrow_exception(this->error);
+    }
+  }
+
+ private:
+  static void resume_through(AsyncWaiter& waiter) {
+    auto& self = static_cast<SendAwaiter&>(static_cast<AsyncSendWaiter<T>&>(waiter));
+    Executor executor = std::move(self.executor);
+    executor(self.handle);
+  }
+
+  Channel& channel;
+  Executor executor;
+  std::coroutine_handle<> handle;
+};
+
+// The reference counts of a channel, kept inside it so that copying a Sender is one atomic increment. `senders`
+// counts the Senders which have not been closed; the last one closes the channel. `owners` counts the Receiver,
+// each closed Sender still around, and all the other Senders together; the last one deletes the channel.
+class Ownership {
+ public:
+  Ownership() noexcept = default;
+  // An owner of its own, without senders: a Subscription of a broadcast channel.
+  explicit Ownership(std::size_t owners) noexcept : owners{owners} {}
+
+  void add_sender() noexcept { senders.fetch_add(1, std::memory_order_relaxed); }
+  // Return whether that was the last sender.
+  [[nodiscard]] bool remove_sender() noexcept { return 1 == senders.fetch_sub(1, std::memory_order_acq_rel); }
+
+  void add_owner() noexcept { owners.fetch_add(1, std::memory_order_relaxed); }
+  // Return whether that was the last owner.
+  [[nodiscard]] bool release() noexcept { return 1 == owners.fetch_sub(1, std::memory_order_acq_rel); }
+
+ private:
+  std::atomic<std::size_t> senders{1};
+  std::atomic<std::size_t> owners{2};
+};
+
+// The counters behind channel_stats (see Policy::collect_stats). This one counts nothing, and takes no room with
+// [[no_unique_address]].
+template <bool Enabled>
+class Stats {
+ public:
+  void sent(std::size_t) noexcept {}
+  void received(std::size_t) noexcept {}
+  void notified() noexcept {}
+
+  // Run `block`, which returns once `ready` (or on a timeout); counted as a blocked receive unless `ready` already is.
+  template <typename Ready, typename Block>
+  decltype(auto) wait(Ready&&, Block&& block) {
+    return block();
+  }
+};
+
+template <>
+class alignas(cache_line_size) Stats<true> {
+ public:
+  // Expects the values not to be visible to the receiver yet, so that `receives` can't overtake `sends`.
+  void sent(std::size_t count) noexcept {
+    const std::size_t total    = sends.fetch_add(count, std::memory_order_relaxed) + count;
+    const std::size_t received = receives.load(std::memory_order_relaxed);
+    const std::size_t depth    = total > received ? total - received : 0;
+    for (std::size_t mark = high_water_mark.load(std::memory_order_relaxed);
+         depth > mark and not high_water_mark.compare_exchange_weak(mark, depth, std::memory_order_relaxed);) {
+    }
+  }
+
+  void received(std::size_t count) noexcept { receives.fetch_add(count, std::memory_order_relaxed); }
+
+  void notified() noexcept { notifies.fetch_add(1, std::memory_order_relaxed); }
+
+  template <typename Ready, typename Block>
+  decltype(auto) wait(Ready&& ready, Block&& block) {
+    if (ready()) {
+      return block();
+    }
+    const Timer timer{*this};
+    return block();
+  }
+
+  [[nodiscard]] channel_stats snapshot() const noexcept {
+    const std::size_t received = receives.load(std::memory_order_relaxed);
+    const std::size_t total    = sends.load(std::memory_order_relaxed);
+    return {
+        total > received ? total - received : 0,
+        high_water_mark.load(std::memory_order_relaxed),
+        total,
+        received,
+        blocked_receives.load(std::memory_order_relaxed),
+        std::chrono::nanoseconds{wait_nanoseconds.load(std::memory_order_relaxed)},
+        notifies.load(std::memory_order_relaxed),
+    };
+  }
+
+ private:
+  // Counts a blocked receive, for as long as it's in scope.
+  class Timer {
+   public:
+    explicit Timer(Stats& stats) noexcept : stats{stats} {}
+
+    ~Timer() {
+      const auto waited = std::chrono::steady_clock::now() - start;
+      stats.blocked_receives.fetch_add(1, std::memory_order_relaxed);
+      stats.wait_nanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count(),
+                                       std::memory_order_relaxed);
+    }
+
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+   private:
+    Stats& stats;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  };
+
+  std::atomic<std::size_t> sends{0};
+  std::atomic<std::size_t> receives{0};
+  std::atomic<std::size_t> high_water_mark{0};
+  std::atomic<std::size_t> blocked_receives{0};
+  std::atomic<std::int64_t> wait_nanoseconds{0};
+  std::atomic<std::size_t> notifies{0};
+};
+
+// The histogram behind latency_histogram (see Policy::trace_latency), fed by the receiver with the time each node it
+// takes was sent (see NodeAllocator::sent). This one records nothing, doesn't even read the clock, and takes no room
+// with [[no_unique_address]].
+template <bool Enabled>
+class Latencies {
+ public:
+  struct time_point {};
+
+  static time_point now() noexcept { return {}; }
+
+  void record(std::chrono::steady_clock::time_point, time_point) noexcept {}
+};
+
+template <>
+class alignas(cache_line_size) Latencies<true> {
+ public:
+  using time_point = std::chrono::steady_clock::time_point;
+
+  static time_point now() noexcept { return std::chrono::steady_clock::now(); }
+
+  // Only the receiver records, so the buckets don't need a read-modify-write; the relaxed atomics only let anybody
+  // take a snapshot meanwhile.
+  void record(time_point sent, time_point received) noexcept {
+    const auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(received - sent).count();
+    const auto bucket = std::min<std::size_t>(std::bit_width(static_cast<std::uint64_t>(std::max<std::int64_t>(waited, 0))),
+                                              latency_histogram::buckets - 1);
+    counts[bucket].store(counts[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] latency_histogram snapshot() const noexcept {
+    latency_histogram histogram{};
+    for (std::size_t bucket = 0; bucket < latency_histogram::buckets; ++bucket) {
+      histogram.counts[bucket] = counts[bucket].load(std::memory_order_relaxed);
+    }
+    return histogram;
+  }
+
+ private:
+  std::array<std::atomic<std::uint64_t>, latency_histogram::buckets> counts{};
+};
+
+// Dmitry Vyukov's MPSC node queue: the lock-free backend, and each lane (shard) of the priority (sharded) backend.
+// Producers exchange `head` and link the previous node to theirs; the receiver owns `tail`, which always points at an
+// already consumed (stub) node. The nodes come from the NodeAllocator of the backend, which is passed in.
+template <typename T, typename Policy>
+class NodeQueue {
+ public:
+  NodeQueue() = default;
+
+  NodeQueue(const NodeQueue&) = delete;
+  NodeQueue& operator=(const NodeQueue&) = delete;
+
+  // Start with `stub`, a node without a value.
+  void init(Node<T>* stub) noexcept;
+  // Destroy the values left and release the stub. A queue which wasn't init() has nothing to clear.
+  void clear(NodeAllocator<T, Policy>& nodes) noexcept;
+
+  // Publish the already linked nodes of `chain` with a single exchange.
+  void link(NodeChain<T> chain) noexcept;
+  // std::nullopt when empty, or while a producer is between its exchange and its link.
+  std::optional<T> pop(NodeAllocator<T, Policy>& nodes, Latencies<Policy::trace_latency>& latency);
+
+  // When nothing is linked behind `tail` but a producer already exchanged `head`, wait for its link. Returns false
+  // if the queue is really empty.
+  bool await_link() const noexcept;
+
+  // Whether a value is linked.
+  [[nodiscard]] bool ready() const noexcept {
+    return nullptr != tail.load(std::memory_order_relaxed)->next.load(std::memory_order_acquire);
+  }
+
+  // Like ready(), but it may run while the receiver does (it's stale then): compares `head` and `tail` only.
+  [[nodiscard]] bool may_be_ready() const noexcept {
+    return head.load(std::memory_order_acquire) != tail.load(std::memory_order_relaxed);
+  }
+
+ private:
+  // Each on a line of its own. `tail` is only atomic for may_be_ready().
+  alignas(cache_line_size) std::atomic<Node<T>*> head{nullptr};
+  alignas(cache_line_size) std::atomic<Node<T>*> tail{nullptr};
+};
+
+// The blocking receives of the backends whose receiver polls the queue, then parks until ready(): the lock-free,
+// SPSC, intrusive, priority, sharded and shm ones. Each befriends this and gives it exhausted(), pop(),
+// pop_many(out, max) and both wait_ready() overloads.
+struct PollingReceive {
+  template <typename Channel>
+  static auto one(Channel& channel) -> decltype(channel.pop()) {
+    while (not channel.exhausted()) {
+      if (auto result = channel.pop(); result.has_value()) {
+        return result;
+      }
+
+      channel.wait_ready();
+    }
+
+    return std::nullopt;
+  }
+
+  template <typename Channel, typename Clock, typename Duration>
+  static auto one_until(Channel& channel, const std::chrono::time_point<Clock, Duration>& deadline)
+      -> decltype(channel.pop()) {
+    while (not channel.exhausted()) {
+      if (auto result = channel.pop(); result.has_value()) {
+        return result;
+      }
+
+      if (not channel.wait_ready(deadline)) {
+        break;
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  template <typename Channel, typename OutputIt>
+  static std::size_t many(Channel& channel, OutputIt out, std::size_t max) {
+    if (0 == max) {
+      return 0;
+    }
+
+    while (not channel.exhausted()) {
+      if (const auto received = channel.pop_many(out, max); received > 0) {
+        return received;
+      }
+
+      channel.wait_ready();
+    }
+
+    return 0;
+  }
+};
+
+// Run `send`, then `commit`, also when `send` throws: every batch send which fails part of the way sends what it
+// placed before the exception.
+template <typename Send, typename Commit>
+void send_then_commit(Send&& send, Commit&& commit) {
+  try {
+    send();
+  }
+  catch (...) {
+    commit();
+    throw;
+  }
+  commit();
+}
+
+// Lets mpsc::select reach the channel of a receiver.
+struct SelectAccess {
+  template <typename T, typename Policy>
+  static Channel<T, Policy>& channel(Receiver<T, Policy>& receiver) {
+    receiver.validate();
+    return *receiver.channel;
+  }
+};
+
+template <typename T, typename Policy>
+class Channel<T, Policy, locked_backend> {  // Do NOT use this class directly.
+ public:
+  void send(T&& value);
+  void send(const T& value);
+
+  // The node is allocated and the value constructed before taking the lock.
+  template <typename... Args>
+  void emplace(Args&&... args);
+
+  // Don't throw on a closed channel: `value` is only used when it's sent, and full means no node could be allocated.
+  template <typename U>
+  send_status try_send(U&& value, std::nothrow_t);
+
+  // Enqueue a whole batch with at most one wakeup of the receiver.
+  template <typename InputIt>
+  void send_range(InputIt first, InputIt last);
+
+  // A reservation is a node which isn't queued yet.
+  using reservation_type = Node<T>*;
+
+  template <typename... Args>
+  reservation_type reserve(Args&&... args) {
+    return nodes.make(std::forward<Args>(args)...);
+  }
+  static T& reserved_value(reservation_type reservation) noexcept { return reservation->value; }
+  void commit(reservation_type reservation);
+  void discard(reservation_type reservation) noexcept { nodes.destroy(reservation); }
+
+  std::optional<T> receive();
+  std::optional<T> try_receive();
+  // Return std::nullopt if nothing arrived before the deadline.
+  template <typename Clock, typename Duration>
+  std::optional<T> receive_until(const std::chrono::time_point<Clock, Duration>& deadline);
+
+  // Receive up to `max` values into `out`; return how many were received.
+  template <typename OutputIt>
+  std::size_t receive_many(OutputIt out, std::size_t max);
+  template <typename OutputIt>
+  std::size_t try_receive_many(OutputIt out, std::size_t max);
+
+  void close();
+
+  [[nodiscard]] bool closed() const;
+
+  // Whether receive() would return right away: something is present, or the stream ended.
+  [[nodiscard]] bool ready() const noexcept {
+    return 0 != queued.load(std::memory_order_relaxed) or _closed.load(std::memory_order_relaxed);
+  }
+
+  // Like ready(), but it may run while the receiver does.
+  [[nodiscard]] bool may_be_ready() const noexcept { return ready(); }
+
+  ReceiveHook& receive_hook() noexcept { return hook; }
+  Ownership& ownership() noexcept { return owners; }
+  [[nodiscard]] channel_stats stats() const noexcept { return counters.snapshot(); }
+  [[nodiscard]] latency_histogram latencies() const noexcept { return latency.snapshot(); }
+
+  Channel(const Channel&) = delete;
+  Channel(Channel&&) = delete;
+  Channel& operator=(const Channel&) = delete;
+  Channel& operator=(Channel&&) = delete;
+
+  ~Channel();
+
+ private:
+  explicit Channel(const typename Policy::allocator& allocator) : nodes{allocator} {}
+
+  // Append `chain` to the queue and wake the receiver if it waits. Destroys the chain and throws if closed.
+  void enqueue(NodeChain<T> chain);
+
+  // Park until the queue isn't empty or the channel is closed (or the deadline). Returns false on timeout.
+  void wait_ready();
+  template <typename Clock, typename Duration>
+  bool wait_ready(const std::chrono::time_point<Clock, Duration>& deadline);
+
+  // Wake whoever waits for the channel, `sent` values having been published (0 for anything else, see Parker::unpark).
+  // Called after releasing `mutex`.
+  void wake_receiver(std::size_t sent = 0);
+
+  // Receive the first value, unless the channel is closed or empty.
+  std::optional<T> pop_ready();
+
+  // Closed, and the values still queued are dropped (see Policy::drain_on_close).
+  bool discarding() const noexcept { return not Policy::drain_on_close and _closed.load(std::memory_order_acquire); }
+
+  // Expects `mutex` to be held. Unlinks the first `max` nodes of the queue.
+  NodeChain<T> take(std::size_t max);
+
+  // Move the values of `chain` to `out` and release its nodes. Returns how many values there were. When `out` (or the
+  // move of a value) throws, what wasn't delivered goes back to the front of the queue.
+  template <typename OutputIt>
+  std::size_t consume(NodeChain<T> chain, OutputIt out);
+  void requeue(NodeChain<T> chain);
+
+  NodeAllocator<T, Policy> nodes;
+
+  // Written by the producers and the receiver, with `mutex` held.
+  alignas(cache_line_size) mutable std::mutex mutex;
+  NodeChain<T> queue;
+  // Also written with `mutex` held, so the receiver can wait for it (or poll an empty channel) without taking it.
+  std::atomic<std::size_t> queued{0};
+
+  // Read by every send, but only written by close() and by a receiver going to sleep.
+  alignas(cache_line_size) std::atomic<bool> _closed{false};
+  Parker<typename Policy::wait_strategy> parker;
+  ReceiveHook hook;
+
+  // Written by every copy of a Sender.
+  alignas(cache_line_size) Ownership owners;
+  [[no_unique_address]] Stats<Policy::collect_stats> counters;
+  [[no_unique_address]] Latencies<Policy::trace_latency> latency;
+
+  friend std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_channel<T, Policy>(const typename Policy::allocator&);
+};
+
+// The locked backend for small trivially copyable values (see Policy::inline_size): the same mutex and the same waits, but the
+// values are copied into segments of contiguous storage under the lock instead of being linked as nodes.
+template <typename T, typename Policy>
+class Channel<T, Policy, segmented_backend> {  // Do NOT use this class directly.
+ public:
+  void send(T&& value) { send(static_cast<const T&>(value)); }
+  void send(const T& value);
+
+  template <typename... Args>
+  void emplace(Args&&... args) {
+    send(T(std::forward<Args>(args)...));
+  }
+
+  // Don't throw on a closed channel, and full means no segment could be allocated.
+  template <typename U>
+  send_status try_send(U&& value, std::nothrow_t);
+
+  // Copy a whole batch in with at most one wakeup of the receiver.
+  template <typename InputIt>
+  void send_range(InputIt first, InputIt last);
+
+  // A reservation is the value itself, copied in when it's committed.
+  using reservation_type = T;
+
+  template <typename... Args>
+  reservation_type reserve(Args&&... args) {
+    return T(std::forward<Args>(args)...);
+  }
+  static T& reserved_value(reservation_type& reservation) noexcept { return reservation; }
+  void commit(const reservation_type& reservation) { send(reservation); }
+  void discard(const reservation_type&) noexcept {}
+
+  std::optional<T> receive();
+  std::optional<T> try_receive();
+  // Return std::nullopt if nothing arrived before the deadline.
+  template <typename Clock, typename Duration>
+  std::optional<T> receive_until(const std::chrono::time_point<Clock, Duration>& deadline);
+
+  // Receive up to `max` values into `out`; return how many were received.
+  template <typename OutputIt>
+  std::size_t receive_many(OutputIt out, std::size_t max);
+  template <typename OutputIt>
+  std::size_t try_receive_many(OutputIt out, std::size_t max);
+
+  void close();
+
+  [[nodiscard]] bool closed() const;
+
+  // Whether receive() would return right away: something is present, or the stream ended.
+  [[nodiscard]] bool ready() const noexcept {
+    return 0 != queued.load(std::memory_order_relaxed) or _closed.load(std::memory_order_relaxed);
+  }
+
+  // Like ready(), but it may run while the receiver does.
+  [[nodiscard]] bool may_be_ready() const noexcept { return ready(); }
+
+  ReceiveHook& receive_hook() noexcept { return hook; }
+  Ownership& ownership() noexcept { return owners; }
+  [[nodiscard]] channel_stats stats() const noexcept { return counters.snapshot(); }
+
+  Channel(const Channel&) = delete;
+  Channel(Channel&&) = delete;
+  Channel& operator=(const Channel&) = delete;
+  Channel& operator=(Channel&&) = delete;
+
+  ~Channel() = default;
+
+ private:
+  explicit Channel(const typename Policy::allocator& allocator) : queue{allocator} {}
+
+  // Account for the `sent` values just queued, release `lock` and wake the receiver if it waits.
+  void publish(std::unique_lock<std::mutex>& lock, std::size_t sent);
+
+  // Park until the queue isn't empty or the channel is closed (or the deadline). Returns false on timeout.
+  void wait_ready();
+  template <typename Clock, typename Duration>
+  bool wait_ready(const std::chrono::time_point<Clock, Duration>& deadline);
+
+  // Wake whoever waits for the channel, `sent` values having been published (0 for anything else, see Parker::unpark).
+  // Called after releasing `mutex`.
+  void wake_receiver(std::size_t sent = 0);
+
+  // Receive the first value, unless the channel is closed or empty.
+  std::optional<T> pop_ready();
+
+  // Closed, and the values still queued are dropped (see Policy::drain_on_close).
+  bool discarding() const noexcept { return not Policy::drain_on_close and _closed.load(std::memory_order_acquire); }
+
+  // Expects `mutex` to be held. Copies the first `max` values of the queue out to `out`, which a VectorAppender
+  // grows first.
+  template <typename OutputIt>
+  std::size_t take(OutputIt out, std::size_t max);
+
+  // Written by the producers and the receiver, with `mutex` held.
+  alignas(cache_line_size) mutable std::mutex mutex;
+  SegmentQueue<T, Policy> queue;
+  // Also written with `mutex` held, so the receiver can wait for it (or poll an empty channel) without taking it.
+  std::atomic<std::size_t> queued{0};
+
+  // Read by every send, but only written by close() and by a receiver going to sleep.
+  alignas(cache_line_size) std::atomic<bool> _closed{false};
+  Parker<typename Policy::wait_strategy> parker;
+  ReceiveHook hook;
+
+  // Written by every copy of a Sender.
+  alignas(cache_line_size) Ownership owners;
+  [[no_unique_address]] Stats<Policy::collect_stats> counters;
+
+  friend std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_channel<T, Policy>(const typename Policy::allocator&);
+};
+
+template <typename T, typename Policy>
+class Channel<T, Policy, lock_free_backend> {  // Do NOT use this class directly.
+ public:
+  void send(T&& value);
+  void send(const T& value);
+
+  template <typename... Args>
+  void emplace(Args&&... args);
+
+  // Don't throw on a closed channel: `value` is only used when it's sent, and full means no node could be allocated.
+  template <typename U>
+  send_status try_send(U&& value, std::nothrow_t);
+
+  // Enqueue a whole batch with at most one wakeup of the receiver.
+  template <typename InputIt>
+  void send_range(InputIt first, InputIt last);
+
+  // A reservation is a node which isn't linked yet.
+  using reservation_type = Node<T>*;
+
+  template <typename... Args>
+  reservation_type reserve(Args&&... args);
+  static T& reserved_value(reservation_type reservation) noexcept { return reservation->value; }
+  void commit(reservation_type reservation);
+  void discard(reservation_type reservation) noexcept { nodes.destroy(reservation); }
+
+  std::optional<T> receive();
+  std::optional<T> try_receive();
+  // Return std::nullopt if nothing arrived before the deadline.
+  template <typename Clock, typename Duration>
+  std::optional<T> receive_until(const std::chrono::time_point<Clock, Duration>& deadline);
+
+  // Receive up to `max` values into `out`; return how many were received.
+  template <typename OutputIt>
+  std::size_t receive_many(OutputIt out, std::size_t max);
+  template <typename OutputIt>
+  std::size_t try_receive_many(OutputIt out, std::size_t max);
+
+  void close();
+
+  [[nodiscard]] bool closed() const;
+
+  // Whether receive() would return right away: something is present, or the stream ended.
+  [[nodiscard]] bool ready() const noexcept { return queue.ready() or _closed.load(std::memory_order_acquire); }
+
+  // Like ready(), but it may run while the receiver does (it's stale then).
+  [[nodiscard]] bool may_be_ready() const noexcept {
+    return queue.may_be_ready() or _closed.load(std::memory_order_acquire);
+  }
+
+  ReceiveHook& receive_hook() noexcept { return hook; }
+  Ownership& ownership() noexcept { return owners; }
+  [[nodiscard]] channel_stats stats() const noexcept { return counters.snapshot(); }
+  [[nodiscard]] latency_histogram latencies() const noexcept { return latency.snapshot(); }
+
+  Channel(const Channel&) = delete;
+  Channel(Channel&&) = delete;
+  Channel& operator=(const Channel&) = delete;
+  Channel& operator=(Channel&&) = delete;
+
+  ~Channel();
+
+ private:
+  explicit Channel(const typename Policy::allocator& allocator) : nodes{allocator} {
+    queue.init(nodes.make_empty());
+  }
+
+  // Publish the already linked nodes of `chain` with a single exchange.
+  void link(NodeChain<T> chain);
+  void wake_receiver(std::size_t sent = 0);
+
+  // Park until ready() (or the deadline). Returns false on timeout.
+  void wait_ready();
+  template <typename Clock, typename Duration>
+  bool wait_ready(const std::chrono::time_point<Clock, Duration>& deadline);
+  template <typename... Args>
+  void push(Args&&... args);
+  std::optional<T> pop();
+  template <typename OutputIt>
+  std::size_t pop_many(OutputIt out, std::size_t max);
+
+  // The receiver is at the end of the stream (see Policy::drain_on_close).
+  bool exhausted() noexcept {
+    return _closed.load(std::memory_order_acquire) and (not Policy::drain_on_close or not queue.await_link());
+  }
+
+  NodeAllocator<T, Policy> nodes;
+  NodeQueue<T, Policy> queue;
+
+  // Read by every send, but only written by close() and by a receiver going to sleep.
+  alignas(cache_line_size) std::atomic<bool> _closed{false};
+  Parker<typename Policy::wait_strategy> parker;
+  ReceiveHook hook;
+
+  // Written by every copy of a Sender.
+  alignas(cache_line_size) Ownership owners;
+  [[no_unique_address]] Stats<Policy::collect_stats> counters;
+  [[no_unique_address]] Latencies<Policy::trace_latency> latency;
+
+  friend std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_channel<T, Policy>(const typename Policy::allocator&);
+  friend struct PollingReceive;
+};
+
+template <typename T, typename Policy>
+class Channel<T, Policy, bounded_backend> {  // Do NOT use this class directly.
+ public:
+  // Block while the channel is full.
+  void send(T&& value);
+  void send(const T& value);
+  template <typename... Args>
+  void emplace(Args&&... args);
+  template <typename InputIt>
+  void send_range(InputIt first, InputIt last);
+
+  // A reservation is the position of a slot taken out of the free space. The receiver stops in front of it until
+  // it's committed (or discarded), so reservations should be short-lived.
+  using reservation_type = std::size_t;
+
+  template <typename... Args>
+  reservation_type reserve(Args&&... args);
+  T& reserved_value(reservation_type position) noexcept { return slots[position & mask].value; }
+  void commit(reservation_type position);
+  void discard(reservation_type position);
+
+  // Return the value back when the channel is still full (after the deadline).
+  std::optional<T> try_send(T&& value);
+  std::optional<T> try_send(const T& value);
+  // Neither wait nor throw on a closed channel: `value` is only used when it's sent.
+  template <typename U>
+  send_status try_send(U&& value, std::nothrow_t);
+
+  template <typename Clock, typename Duration>
+  std::optional<T> send_until(T&& value, const std::chrono::time_point<Clock, Duration>& deadline);
+  template <typename Clock, typename Duration>
+  std::optional<T> send_until(const T& value, const std::chrono::time_point<Clock, Duration>& deadline);
+
+  // Send the value of `waiter` right away and return false, or queue it until there is room and return true.
+  bool send_or_wait(AsyncSendWaiter<T>& waiter);
+
+  std::optional<T> receive();
+  std::optional<T> try_receive();
+  // Return std::nullopt if nothing arrived before the deadline.
+  template <typename Clock, typename Duration>
+  std::optional<T> receive_until(const std::chrono::time_point<Clock, Duration>& deadline);
+
+  // Receive up to `max` values into `out`; return how many were received.
+  template <typename OutputIt>
+  std::size_t receive_many(OutputIt out, std::size_t max);
+  template <typename OutputIt>
+  std::size_t try_receive_many(OutputIt out, std::size_t max);
+
+  void close();
+
+  [[nodiscard]] bool closed() const;
+
+  [[nodiscard]] std::size_t capacity() const noexcept { return _capacity; }
+
+  // Whether receive() would return right away: something is ready, or the stream ended.
+  [[nodiscard]] bool ready();
+
+  // Like ready(), but it may run while the receiver does.
+  [[nodiscard]] bool may_be_ready() { return ready(); }
+
+  ReceiveHook& receive_hook() noexcept { return hook; }
+  Ownership& ownership() noexcept { return owners; }
+  [[nodiscard]] channel_stats stats() const noexcept { return counters.snapshot(); }
+
+  Channel(const Channel&) = delete;
+  Channel(Channel&&) = delete;
+  Channel& operator=(const Channel&) = delete;
+  Channel& operator=(Channel&&) = delete;
+
+  ~Channel();
+
+ private:
+  enum class SlotState : unsigned char { ready, reserved, discarded };
+
+  struct Slot {
+    union {
+      T value;
+    };
+    SlotState state = SlotState::ready;
+
+    Slot() {}
+    ~Slot() {}
+  };
+
+  explicit Channel(std::size_t capacity);
+
+  static std::size_t ring_size(std::size_t capacity);
+
+  [[nodiscard]] bool full() const noexcept { return count == _capacity; }
+
+  // Expects `mutex` to be held. Reclaims discarded slots in front of the ring, then tells whether its first slot can
+  // be received.
+  bool front_ready() noexcept;
+
+  // Expects `mutex` to be held. Returns false once the channel is closed.
+  bool wait_for_room(std::unique_lock<std::mutex>& lock);
+
+  // Expects `mutex` to be held. The receiver is at the end of the stream (see Policy::drain_on_close).
+  bool finished() noexcept { return _closed and (not Policy::drain_on_close or not front_ready()); }
+
+  // All expect `mutex` to be held, and there to be room (respectively something ready) in the ring.
+  template <typename... Args>
+  void place(Args&&... args);
+  template <typename U>
+  void push(std::unique_lock<std::mutex>& lock, U&& value);
+  void notify_receiver(std::unique_lock<std::mutex>& lock);
+  T pop(std::unique_lock<std::mutex>& lock);
+  template <typename OutputIt>
+  std::size_t pop_many(std::unique_lock<std::mutex>& lock, OutputIt out, std::size_t max);
+
+  // Expect `mutex` to be held, and nothing to be ready. Wait until something is, or the channel is closed (or the
+  // deadline). Returns false on timeout.
+  void wait_ready(std::unique_lock<std::mutex>& lock);
+  template <typename Clock, typename Duration>
+  bool wait_ready(std::unique_lock<std::mutex>& lock, const std::chrono::time_point<Clock, Duration>& deadline);
+
+  // Called after releasing `mutex`.
+  void notify_hook();
+
+  // Expects `mutex` to be held. Moves the values of waiting coroutines into the room there is, and returns those
+  // coroutines, to be woken once `mutex` is released.
+  AsyncSendWaiter<T>* admit_async_senders() noexcept;
+  static void wake(AsyncSendWaiter<T>* waiters);
+
+  // Slots are allocated once; `mask` maps the ever-increasing positions onto them.
+  std::unique_ptr<Slot[]> slots;
+  std::size_t mask;
+  std::size_t _capacity;
+  std::size_t first = 0;
+  std::size_t count = 0;
+
+  mutable std::mutex mutex;
+  std::condition_variable not_empty;
+  std::condition_variable not_full;
+  std::size_t waiting_senders = 0;
+  bool need_notify            = false;
+  // How many values the waiting receiver lets queue up before it's woken (see coalesce_wakeups).
+  std::size_t wake_after = 1;
+  bool _closed           = false;
+
+  // Coroutines waiting for room, in order.
+  AsyncSendWaiter<T>* async_senders      = nullptr;
+  AsyncSendWaiter<T>* async_senders_last = nullptr;
+
+  // Everything above is guarded by `mutex`; the hook is checked by every send after releasing it.
+  alignas(cache_line_size) ReceiveHook hook;
+
+  // Written by every copy of a Sender.
+  alignas(cache_line_size) Ownership owners;
+  [[no_unique_address]] Stats<Policy::collect_stats> counters;
+
+  friend std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_bounded_channel<T, Policy>(std::size_t);
+};
+
+// A ring of `capacity` slots between a single producer and the receiver. Each owns its position and publishes it
+// with a release store; each keeps a cached copy of the other's, so it only reads the other's cache line when the
+// ring looks full (respectively empty). try_send and try_receive are wait-free.
+template <typename T, typename Policy>
+class Channel<T, Policy, spsc_backend> {  // Do NOT use this class directly.
+ public:
+  void send(T&& value);
+  void send(const T& value);
+
+  template <typename... Args>
+  void emplace(Args&&... args);
+
+  // Publishes as many values at once as there is room for, so the receiver is woken at most once per ring's worth.
+  template <typename InputIt>
+  void send_range(InputIt first, InputIt last);
+
+  // Return the value back when the channel is still full (after the deadline).
+  std::optional<T> try_send(T&& value);
+  std::optional<T> try_send(const T& value);
+  // Neither wait nor throw on a closed channel: `value` is only used when it's sent.
+  template <typename U>
+  send_status try_send(U&& value, std::nothrow_t);
+
+  template <typename Clock, typename Duration>
+  std::optional<T> send_until(T&& value, const std::chrono::time_point<Clock, Duration>& deadline);
+  template <typename Clock, typename Duration>
+  std::optional<T> send_until(const T& value, const std::chrono::time_point<Clock, Duration>& deadline);
+
+  std::optional<T> receive();
+  std::optional<T> try_receive();
+  // Return std::nullopt if nothing arrived before the deadline.
+  template <typename Clock, typename Duration>
+  std::optional<T> receive_until(const std::chrono::time_point<Clock, Duration>& deadline);
+
+  // Receive up to `max` values into `out`; return how many were received.
+  template <typename OutputIt>
+  std::size_t receive_many(OutputIt out, std::size_t max);
+  template <typename OutputIt>
+  std::size_t try_receive_many(OutputIt out, std::size_t max);
+
+  void close();
+
+  [[nodiscard]] bool closed() const;
+
+  [[nodiscard]] std::size_t capacity() const noexcept { return _capacity; }
+
+  // Whether receive() would return right away: something is present, or the stream ended.
+  [[nodiscard]] bool ready() const noexcept {
+    return head.load(std::memory_order_relaxed) != tail.load(std::memory_order_acquire) or
+           _closed.load(std::memory_order_relaxed);
+  }
+
+  // Like ready(), but it may run while the receiver does.
+  [[nodiscard]] bool may_be_ready() const noexcept { return ready(); }
+
+  ReceiveHook& receive_hook() noexcept { return hook; }
+  Ownership& ownership() noexcept { return owners; }
+  [[nodiscard]] channel_stats stats() const noexcept { return counters.snapshot(); }
+
+  Channel(const Channel&) = delete;
+  Channel(Channel&&) = delete;
+  Channel& operator=(const Channel&) = delete;
+  Channel& operator=(Channel&&) = delete;
+
+  ~Channel();
+
+ private:
+  struct Slot {
+    union {
+      T value;
+    };
+
+    Slot() {}
+    ~Slot() {}
+  };
+
+  explicit Channel(std::size_t capacity);
+
+  // Producer side. Wait until the slot at `position` is free; return false once the channel is closed. The timed
+  // one also returns when the channel is closed, and false on timeout.
+  bool wait_for_room(std::size_t position);
+  template <typename Clock, typename Duration>
+  bool wait_for_room(std::size_t position, const std::chrono::time_point<Clock, Duration>& deadline);
+  bool has_room(std::size_t position) noexcept;
+  template <typename... Args>
+  void place(std::size_t position, Args&&... args);
+  // Hand the values placed before `position` over to the receiver.
+  void publish(std::size_t position);
+  void wake_receiver(std::size_t sent = 0);
+
+  // Receiver side.
+  bool front_ready() noexcept;
+  // The receiver is at the end of the stream (see Policy::drain_on_close).
+  bool exhausted() noexcept {
+    return _closed.load(std::memory_order_acquire) and (not Policy::drain_on_close or not front_ready());
+  }
+  void wait_ready();
+  template <typename Clock, typename Duration>
+  bool wait_ready(const std::chrono::time_point<Clock, Duration>& deadline);
+  std::optional<T> pop();
+  // Stops at the value whose move to `out` throws, which stays queued like the ones after it.
+  template <typename OutputIt>
+  std::size_t pop_many(OutputIt out, std::size_t max);
+  // Hand the slots before `position`, whose values are gone, back to the producer.
+  void release(std::size_t position);
+
+  std::unique_ptr<Slot[]> slots;
+  std::size_t mask;
+  std::size_t _capacity;
+
+  // Written by the producer: the position of the next value, and what it last saw of `head`.
+  alignas(cache_line_size) std::atomic<std::size_t> tail{0};
+  std::size_t cached_head = 0;
+
+  // Written by the receiver: the position of the next value to receive, and what it last saw of `tail`.
+  alignas(cache_line_size) std::atomic<std::size_t> head{0};
+  std::size_t cached_tail = 0;
+
+  // Read by both, but only written by close() and by a side going to sleep.
+  alignas(cache_line_size) std::atomic<bool> _closed{false};
+  Parker<typename Policy::wait_strategy> receiver_parker;
+  Parker<typename Policy::wait_strategy> sender_parker;
+  ReceiveHook hook;
+
+  alignas(cache_line_size) Ownership owners;
+  [[no_unique_address]] Stats<Policy::collect_stats> counters;
+
+  friend std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_bounded_channel<T, Policy>(std::size_t);
+  friend struct PollingReceive;
+};
+
+// A ring of cells, each with a sequence number telling whose turn it is (Dmitry Vyukov's bounded MPMC queue).
+// Senders claim a position with a CAS on `enqueue_position`, receivers with a CAS on `dequeue_position`, so they only
+// meet on the cells themselves. Whoever waits for the other side sleeps in a WaitQueue.
+template <typename T, typename Policy>
+class Channel<T, Policy, mpmc_backend> {  // Do NOT use this class directly.
+ public:
+  void send(T&& value);
+  void send(const T& value);
+
+  template <typename... Args>
+  void emplace(Args&&... args);
+
+  // A forward range claims a run of the free cells with a single CAS, as many as it has values for. Each value is
+  // published as soon as it's constructed, as receivers take them one by one anyway.
+  template <typename InputIt>
+  void send_range(InputIt first, InputIt last);
+
+  // Return the value back when the channel is still full (after the deadline).
+  std::optional<T> try_send(T&& value);
+  std::optional<T> try_send(const T& value);
+  // Neither wait nor throw on a closed channel: `value` is only used when it's sent.
+  template <typename U>
+  send_status try_send(U&& value, std::nothrow_t);
+
+  template <typename Clock, typename Duration>
+  std::optional<T> send_until(T&& value, const std::chrono::time_point<Clock, Duration>& deadline);
+  template <typename Clock, typename Duration>
+  std::optional<T> send_until(const T& value, const std::chrono::time_point<Clock, Duration>& deadline);
+
+  std::optional<T> receive();
+  std::optional<T> try_receive();
+  // Return std::nullopt if nothing arrived before the deadline.
+  template <typename Clock, typename Duration>
+  std::optional<T> receive_until(const std::chrono::time_point<Clock, Duration>& deadline);
+
+  // Receive up to `max` values into `out`; return how many were received.
+  template <typename OutputIt>
+  std::size_t receive_many(OutputIt out, std::size_t max);
+  template <typename OutputIt>
+  std::size_t try_receive_many(OutputIt out, std::size_t max);
+
+  void close();
+
+  [[nodiscard]] bool closed() const;
+
+  [[nodiscard]] std::size_t capacity() const noexcept { return mask + 1; }
+
+  // Whether receive() would return right away, unless another receiver is faster.
+  [[nodiscard]] bool ready() const noexcept { return front_ready() or _closed.load(std::memory_order_acquire); }
+
+  Ownership& ownership() noexcept { return owners; }
+  [[nodiscard]] channel_stats stats() const noexcept { return counters.snapshot(); }
+
+  // Another receiver, competing with this one.
+  Channel* share() noexcept {
+    owners.add_owner();
+    return this;
+  }
+
+  Channel(const Channel&) = delete;
+  Channel(Channel&&) = delete;
+  Channel& operator=(const Channel&) = delete;
+  Channel& operator=(Channel&&) = delete;
+
+  ~Channel();
+
+ private:
+  struct Cell {
+    // `position` when free for the sender of `position`, `position + 1` once filled for its receiver.
+    std::atomic<std::size_t> sequence;
+    // False for a cell left without a value by a throwing constructor, which receivers skip.
+    bool filled;
+    union {
+      T value;
+    };
+
+    Cell() {}
+    ~Cell() {}
+  };
+
+  explicit Channel(std::size_t capacity);
+
+  // Producer side. Claim a cell and construct the value in it; return false (leaving `args` alone) when full.
+  template <typename... Args>
+  bool try_push(Args&&... args);
+  // Claim up to `max` consecutive free cells, from `position` on, with a single CAS. Return how many (0 when full).
+  std::size_t try_claim(std::size_t max, std::size_t& position) noexcept;
+  // Construct the value of the claimed cell at `position` and publish it. A constructor which throws leaves it
+  // empty, and publishes it all the same.
+  template <typename... Args>
+  void fill(std::size_t position, Args&&... args);
+  // Publish a claimed cell without a value.
+  void abandon(std::size_t position) noexcept;
+  [[nodiscard]] bool has_room() const noexcept;
+  // Block until there is room. Return false if the channel is closed (or the deadline passes) first.
+  bool wait_for_room();
+  template <typename Clock, typename Duration>
+  bool wait_for_room(const std::chrono::time_point<Clock, Duration>& deadline);
+
+  // Receiver side.
+  [[nodiscard]] bool front_ready() const noexcept;
+  // The receivers are at the end of the stream (see Policy::drain_on_close).
+  bool exhausted() const noexcept {
+    return _closed.load(std::memory_order_acquire) and (not Policy::drain_on_close or not front_ready());
+  }
+  void wait_ready();
+  template <typename Clock, typename Duration>
+  bool wait_ready(const std::chrono::time_point<Clock, Duration>& deadline);
+  std::optional<T> pop();
+  template <typename OutputIt>
+  std::size_t pop_many(OutputIt out, std::size_t max);
+  // A waiter which got what it waited for wakes the next one if there is more, as a wakeup can go to a waiter which
+  // finds nothing: another receiver (sender) was faster, or the cell at its position isn't published yet.
+  void pass_on_receivers();
+  void pass_on_senders();
+
+  std::unique_ptr<Cell[]> cells;
+  std::size_t mask;
+
+  alignas(cache_line_size) std::atomic<std::size_t> enqueue_position{0};
+  alignas(cache_line_size) std::atomic<std::size_t> dequeue_position{0};
+
+  // Read by both sides, but only written by close() and by a side going to sleep.
+  alignas(cache_line_size) std::atomic<bool> _closed{false};
+  WaitQueue receivers;
+  WaitQueue senders;
+
+  alignas(cache_line_size) Ownership owners;
+  [[no_unique_address]] Stats<Policy::collect_stats> counters;
+
+  friend std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_bounded_channel<T, Policy>(std::size_t);
+};
+
+// A ring which every receiver reads as a whole, each with a cursor of its own (a Subscription). A slot is only written
+// again once every cursor has passed it, so a value is stored once however many receivers there are. Senders take
+// turns on `mutex`; receivers only take it to subscribe, to unsubscribe, or to wake a sender waiting for room.
+template <typename T, typename Policy>
+class Channel<T, Policy, broadcast_backend> {  // Do NOT use this class directly.
+ public:
+  void send(T&& value);
+  void send(const T& value);
+
+  template <typename... Args>
+  void emplace(Args&&... args);
+
+  // Publishes as many values at once as there is room for, so the receivers are woken at most once per ring's worth.
+  template <typename InputIt>
+  void send_range(InputIt first, InputIt last);
+
+  // Return the value back when the channel is still full (after the deadline).
+  std::optional<T> try_send(T&& value);
+  std::optional<T> try_send(const T& value);
+  // Neither wait nor throw on a closed channel: `value` is only used when it's sent.
+  template <typename U>
+  send_status try_send(U&& value, std::nothrow_t);
+
+  template <typename Clock, typename Duration>
+  std::optional<T> send_until(T&& value, const std::chrono::time_point<Clock, Duration>& deadline);
+  template <typename Clock, typename Duration>
+  std::optional<T> send_until(const T& value, const std::chrono::time_point<Clock, Duration>& deadline);
+
+  void close();
+
+  [[nodiscard]] bool closed() const;
+
+  [[nodiscard]] std::size_t capacity() const noexcept { return mask + 1; }
+
+  Ownership& ownership() noexcept { return owners; }
+
+  Channel(const Channel&) = delete;
+  Channel(Channel&&) = delete;
+  Channel& operator=(const Channel&) = delete;
+  Channel& operator=(Channel&&) = delete;
+
+  ~Channel();
+
+ private:
+  struct Slot {
+    union {
+      T value;
+    };
+
+    Slot() {}
+    ~Slot() {}
+  };
+
+  // Comes with its first subscription, counted among its owners (see Ownership).
+  explicit Channel(std::size_t capacity);
+
+  // With `mutex` held. Whether the slot of `position` has been read by every subscription.
+  bool has_room(std::size_t position);
+  // With `mutex` held. Wait until the slot at `tail` is free, and return that position; throw once the channel is
+  // closed. Other senders may go first while it waits. The timed one returns std::nullopt on timeout.
+  std::size_t wait_for_room(std::unique_lock<std::mutex>& lock);
+  template <typename Clock, typename Duration>
+  std::optional<std::size_t> wait_for_room(std::unique_lock<std::mutex>& lock,
+                                           const std::chrono::time_point<Clock, Duration>& deadline);
+  // With `mutex` held. Destroy the value the slot of `position` held before, if any, and construct the new one.
+  template <typename... Args>
+  void place(std::size_t position, Args&&... args);
+  // Hand the values placed before `position` over to the receivers, and release `mutex`.
+  void publish(std::unique_lock<std::mutex>& lock, std::size_t position);
+
+  // Called by the subscriptions.
+  Subscription<T, Policy>* subscribe(std::size_t cursor);
+  void unsubscribe(Subscription<T, Policy>& subscription) noexcept;
+  void advanced();
+
+  std::unique_ptr<Slot[]> slots;
+  std::size_t mask;
+
+  // Senders only.
+  std::mutex mutex;
+  std::condition_variable room;
+  // The first position which still holds a value, and one no cursor is behind.
+  std::size_t oldest  = 0;
+  std::size_t slowest = 0;
+  std::vector<Subscription<T, Policy>*> subscriptions;
+
+  alignas(cache_line_size) std::atomic<std::size_t> tail{0};
+
+  // Read by both sides, but only written by close() and by a side going to sleep.
+  alignas(cache_line_size) std::atomic<bool> _closed{false};
+  std::atomic<std::size_t> waiting_senders{0};
+  WaitQueue receivers;
+
+  alignas(cache_line_size) Ownership owners;
+
+  friend class Subscription<T, Policy>;
+  friend std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_broadcast_channel<T, Policy>(std::size_t);
+};
+
+// A receiver of a broadcast channel: its cursor in the ring. Receiving copies the values out of the ring, which
+// senders only overwrite once the cursor has passed them.
+template <typename T, typename Policy>
+class Subscription {  // Do NOT use this class directly.
+ public:
+  std::optional<T> receive();
+  std::optional<T> try_receive();
+  // Return std::nullopt if nothing arrived before the deadline.
+  template <typename Clock, typename Duration>
+  std::optional<T> receive_until(const std::chrono::time_point<Clock, Duration>& deadline);
+
+  // Receive up to `max` values into `out`; return how many were received.
+  template <typename OutputIt>
+  std::size_t receive_many(OutputIt out, std::size_t max);
+  template <typename OutputIt>
+  std::size_t try_receive_many(OutputIt out, std::size_t max);
+
+  [[nodiscard]] bool closed() const { return channel.closed(); }
+
+  // Whether receive() would return right away: something is present, or the stream ended.
+  [[nodiscard]] bool ready() const noexcept {
+    return front_ready() or channel._closed.load(std::memory_order_acquire);
+  }
+
+  Ownership& ownership() noexcept { return owners; }
+
+  // Another subscription, which gets what this one hasn't received yet, and everything sent from now on.
+  Subscription* share() { return channel.subscribe(cursor.load(std::memory_order_relaxed)); }
+
+  Subscription(const Subscription&) = delete;
+  Subscription(Subscription&&) = delete;
+  Subscription& operator=(const Subscription&) = delete;
+  Subscription& operator=(Subscription&&) = delete;
+
+  ~Subscription();
+
+ private:
+  using channel_type = Channel<T, Policy, broadcast_backend>;
+
+  Subscription(channel_type& channel, std::size_t cursor) noexcept : channel{channel}, cursor{cursor} {}
+
+  [[nodiscard]] bool front_ready() const noexcept {
+    return cursor.load(std::memory_order_relaxed) != channel.tail.load(std::memory_order_acquire);
+  }
+  // The receiver is at the end of the stream (see Policy::drain_on_close).
+  bool exhausted() const noexcept {
+    return channel._closed.load(std::memory_order_acquire) and (not Policy::drain_on_close or not front_ready());
+  }
+  void wait_ready();
+  template <typename Clock, typename Duration>
+  bool wait_ready(const std::chrono::time_point<Clock, Duration>& deadline);
+  std::optional<T> pop();
+  template <typename OutputIt>
+  std::size_t pop_many(OutputIt out, std::size_t max);
+
+  channel_type& channel;
+  // Only written by the receiver; read by senders when the ring looks full.
+  alignas(cache_line_size) std::atomic<std::size_t> cursor;
+  Ownership owners{1};
+
+  friend channel_type;
+};
+
+template <typename T>
+struct is_unique_ptr : std::false_type {};
+
+template <typename Message, typename Deleter>
+struct is_unique_ptr<std::unique_ptr<Message, Deleter>> : std::true_type {};
+
+// Dmitry Vyukov's intrusive MPSC queue: the lock-free backend, without nodes. Producers exchange `head` and link the
+// previous message to theirs; the receiver follows the links from `tail`. As the last message can't stay behind to
+// mark the end once received (its owner may delete it), the channel's own `stub` takes its place.
+template <typename T, typename Policy>
+class Channel<T, Policy, intrusive_backend> {  // Do NOT use this class directly.
+  static_assert(is_unique_ptr<T>::value, "An intrusive channel sends std::unique_ptrs to its messages.");
+  using message_type = typename T::element_type;
+  static_assert(std::is_base_of_v<intrusive_hook, message_type>, "The messages should derive from intrusive_hook.");
+  // Only the message is linked, so the std::unique_ptr is rebuilt around it with a default constructed deleter.
+  static_assert(std::is_empty_v<typename T::deleter_type> and std::is_default_constructible_v<typename T::deleter_type>,
+                "The deleter of the messages can't have a state: it isn't sent along with them.");
+
+ public:
+  void send(T&& value);
+
+  // Construct the std::unique_ptr itself from `args`.
+  template <typename... Args>
+  void emplace(Args&&... args);
+
+  // Don't throw on a closed channel: `value` is only used when it's sent.
+  template <typename U>
+  send_status try_send(U&& value, std::nothrow_t);
+
+  // Enqueue a whole batch with at most one wakeup of the receiver. Takes move iterators, as what it sends can't be
+  // copied.
+  template <typename InputIt>
+  void send_range(InputIt first, InputIt last);
+
+  std::optional<T> receive();
+  std::optional<T> try_receive();
+  // Return std::nullopt if nothing arrived before the deadline.
+  template <typename Clock, typename Duration>
+  std::optional<T> receive_until(const std::chrono::time_point<Clock, Duration>& deadline);
+
+  // Receive up to `max` values into `out`; return how many were received.
+  template <typename OutputIt>
+  std::size_t receive_many(OutputIt out, std::size_t max);
+  template <typename OutputIt>
+  std::size_t try_receive_many(OutputIt out, std::size_t max);
+
+  void close();
+
+  [[nodiscard]] bool closed() const;
+
+  // Whether receive() would return right away: something is present, or the stream ended.
+  [[nodiscard]] bool ready() const noexcept {
+    const intrusive_hook* const last = tail.load(std::memory_order_relaxed);
+    return nullptr != last->next.load(std::memory_order_acquire) or
+           (&stub != last and head.load(std::memory_order_acquire) == last) or _closed.load(std::memory_order_acquire);
+  }
+
+  // Like ready(), but it may run while the receiver does (it's stale then).
+  [[nodiscard]] bool may_be_ready() const noexcept {
+    return &stub != head.load(std::memory_order_acquire) or &stub != tail.load(std::memory_order_relaxed) or
+           _closed.load(std::memory_order_acquire);
+  }
+
+  ReceiveHook& receive_hook() noexcept { return hook; }
+  Ownership& ownership() noexcept { return owners; }
+  [[nodiscard]] channel_stats stats() const noexcept { return counters.snapshot(); }
+
+  Channel(const Channel&) = delete;
+  Channel(Channel&&) = delete;
+  Channel& operator=(const Channel&) = delete;
+  Channel& operator=(Channel&&) = delete;
+
+  ~Channel();
+
+ private:
+  // Messages aren't allocated by the channel.
+  explicit Channel(const typename Policy::allocator&) noexcept {}
+
+  // Take the message out of `value`, which must not be empty.
+  static intrusive_hook* release(T&& value);
+
+  // Publish the messages from `first` to `last`, already linked to each other, with a single exchange.
+  void link(intrusive_hook* first, intrusive_hook* last, std::size_t count);
+  void append(intrusive_hook* first, intrusive_hook* last) noexcept;
+  void wake_receiver(std::size_t sent = 0);
+
+  // Park until ready() (or the deadline). Returns false on timeout.
+  void wait_ready();
+  template <typename Clock, typename Duration>
+  bool wait_ready(const std::chrono::time_point<Clock, Duration>& deadline);
+  std::optional<T> pop();
+  template <typename OutputIt>
+  std::size_t pop_many(OutputIt out, std::size_t max);
+
+  // When the receiver can't go on because a producer exchanged `head` but didn't link its message yet, wait for the
+  // link. Returns false if the queue is really empty.
+  bool await_link() noexcept;
+
+  // The receiver is at the end of the stream (see Policy::drain_on_close).
+  bool exhausted() noexcept {
+    return _closed.load(std::memory_order_acquire) and (not Policy::drain_on_close or not await_link());
+  }
+
+  // Producers exchange `head`. The receiver owns `tail`, which is the next message to receive unless it's `stub`;
+  // it's only atomic for may_be_ready(). Each is on a line of its own.
+  alignas(cache_line_size) std::atomic<intrusive_hook*> head{&stub};
+  alignas(cache_line_size) std::atomic<intrusive_hook*> tail{&stub};
+  intrusive_hook stub;
+
+  // Read by every send, but only written by close() and by a receiver going to sleep.
+  alignas(cache_line_size) std::atomic<bool> _closed{false};
+  Parker<typename Policy::wait_strategy> parker;
+  ReceiveHook hook;
+
+  // Written by every copy of a Sender.
+  alignas(cache_line_size) Ownership owners;
+  [[no_unique_address]] Stats<Policy::collect_stats> counters;
+
+  friend std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_channel<T, Policy>(const typename Policy::allocator&);
+  friend struct PollingReceive;
+};
+
+// One lock-free node queue per priority, as the lock-free backend has one, behind a single Parker and ReceiveHook.
+template <typename T, typename Policy, std::size_t Lanes>
+class Channel<T, Policy, priority_backend<Lanes>> {  // Do NOT use this class directly.
+ public:
+  // To the least urgent lane.
+  void send(T&& value) { send(std::move(value), 0); }
+  void send(const T& value) { send(value, 0); }
+
+  void send(T&& value, std::size_t priority);
+  void send(const T& value, std::size_t priority);
+
+  template <typename... Args>
+  void emplace(Args&&... args);
+
+  // Don't throw on a closed channel: `value` is only used when it's sent to the least urgent lane, and full means
+  // no node could be allocated.
+  template <typename U>
+  send_status try_send(U&& value, std::nothrow_t);
+
+  // Enqueue a whole batch to the least urgent lane, with at most one wakeup of the receiver.
+  template <typename InputIt>
+  void send_range(InputIt first, InputIt last);
+
+  std::optional<T> receive();
+  std::optional<T> try_receive();
+  // Return std::nullopt if nothing arrived before the deadline.
+  template <typename Clock, typename Duration>
+  std::optional<T> receive_until(const std::chrono::time_point<Clock, Duration>& deadline);
+
+  // Receive up to `max` values into `out`, the most urgent first; return how many were received.
+  template <typename OutputIt>
+  std::size_t receive_many(OutputIt out, std::size_t max);
+  template <typename OutputIt>
+  std::size_t try_receive_many(OutputIt out, std::size_t max);
+
+  void close();
+
+  [[nodiscard]] bool closed() const;
+
+  // Whether receive() would return right away: something is present, or the stream ended.
+  [[nodiscard]] bool ready() const noexcept {
+    return std::any_of(lanes.begin(), lanes.end(), [](const Lane& lane) { return lane.ready(); }) or
+           _closed.load(std::memory_order_acquire);
+  }
+
+  // Like ready(), but it may run while the receiver does (it's stale then).
+  [[nodiscard]] bool may_be_ready() const noexcept {
+    return std::any_of(lanes.begin(), lanes.end(), [](const Lane& lane) { return lane.may_be_ready(); }) or
+           _closed.load(std::memory_order_acquire);
+  }
+
+  ReceiveHook& receive_hook() noexcept { return hook; }
+  Ownership& ownership() noexcept { return owners; }
+  [[nodiscard]] channel_stats stats() const noexcept { return counters.snapshot(); }
+  [[nodiscard]] latency_histogram latencies() const noexcept { return latency.snapshot(); }
+
+  Channel(const Channel&) = delete;
+  Channel(Channel&&) = delete;
+  Channel& operator=(const Channel&) = delete;
+  Channel& operator=(Channel&&) = delete;
+
+  ~Channel();
+
+ private:
+  using Lane = NodeQueue<T, Policy>;
+
+  explicit Channel(const typename Policy::allocator& allocator);
+
+  Lane& lane(std::size_t priority);
+
+  template <typename... Args>
+  void push(Lane& lane, Args&&... args);
+  // Publish the already linked nodes of `chain` to `lane` with a single exchange.
+  void link(Lane& lane, NodeChain<T> chain);
+  void wake_receiver(std::size_t sent = 0);
+
+  // Park until ready() (or the deadline). Returns false on timeout.
+  void wait_ready();
+  template <typename Clock, typename Duration>
+  bool wait_ready(const std::chrono::time_point<Clock, Duration>& deadline);
+  std::optional<T> pop(Lane& lane);
+  // From the most urgent lane which has something.
+  std::optional<T> pop();
+  template <typename OutputIt>
+  std::size_t pop_many(OutputIt out, std::size_t max);
+
+  // When all the lanes look empty but a producer already exchanged the `head` of one, wait for its link. Returns
+  // false if the channel is really empty.
+  bool await_link() noexcept;
+
+  // The receiver is at the end of the stream (see Policy::drain_on_close).
+  bool exhausted() noexcept {
+    return _closed.load(std::memory_order_acquire) and (not Policy::drain_on_close or not await_link());
+  }
+
+  NodeAllocator<T, Policy> nodes;
+
+  // The most urgent last.
+  std::array<Lane, Lanes> lanes;
+
+  // Read by every send, but only written by close() and by a receiver going to sleep.
+  alignas(cache_line_size) std::atomic<bool> _closed{false};
+  Parker<typename Policy::wait_strategy> parker;
+  ReceiveHook hook;
+
+  // Written by every copy of a Sender.
+  alignas(cache_line_size) Ownership owners;
+  [[no_unique_address]] Stats<Policy::collect_stats> counters;
+  [[no_unique_address]] Latencies<Policy::trace_latency> latency;
+
+  friend std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_channel<T, Policy>(const typename Policy::allocator&);
+  friend struct PollingReceive;
+};
+
+// One lock-free node queue per shard, as the priority backend has one per lane, behind a single Parker and
+// ReceiveHook. The receiver visits the shards round-robin.
+template <typename T, typename Policy, std::size_t Shards, typename ShardOf>
+class Channel<T, Policy, sharded_backend<Shards, ShardOf>> {  // Do NOT use this class directly.
+ public:
+  // To the shard of the calling thread.
+  void send(T&& value) { push(shard(), std::move(value)); }
+  void send(const T& value) { push(shard(), value); }
+
+  template <typename... Args>
+  void emplace(Args&&... args) {
+    push(shard(), std::forward<Args>(args)...);
+  }
+
+  // Don't throw on a closed channel: `value` is only used when it's sent, and full means no node could be allocated.
+  template <typename U>
+  send_status try_send(U&& value, std::nothrow_t);
+
+  // Enqueue a whole batch to the shard of the calling thread, with at most one wakeup of the receiver.
+  template <typename InputIt>
+  void send_range(InputIt first, InputIt last);
+
+  std::optional<T> receive();
+  std::optional<T> try_receive();
+  // Return std::nullopt if nothing arrived before the deadline.
+  template <typename Clock, typename Duration>
+  std::optional<T> receive_until(const std::chrono::time_point<Clock, Duration>& deadline);
+
+  // Receive up to `max` values into `out`; return how many were received.
+  template <typename OutputIt>
+  std::size_t receive_many(OutputIt out, std::size_t max);
+  template <typename OutputIt>
+  std::size_t try_receive_many(OutputIt out, std::size_t max);
+
+  void close();
+
+  [[nodiscard]] bool closed() const;
+
+  // Whether receive() would return right away: something is present, or the stream ended.
+  [[nodiscard]] bool ready() const noexcept {
+    return std::any_of(shards.begin(), shards.end(), [](const Shard& shard) { return shard.ready(); }) or
+           _closed.load(std::memory_order_acquire);
+  }
+
+  // Like ready(), but it may run while the receiver does (it's stale then).
+  [[nodiscard]] bool may_be_ready() const noexcept {
+    return std::any_of(shards.begin(), shards.end(), [](const Shard& shard) { return shard.may_be_ready(); }) or
+           _closed.load(std::memory_order_acquire);
+  }
+
+  ReceiveHook& receive_hook() noexcept { return hook; }
+  Ownership& ownership() noexcept { return owners; }
+  [[nodiscard]] channel_stats stats() const noexcept { return counters.snapshot(); }
+  [[nodiscard]] latency_histogram latencies() const noexcept { return latency.snapshot(); }
+
+  Channel(const Channel&) = delete;
+  Channel(Channel&&) = delete;
+  Channel& operator=(const Channel&) = delete;
+  Channel& operator=(Channel&&) = delete;
+
+  ~Channel();
+
+ private:
+  using Shard = NodeQueue<T, Policy>;
+
+  static constexpr std::size_t fair_share = sharded_backend<Shards, ShardOf>::fair_share;
+
+  explicit Channel(const typename Policy::allocator& allocator);
+
+  Shard& shard() noexcept { return shards[ShardOf{}() % Shards]; }
+
+  template <typename... Args>
+  void push(Shard& shard, Args&&... args);
+  // Publish the already linked nodes of `chain` to `shard` with a single exchange.
+  void link(Shard& shard, NodeChain<T> chain);
+  void wake_receiver(std::size_t sent = 0);
+
+  // Park until ready() (or the deadline). Returns false on timeout.
+  void wait_ready();
+  template <typename Clock, typename Duration>
+  bool wait_ready(const std::chrono::time_point<Clock, Duration>& deadline);
+  std::optional<T> pop(Shard& shard);
+  // From the current shard, or the next one which has something.
+  std::optional<T> pop();
+  template <typename OutputIt>
+  std::size_t pop_many(OutputIt out, std::size_t max);
+  // Move on to the next shard.
+  void next_shard() noexcept;
+
+  // When all the shards look empty but a producer already exchanged the `head` of one, wait for its link. Returns
+  // false if the channel is really empty.
+  bool await_link() noexcept;
+
+  // The receiver is at the end of the stream (see Policy::drain_on_close).
+  bool exhausted() noexcept {
+    return _closed.load(std::memory_order_acquire) and (not Policy::drain_on_close or not await_link());
+  }
+
+  NodeAllocator<T, Policy> nodes;
+
+  std::array<Shard, Shards> shards;
+
+  // Owned by the receiver: the shard it takes from, and how many values it took from it in a row.
+  std::size_t current = 0;
+  std::size_t taken   = 0;
+
+  // Read by every send, but only written by close() and by a receiver going to sleep.
+  alignas(cache_line_size) std::atomic<bool> _closed{false};
+  Parker<typename Policy::wait_strategy> parker;
+  ReceiveHook hook;
+
+  // Written by every copy of a Sender.
+  alignas(cache_line_size) Ownership owners;
+  [[no_unique_address]] Stats<Policy::collect_stats> counters;
+  [[no_unique_address]] Latencies<Policy::trace_latency> latency;
+
+  friend std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_channel<T, Policy>(const typename Policy::allocator&);
+  friend struct PollingReceive;
+};
+#if defined(__linux__)
+// Futexes which work across processes; std::atomic::wait uses private ones. A null `timeout` waits without one.
+inline void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected, const timespec* timeout = nullptr) noexcept {
+  static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t));
+  ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT, expected, timeout, nullptr, 0);
+}
+
+inline void futex_wake(std::atomic<std::uint32_t>& word, int count) noexcept {
+  ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE, count, nullptr, nullptr, 0);
+}
+
+// Sleep on `word` while it holds `expected`, at most until `deadline`. Return false once the deadline has passed.
+template <typename Clock, typename Duration>
+bool futex_wait_until(std::atomic<std::uint32_t>& word,
+                      std::uint32_t expected,
+                      const std::chrono::time_point<Clock, Duration>& deadline) noexcept {
+  const auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - Clock::now()).count();
+  if (left <= 0) {
+    return false;
+  }
+  const timespec timeout{static_cast<std::time_t>(left / 1'000'000'000), static_cast<long>(left % 1'000'000'000)};
+  futex_wait(word, expected, &timeout);
+  return true;
+}
+
+// What the processes of a shared memory channel share: this header, then the cells of a bounded MPSC ring (the one
+// of the MPMC backend, with a single receiver). Everything in it is either plain data written before `initialized`,
+// or an address-free atomic.
+template <typename T>
+struct alignas(cache_line_size) ShmRing {
+  struct Cell {
+    std::atomic<std::size_t> sequence;
+    union {
+      T value;
+    };
+
+    Cell() {}
+  };
+
+  static constexpr std::uint64_t magic_number = 0x6d7073632d73686dULL;  // "mpsc-shm"
+
+  static std::size_t size(std::size_t mask) noexcept { return sizeof(ShmRing) + (mask + 1) * sizeof(Cell); }
+  Cell* cells() noexcept { return reinterpret_cast<Cell*>(this + 1); }
+
+  // Written once by the process which created the region; the others wait for `initialized`, then check them.
+  std::uint64_t magic  = magic_number;
+  std::size_t value_size = sizeof(T);
+  std::size_t mask;
+  std::atomic<std::uint32_t> initialized{0};
+
+  // How many processes have the region mapped, and how many of them send: the stream ends when the last sender
+  // leaves, the name is removed when the last process does.
+  std::atomic<std::uint32_t> attached{0};
+  std::atomic<std::uint32_t> senders{0};
+  std::atomic<std::uint32_t> closed{0};
+  // Claimed by the first receive of a process, until the channel of that process is gone.
+  std::atomic<std::uint32_t> receiving{0};
+
+  alignas(cache_line_size) std::atomic<std::size_t> enqueue_position{0};
+  alignas(cache_line_size) std::atomic<std::size_t> dequeue_position{0};
+
+  // Futex words: the receiver's parking state, and a counter of the room the receiver made while senders waited.
+  alignas(cache_line_size) std::atomic<std::uint32_t> receiver_state{0};
+  alignas(cache_line_size) std::atomic<std::uint32_t> room{0};
+  std::atomic<std::uint32_t> waiting_senders{0};
+
+  explicit ShmRing(std::size_t mask) : mask{mask} {}
+};
+
+// The view of a process on a shared memory channel; the state itself lives in the mapped ShmRing. Its Sender and
+// Receiver count as everywhere else, but only for this process: the process counts among the senders of the ring from
+// the moment it opens the channel until its last Sender is gone.
+template <typename T, typename Policy>
+class Channel<T, Policy, shm_backend> {  // Do NOT use this class directly.
+ public:
+  // Block while the channel is full.
+  void send(T&& value) { emplace(value); }
+  void send(const T& value) { emplace(value); }
+  template <typename... Args>
+  void emplace(Args&&... args);
+  template <typename InputIt>
+  void send_range(InputIt first, InputIt last);
+
+  // Return the value back when the channel is still full (after the deadline).
+  std::optional<T> try_send(T&& value) { return try_send(static_cast<const T&>(value)); }
+  std::optional<T> try_send(const T& value);
+  // Neither wait nor throw on a closed channel: `value` is only used when it's sent.
+  template <typename U>
+  send_status try_send(U&& value, std::nothrow_t);
+
+  template <typename Clock, typename Duration>
+  std::optional<T> send_until(T&& value, const std::chrono::time_point<Clock, Duration>& deadline) {
+    return send_until(static_cast<const T&>(value), deadline);
+  }
+  template <typename Clock, typename Duration>
+  std::optional<T> send_until(const T& value, const std::chrono::time_point<Clock, Duration>& deadline);
+
+  std::optional<T> receive();
+  std::optional<T> try_receive();
+  // Return std::nullopt if nothing arrived before the deadline.
+  template <typename Clock, typename Duration>
+  std::optional<T> receive_until(const std::chrono::time_point<Clock, Duration>& deadline);
+
+  // Receive up to `max` values into `out`; return how many were received.
+  template <typename OutputIt>
+  std::size_t receive_many(OutputIt out, std::size_t max);
+  template <typename OutputIt>
+  std::size_t try_receive_many(OutputIt out, std::size_t max);
+
+  // Called once the last Sender of this process is gone: it no longer counts among the senders of the ring.
+  void close();
+
+  [[nodiscard]] bool closed() const;
+
+  [[nodiscard]] std::size_t capacity() const noexcept { return mask + 1; }
+
+  // Whether receive() would return right away: something is present, or the stream ended.
+  [[nodiscard]] bool ready() const noexcept { return front_ready() or closed(); }
+
+  Ownership& ownership() noexcept { return owners; }
+  [[nodiscard]] channel_stats stats() const noexcept { return counters.snapshot(); }
+
+  Channel(const Channel&) = delete;
+  Channel(Channel&&) = delete;
+  Channel& operator=(const Channel&) = delete;
+  Channel& operator=(Channel&&) = delete;
+
+  ~Channel();
+
+ private:
+  using Ring = ShmRing<T>;
+  using Cell = typename Ring::Cell;
+
+  static constexpr std::uint32_t awake  = 0;
+  static constexpr std::uint32_t parked = 1;
+
+  // Create the region, or open the one another process created.
+  Channel(std::string name, std::size_t capacity);
+
+  // Sender side.
+  // Whether this process closed its end, or the stream ended.
+  bool closed_here() const noexcept { return not sending.load(std::memory_order_acquire) or closed(); }
+  // Return false if the ring is full.
+  template <typename... Args>
+  bool try_push(Args&&... args);
+  bool has_room() const noexcept;
+  // Wait until the ring has room; return false once the channel is closed (or on timeout).
+  bool wait_for_room();
+  template <typename Clock, typename Duration>
+  bool wait_for_room(const std::chrono::time_point<Clock, Duration>& deadline);
+  // Also called to close the channel, which always wakes the receiver.
+  void wake_receiver();
+  // Called by the receiver after it made room.
+  void wake_senders();
+
+  // Receiver side.
+  // Claim the receiving end of the ring before the first receive; throw if another receiver holds it.
+  void claim_receiver();
+  bool front_ready() const noexcept;
+  // The receiver is at the end of the stream (see Policy::drain_on_close).
+  bool exhausted() const noexcept { return closed() and (not Policy::drain_on_close or not front_ready()); }
+  void wait_ready();
+  template <typename Clock, typename Duration>
+  bool wait_ready(const std::chrono::time_point<Clock, Duration>& deadline);
+  std::optional<T> pop();
+  template <typename OutputIt>
+  std::size_t pop_many(OutputIt out, std::size_t max);
+
+  std::string name;
+  Ring* ring;
+  Cell* cells;
+  std::size_t mask;
+
+  // Whether this process still counts among the senders of `ring`.
+  alignas(cache_line_size) std::atomic<bool> sending{true};
+  // Whether this channel holds the receiving end of `ring`. Owned by the receiver.
+  bool receiver = false;
+
+  // Written by every copy of a Sender.
+  alignas(cache_line_size) Ownership owners;
+  [[no_unique_address]] Stats<Policy::collect_stats> counters;
+
+  friend std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_shm_channel<T, Policy>(const std::string&, std::size_t);
+  friend struct PollingReceive;
+};
+#endif
+}  // namespace detail
+
+/// A value constructed in place inside the storage of a channel, which the receiver only sees once committed.
+///
+/// Obtained from Sender::reserve. It must not outlive the Sender it came from. Destroying it without calling
+/// commit() discards the value.
+template <typename T, typename Policy>
+class Reservation {
+  using Channel = detail::Channel<T, Policy>;
+
+ public:
+  T& operator*() const {
+    validate();
+    return channel->reserved_value(token);
+  }
+
+  T* operator->() const { return &**this; }
+
+  /// Hand the value over to the receiver.
+  void commit() {
+    validate();
+    std::exchange(channel, nullptr)->commit(token);
+  }
+
+  ~Reservation() {
+    if (nullptr != channel) {
+      channel->discard(token);
+    }
+  }
+
+  Reservation(Reservation&& other) noexcept : channel{std::exchange(other.channel, nullptr)}, token{std::move(other.token)} {}
+  Reservation& operator=(Reservation&&) = delete;
+  Reservation(const Reservation&) = delete;
+  Reservation& operator=(const Reservation&) = delete;
+
+ private:
+  Reservation(Channel& channel, typename Channel::reservation_type&& token)
+    : channel{&channel}
+    , token{std::move(token)} {}
+
+  Channel* channel;
+  mutable typename Channel::reservation_type token;
+
+  void validate() const {
+    if (nullptr == channel) {
+      throw std::invalid_argument{"This reservation has been committed or moved out."};
+    }
+  }
+
+  friend class Sender<T, Policy>;
+};
+
+template <typename T, typename Policy>
+class Sender {
+  static constexpr bool single_producer = std::is_same_v<typename Policy::backend, spsc_backend>;
+
+ public:
+  Sender& send(T&& value) {
+    validate();
+    channel->send(std::move(value));
+    return *this;
+  }
+
+  Sender& send(const T& value) {
+    validate();
+    channel->send(value);
+    return *this;
+  }
+
+  /// Priority channels only: send to the lane of `priority`, from 0 (the lane of send(value)) to Lanes - 1, the most
+  /// urgent one. The receiver empties a lane before it looks at the less urgent ones.
+  Sender& send(T&& value, std::size_t priority) {
+    validate();
+    channel->send(std::move(value), priority);
+    return *this;
+  }
+
+  Sender& send(const T& value, std::size_t priority) {
+    validate();
+    channel->send(value, priority);
+    return *this;
+  }
+
+  /// Construct the value from `args` directly in the storage of the channel.
+  template <typename... Args>
+  Sender& emplace(Args&&... args) {
+    validate();
+    channel->emplace(std::forward<Args>(args)...);
+    return *this;
+  }
+
+  /// Construct a value from `args` in the storage of the channel, to be filled in through the returned Reservation
+  /// and handed over to the receiver by Reservation::commit.
+  template <typename... Args>
+  [[nodiscard]] Reservation<T, Policy> reserve(Args&&... args) {
+    validate();
+    return Reservation<T, Policy>{*channel, channel->reserve(std::forward<Args>(args)...)};
+  }
+
+  /// Send every value of [first, last) at once: one critical section and at most one wakeup of the receiver.
+  template <typename InputIt>
+  Sender& send_range(InputIt first, InputIt last) {
+    validate();
+    channel->send_range(first, last);
+    return *this;
+  }
+
+  /// Send (moving) every value of `values` at once.
+  Sender& send_bulk(std::vector<T>&& values) {
+    validate();
+    channel->send_range(std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()));
+    values.clear();
+    return *this;
+  }
+
+  /// Bounded channels only: send without waiting for space. Returns the value back if the channel is full.
+  [[nodiscard]] std::optional<T> try_send(T&& value) {
+    validate();
+    return channel->try_send(std::move(value));
+  }
+
+  [[nodiscard]] std::optional<T> try_send(const T& value) {
+    validate();
+    return channel->try_send(value);
+  }
+
+  /// Any channel: send without waiting and without throwing. A closed channel (or an empty sender) is reported in the
+  /// result rather than thrown, and the value is handed back unless it was sent, so producers racing a shutdown
+  /// don't unwind. Only a throwing move (copy) constructor of T can still throw.
+  [[nodiscard]] send_result<T> try_send(T&& value, std::nothrow_t) noexcept(std::is_nothrow_move_constructible_v<T>) {
+    if (nullptr == channel) {
+      return {send_status::closed, std::move(value)};
+    }
+    if (const send_status status = channel->try_send(std::move(value), std::nothrow); send_status::sent != status) {
+      return {status, std::move(value)};
+    }
+    return {send_status::sent, std::nullopt};
+  }
+
+  [[nodiscard]] send_result<T> try_send(const T& value, std::nothrow_t) noexcept(std::is_nothrow_copy_constructible_v<T>) {
+    if (nullptr == channel) {
+      return {send_status::closed, value};
+    }
+    if (const send_status status = channel->try_send(value, std::nothrow); send_status::sent != status) {
+      return {status, value};
+    }
+    return {send_status::sent, std::nullopt};
+  }
+
+  /// Bounded channels only: wait at most `timeout` for space. Returns the value back on timeout.
+  template <typename Rep, typename Period>
+  [[nodiscard]] std::optional<T> send_for(T&& value, const std::chrono::duration<Rep, Period>& timeout) {
+    return send_until(std::move(value), std::chrono::steady_clock::now() + timeout);
+  }
+
+  template <typename Rep, typename Period>
+  [[nodiscard]] std::optional<T> send_for(const T& value, const std::chrono::duration<Rep, Period>& timeout) {
+    return send_until(value, std::chrono::steady_clock::now() + timeout);
+  }
+
+  /// Bounded channels only: wait until `deadline` for space. Returns the value back on timeout.
+  template <typename Clock, typename Duration>
+  [[nodiscard]] std::optional<T> send_until(T&& value, const std::chrono::time_point<Clock, Duration>& deadline) {
+    validate();
+    return channel->send_until(std::move(value), deadline);
+  }
+
+  template <typename Clock, typename Duration>
+  [[nodiscard]] std::optional<T> send_until(const T& value, const std::chrono::time_point<Clock, Duration>& deadline) {
+    validate();
+    return channel->send_until(value, deadline);
+  }
+
+  /// Bounded channels only. Awaitable which suspends the coroutine while the channel is full. The receiver moves
+  /// the value into the room it makes, then resumes the coroutine through `executor` (see inline_executor).
+  template <typename Executor = inline_executor>
+  [[nodiscard]] detail::SendAwaiter<T, detail::Channel<T, Policy>, Executor> async_send(T&& value, Executor executor = {}) {
+    validate();
+    return {*channel, std::move(value), std::move(executor)};
+  }
+
+  template <typename Executor = inline_executor>
+  [[nodiscard]] detail::SendAwaiter<T, detail::Channel<T, Policy>, Executor> async_send(const T& value,
+                                                                                        Executor executor = {}) {
+    validate();
+    return {*channel, value, std::move(executor)};
+  }
+
+  /// Give up this sender's share of the channel: once every copy has been closed (or destroyed), the channel is.
+  void close() {
+    validate();
+    if (counted) {
+      counted = false;
+      // Keep the channel alive for this sender on its own, as it no longer is one of `senders`.
+      channel->ownership().add_owner();
+      leave();
+    }
+  }
+
+  [[nodiscard]] bool closed() const {
+    validate();
+    return channel->closed();
+  }
+
+  /// Only when Policy::collect_stats is set: what the channel counted so far.
+  [[nodiscard]] channel_stats stats() const {
+    validate();
+    return channel->stats();
+  }
+
+  [[nodiscard]] explicit operator bool() const { return nullptr != channel; }
+
+  // A single producer channel has a single Sender.
+  Sender(const Sender& other) noexcept
+    requires(not single_producer)
+    : channel{other.channel}, counted{other.counted} {
+    if (nullptr == channel) {
+      return;
+    }
+    if (counted) {
+      channel->ownership().add_sender();
+    } else {
+      channel->ownership().add_owner();
+    }
+  }
+
+  Sender(Sender&& other) noexcept : channel{std::exchange(other.channel, nullptr)}, counted{other.counted} {}
+
+  Sender& operator=(const Sender& other) noexcept
+    requires(not single_producer)
+  {
+    if (this != &other) {
+      *this = Sender{other};
+    }
+    return *this;
+  }
+
+  Sender& operator=(Sender&& other) noexcept {
+    if (this != &other) {
+      reset();
+      channel = std::exchange(other.channel, nullptr);
+      counted = other.counted;
+    }
+    return *this;
+  }
+
+  ~Sender() { reset(); }
+
+ private:
+  explicit Sender(detail::Channel<T, Policy>& channel) noexcept : channel{&channel} {}
+
+  detail::Channel<T, Policy>* channel;
+  // Whether this sender is one of the channel's `senders`, i.e. hasn't been closed.
+  bool counted = true;
+
+  // Called by a counted sender giving up its share; the last one closes the channel.
+  void leave() noexcept {
+    if (channel->ownership().remove_sender()) {
+      channel->close();
+      release();
+    }
+  }
+
+  void release() noexcept {
+    if (channel->ownership().release()) {
+      delete channel;
+    }
+  }
+
+  void reset() noexcept {
+    if (nullptr == channel) {
+      return;
+    }
+    if (counted) {
+      leave();
+    } else {
+      release();
+    }
+    channel = nullptr;
+  }
+
+  void validate() const {
+    if (nullptr == channel) {
+      throw std::invalid_argument{"This sender has been moved out."};
+    }
+  }
+
+  friend std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_channel<T, Policy>(const typename Policy::allocator&);
+  friend std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_bounded_channel<T, Policy>(std::size_t);
+  friend std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_broadcast_channel<T, Policy>(std::size_t);
+#if defined(__linux__)
+  friend std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_shm_channel<T, Policy>(const std::string&, std::size_t);
+#endif
+};
+
+/// Collects what a single producer sends, and hands it over to the channel as one batch (see Sender::send_bulk) once
+/// `batch_size` values are buffered, or when a send finds the oldest of them buffered for `max_delay`. The delay is
+/// only checked by sends: call flush() before the producer goes idle. Destroying (or closing) it flushes too.
+///
+/// Each producer thread owns one, so it can be moved but not copied.
+template <typename T, typename Policy = default_policy>
+class BufferedSender {
+ public:
+  explicit BufferedSender(Sender<T, Policy> sender,
+                          std::size_t batch_size             = 64,
+                          std::chrono::microseconds max_delay = std::chrono::microseconds::max())
+    : sender{std::move(sender)}
+    , batch_size{batch_size}
+    , max_delay{max_delay} {
+    if (0 == batch_size) {
+      throw std::invalid_argument{"The batch size of a buffered sender should be at least 1."};
+    }
+    buffer.reserve(batch_size);
+  }
+
+  BufferedSender& send(T&& value) { return emplace(std::move(value)); }
+  BufferedSender& send(const T& value) { return emplace(value); }
+
+  template <typename... Args>
+  BufferedSender& emplace(Args&&... args) {
+    if (sender.closed()) {
+      throw channel_closed_exception();
+    }
+    buffer.emplace_back(std::forward<Args>(args)...);
+
+    if (buffer.size() >= batch_size) {
+      flush();
+    }
+    else if (max_delay != std::chrono::microseconds::max()) {
+      const auto now = std::chrono::steady_clock::now();
+      if (1 == buffer.size()) {
+        oldest = now;
+      }
+      else if (now - oldest >= max_delay) {
+        flush();
+      }
+    }
+    return *this;
+  }
+
+  /// Send what is buffered. If the channel is closed, the buffered values are dropped and channel_closed_exception
+  /// is thrown.
+  void flush() {
+    if (buffer.empty()) {
+      return;
+    }
+    try {
+      sender.send_bulk(std::move(buffer));
+    }
+    catch (...) {
+      buffer.clear();
+      throw;
+    }
+  }
+
+  /// Flush, then close the sender (see Sender::close).
+  void close() {
+    flush();
+    sender.close();
+  }
+
+  [[nodiscard]] std::size_t buffered() const noexcept { return buffer.size(); }
+
+  [[nodiscard]] bool closed() const { return sender.closed(); }
+
+  [[nodiscard]] explicit operator bool() const { return static_cast<bool>(sender); }
+
+  BufferedSender(BufferedSender&&) noexcept = default;
+  BufferedSender& operator=(BufferedSender&& other) noexcept {
+    if (this != &other) {
+      flush_quietly();
+      sender     = std::move(other.sender);
+      buffer     = std::exchange(other.buffer, {});
+      batch_size = other.batch_size;
+      max_delay  = other.max_delay;
+      oldest     = other.oldest;
+    }
+    return *this;
+  }
+  BufferedSender(const BufferedSender&) = delete;
+  BufferedSender& operator=(const BufferedSender&) = delete;
+
+  ~BufferedSender() { flush_quietly(); }
+
+ private:
+  // A closed channel drops the values anyway.
+  void flush_quietly() noexcept {
+    try {
+      flush();
+    }
+    catch (...) {
+    }
+  }
+
+  Sender<T, Policy> sender;
+  std::vector<T> buffer;
+  std::size_t batch_size;
+  std::chrono::microseconds max_delay;
+  // When the first value of `buffer` was buffered; only kept with a max_delay.
+  std::chrono::steady_clock::time_point oldest;
+};
+
+template <typename T, typename Policy>
+class Receiver {
+  static constexpr bool multi_consumer = std::is_same_v<typename Policy::backend, mpmc_backend> or
+                                         std::is_same_v<typename Policy::backend, broadcast_backend>;
+  using channel_type = typename detail::ReceiverTarget<T, Policy>::type;
+  // Whether the channel tells select, async_receive and native_handle about new values.
+  static constexpr bool hooked = requires(channel_type& channel) { channel.receive_hook(); };
+
+ public:
+  std::optional<T> receive() {
+    validate();
+    return channel->receive();
+  }
+
+  std::optional<T> try_receive() {
+    validate();
+    std::optional<T> value = channel->try_receive();
+    if (not value.has_value()) {
+      rearm();
+    }
+    return value;
+  }
+
+  /// Block until something is present, at most for `timeout`. Return std::nullopt on timeout.
+  template <typename Rep, typename Period>
+  std::optional<T> receive_for(const std::chrono::duration<Rep, Period>& timeout) {
+    return receive_until(std::chrono::steady_clock::now() + timeout);
+  }
+
+  /// Block until something is present, at most until `deadline`. Return std::nullopt on timeout.
+  template <typename Clock, typename Duration>
+  std::optional<T> receive_until(const std::chrono::time_point<Clock, Duration>& deadline) {
+    validate();
+    return channel->receive_until(deadline);
+  }
+
+  /// Block until something is present, then receive up to `max` values into `out` at once.
+  /// Return how many values were received (0 once the channel is closed).
+  template <typename OutputIt>
+  std::size_t receive_many(OutputIt out, std::size_t max) {
+    validate();
+    return channel->receive_many(out, max);
+  }
+
+  /// Receive up to `max` values which are already present into `out`, without blocking.
+  template <typename OutputIt>
+  std::size_t try_receive_many(OutputIt out, std::size_t max) {
+    validate();
+    const std::size_t received = channel->try_receive_many(out, max);
+    if (received < max) {
+      rearm();
+    }
+    return received;
+  }
+
+  /// Block until something is present, then append everything present to `out`.
+  std::size_t drain_into(std::vector<T>& out) {
+    return receive_many(detail::VectorAppender<T>{out}, out.max_size() - out.size());
+  }
+
+  /// Append everything which is already present to `out`, without blocking.
+  std::size_t try_drain_into(std::vector<T>& out) {
+    return try_receive_many(detail::VectorAppender<T>{out}, out.max_size() - out.size());
+  }
+
+  [[nodiscard]] bool closed() const {
+    validate();
+    return channel->closed();
+  }
+
+  /// Whether receive() would return right away: something is present, or the channel has reached its end.
+  [[nodiscard]] bool ready() const {
+    validate();
+    return channel->ready();
+  }
+
+  /// Only when Policy::collect_stats is set: what the channel counted so far.
+  [[nodiscard]] channel_stats stats() const {
+    validate();
+    return channel->stats();
+  }
+
+  /// Only when Policy::trace_latency is set: how long the values received so far waited in the channel. It may be
+  /// scraped from any thread while the channel is in use.
+  [[nodiscard]] latency_histogram latencies() const {
+    static_assert(Policy::trace_latency, "Set Policy::trace_latency to trace the latency of a channel.");
+    validate();
+    return channel->latencies();
+  }
+
+#if defined(__linux__)
+  /// Linux only, and not for MPMC, broadcast nor shared memory channels: an eventfd (owned by the channel, created on
+  /// first call) which becomes readable when values arrive or the channel is closed, to wait for it with epoll or
+  /// io_uring along with other file descriptors. It signals the channel becoming non-empty, not each value: once it's
+  /// readable, receive with try_receive (or try_receive_many) until the channel is found empty, which makes it
+  /// unreadable again. It may be readable spuriously, and stays readable once the channel is closed.
+  [[nodiscard]] int native_handle() {
+    static_assert(hooked, "Only channels which work with select have a native handle.");
+    validate();
+    return channel->receive_hook().event_handle();
+  }
+#endif
+
+  /// Awaitable which suspends the coroutine until something is present, then returns what receive() would. A sender
+  /// resumes the coroutine through `executor` (see inline_executor).
+  template <typename Executor = inline_executor>
+  [[nodiscard]] detail::ReceiveAwaiter<channel_type, Executor> async_receive(Executor executor = {}) {
+    validate();
+    return {*channel, std::move(executor)};
+  }
+
+  [[nodiscard]] explicit operator bool() const { return nullptr != channel; }
+
+  // Only a multi-consumer channel can have several Receivers.
+  Receiver(const Receiver& other)
+    requires(multi_consumer)
+    : channel{nullptr == other.channel ? nullptr : other.channel->share()} {}
+
+  Receiver(Receiver&& other) noexcept : channel{std::exchange(other.channel, nullptr)} {}
+
+  Receiver& operator=(const Receiver& other)
+    requires(multi_consumer)
+  {
+    if (this != &other) {
+      *this = Receiver{other};
+    }
+    return *this;
+  }
+
+  Receiver& operator=(Receiver&& other) noexcept {
+    if (this != &other) {
+      reset();
+      channel = std::exchange(other.channel, nullptr);
+    }
+    return *this;
+  }
+
+  ~Receiver() { reset(); }
+
+ private:
+  explicit Receiver(channel_type& channel) noexcept : channel{&channel} {}
+
+  channel_type* channel;
+
+  void reset() noexcept {
+    if (nullptr != channel and channel->ownership().release()) {
+      delete channel;
+    }
+    channel = nullptr;
+  }
+
+  void validate() const {
+    if (nullptr == channel) {
+      throw std::invalid_argument{"This receiver has been moved out."};
+    }
+  }
+
+  // A non-blocking receive found the channel empty: native_handle() isn't readable until the next values.
+  void rearm() {
+#if defined(__linux__)
+    if constexpr (hooked) {
+      channel->receive_hook().rearm([this] { return channel->ready(); });
+    }
+#endif
+  }
+
+  friend std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_channel<T, Policy>(const typename Policy::allocator&);
+  friend std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_bounded_channel<T, Policy>(std::size_t);
+  friend std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_broadcast_channel<T, Policy>(std::size_t);
+#if defined(__linux__)
+  friend std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_shm_channel<T, Policy>(const std::string&, std::size_t);
+#endif
+  friend struct detail::SelectAccess;
+
+ public:
+  /// Makes a Receiver a std::ranges::input_range: the end of the stream compares equal both to end() and to
+  /// std::default_sentinel. It only receives once it's dereferenced or compared, so that std::views::take(n) doesn't
+  /// wait for an n+1th value.
+  class iterator {
+   public:
+    using iterator_concept  = std::input_iterator_tag;
+    using iterator_category = std::input_iterator_tag;
+    using difference_type   = std::ptrdiff_t;
+    using value_type        = T;
+    using pointer           = T*;
+    using reference         = T&;
+
+    iterator() : receiver{ nullptr } {}
+
+    explicit iterator(Receiver& receiver) : receiver{ &receiver } {}
+
+    // Only copy the value already received when there is one, rather than the bytes of an empty std::optional.
+    iterator(const iterator& other) : receiver{ other.receiver } { copy_current(other); }
+
+    iterator& operator=(const iterator& other) {
+      if (this != &other) {
+        receiver = other.receiver;
+        current.reset();
+        copy_current(other);
+      }
+      return *this;
+    }
+
+    reference operator*() const {
+      fetch();
+      return current.value();
+    }
+
+    pointer operator->() const { return &**this; }
+
+    iterator& operator++() {
+      // Skip a value nobody looked at.
+      fetch();
+      current.reset();
+      return *this;
+    }
+
+    void operator++(int) { ++*this; }
+
+    [[nodiscard]] bool operator==(const iterator& other) const { return at_end() and other.at_end(); }
+
+    [[nodiscard]] bool operator==(std::default_sentinel_t) const { return at_end(); }
+
+   private:
+    // Receiving is deferred to the const accessors, hence mutable.
+    mutable Receiver* receiver;
+    mutable std::optional<T> current = std::nullopt;
+
+    bool at_end() const {
+      fetch();
+      return receiver == nullptr;
+    }
+
+    void copy_current(const iterator& other) {
+      if (other.current.has_value()) {
+        current.emplace(*other.current);
+      }
+    }
+
+    void fetch() const {
+      if (!receiver or current.has_value()) {
+        return;
+      }
+
+      // receive() only comes back empty at the end of the stream.
+      current = receiver->receive();
+      if (not current.has_value()) {
+        receiver = nullptr;
+      }
+    }
+  };
+
+  [[nodiscard]] iterator begin() { return iterator(*this); }
+
+  [[nodiscard]] iterator end() { return iterator(); }
+};
+
+/// The view of `receiver | mpsc::chunked(max)`: a lazy input range of the batches receive_many() returns, of up to
+/// `max` values each. Each batch is everything present when it's pulled, so it only waits for the first value.
+template <typename T, typename Policy>
+class ChunkedView : public std::ranges::view_interface<ChunkedView<T, Policy>> {
+ public:
+  // Pulls its batch lazily, as Receiver::iterator does.
+  class iterator {
+   public:
+    using iterator_concept = std::input_iterator_tag;
+    using difference_type  = std::ptrdiff_t;
+    using value_type       = std::vector<T>;
+
+    // The batch is reused for the next one, so that pulling batches doesn't allocate.
+    const std::vector<T>& operator*() const {
+      fetch();
+      return chunk;
+    }
+
+    const std::vector<T>* operator->() const { return &**this; }
+
+    iterator& operator++() {
+      fetch();
+      chunk.clear();
+      return *this;
+    }
+
+    void operator++(int) { ++*this; }
+
+    [[nodiscard]] bool operator==(std::default_sentinel_t) const {
+      fetch();
+      return nullptr == receiver;
+    }
+
+    iterator(iterator&&) noexcept            = default;
+    iterator& operator=(iterator&&) noexcept = default;
+
+   private:
+    iterator(Receiver<T, Policy>& receiver, std::size_t max) : receiver{&receiver}, max{max} { chunk.reserve(max); }
+
+    // A batch is never empty, so an empty one is yet to be pulled.
+    void fetch() const {
+      if (nullptr != receiver and chunk.empty() and 0 == receiver->receive_many(detail::VectorAppender<T>{chunk}, max)) {
+        receiver = nullptr;
+      }
+    }
+
+    mutable Receiver<T, Policy>* receiver;
+    std::size_t max;
+    mutable std::vector<T> chunk;
+
+    friend class ChunkedView;
+  };
+
+  ChunkedView(Receiver<T, Policy>& receiver, std::size_t max) noexcept : receiver{&receiver}, max{max} {}
+
+  [[nodiscard]] iterator begin() { return iterator{*receiver, max}; }
+
+  [[nodiscard]] std::default_sentinel_t end() const noexcept { return std::default_sentinel; }
+
+ private:
+  Receiver<T, Policy>* receiver;
+  std::size_t max;
+};
+
+namespace detail {
+struct ChunkedAdaptor {
+  std::size_t max;
+};
+}  // namespace detail
+
+/// `receiver | mpsc::chunked(max)` pulls the values in batches of up to `max` (see ChunkedView).
+[[nodiscard]] inline detail::ChunkedAdaptor chunked(std::size_t max) {
+  if (0 == max) {
+    throw std::invalid_argument{"A chunk should hold at least 1 value."};
+  }
+  return {max};
+}
+
+template <typename T, typename Policy>
+[[nodiscard]] ChunkedView<T, Policy> operator|(Receiver<T, Policy>& receiver, detail::ChunkedAdaptor adaptor) noexcept {
+  return {receiver, adaptor.max};
+}
+
+/// Shares the values of a single Receiver among `workers` threads, which call `handler(std::move(value))` concurrently. One
+/// worker at a time pulls a batch of up to `batch_size` values off the channel into its own deque, which it handles in
+/// order while idle workers steal half of what is left from its back. So a stage scales across cores while the
+/// producers keep the MPSC side of the channel, but values are no longer handled in order.
+///
+/// The workers stop once the stream ended (see Policy::drain_on_close) and everything pulled was handled. join()
+/// waits for that, and rethrows the first exception a handler threw, after which the pool only finishes the values
+/// already pulled. The destructor joins as well, so close the channel first.
+template <typename T, typename Policy, typename Handler>
+class WorkerPool {
+ public:
+  WorkerPool(Receiver<T, Policy> receiver,
+             Handler handler,
+             std::size_t workers    = std::max(1U, std::thread::hardware_concurrency()),
+             std::size_t batch_size = 64)
+    : receiver{std::move(receiver)}
+    , handler{std::move(handler)}
+    , batch_size{batch_size}
+    , queues(workers) {
+    if (0 == workers or 0 == batch_size) {
+      throw std::invalid_argument{"A worker pool should have at least 1 worker, pulling at least 1 value at a time."};
+    }
+    if (not this->receiver) {
+      throw std::invalid_argument{"This receiver has been moved out."};
+    }
+    threads.reserve(workers);
+    for (std::size_t index = 0; index < workers; ++index) {
+      threads.emplace_back([this, index] { run(index); });
+    }
+  }
+
+  /// Wait until the stream ended and every value was handled; rethrow the first exception of a handler.
+  void join() {
+    for (auto& thread: threads) {
+      if (thread.joinable()) {
+        thread.join();
+      }
+    }
+    if (auto error = std::exchange(failure, nullptr)) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  [[nodiscard]] std::size_t workers() const noexcept { return queues.size(); }
+
+  // The workers refer to the pool.
+  WorkerPool(const WorkerPool&)            = delete;
+  WorkerPool(WorkerPool&&)                 = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+  WorkerPool& operator=(WorkerPool&&)      = delete;
+
+  ~WorkerPool() {
+    try {
+      join();
+    }
+    catch (...) {
+    }
+  }
+
+ private:
+  struct alignas(detail::cache_line_size) Queue {
+    std::mutex mutex;
+    std::deque<T> values;
+  };
+
+  void run(std::size_t index) {
+    std::vector<T> batch;
+    for (;;) {
+      if (auto value = pop(index)) {
+        handle(std::move(*value));
+        continue;
+      }
+
+      // Stealing comes first, as pulling blocks while the channel is empty.
+      const std::uint64_t seen = generation.load(std::memory_order_acquire);
+      if (steal(index) or refill(index, batch)) {
+        continue;
+      }
+      if (exhausted.load(std::memory_order_acquire)) {
+        return;
+      }
+      // Somebody else is pulling: wait for its batch, or for the end of the stream.
+      std::unique_lock lock{idle_mutex};
+      idle.wait(lock, [&] { return generation.load(std::memory_order_acquire) != seen; });
+    }
+  }
+
+  void handle(T&& value) {
+    try {
+      handler(std::move(value));
+    }
+    catch (...) {
+      std::scoped_lock lock{idle_mutex};
+      if (not failure) {
+        failure = std::current_exception();
+      }
+      failed.store(true, std::memory_order_release);
+    }
+  }
+
+  std::optional<T> pop(std::size_t index) {
+    Queue& queue = queues[index];
+    std::scoped_lock lock{queue.mutex};
+    if (queue.values.empty()) {
+      return std::nullopt;
+    }
+    std::optional<T> value{std::move(queue.values.front())};
+    queue.values.pop_front();
+    return value;
+  }
+
+  // Pull a batch into our own queue, unless another worker is already pulling one.
+  bool refill(std::size_t index, std::vector<T>& batch) {
+    std::unique_lock lock{receiving, std::try_to_lock};
+    if (not lock.owns_lock() or exhausted.load(std::memory_order_relaxed)) {
+      return false;
+    }
+
+    batch.clear();
+    if (failed.load(std::memory_order_acquire) or 0 == receiver.receive_many(std::back_inserter(batch), batch_size)) {
+      exhausted.store(true, std::memory_order_release);
+    }
+    else {
+      Queue& queue = queues[index];
+      std::scoped_lock queue_lock{queue.mutex};
+      std::move(batch.begin(), batch.end(), std::back_inserter(queue.values));
+    }
+    lock.unlock();
+
+    wake_idle();
+    return not exhausted.load(std::memory_order_relaxed);
+  }
+
+  // Take half of what is left at the back of another queue, starting from the next worker.
+  bool steal(std::size_t index) {
+    Queue& queue = queues[index];
+    for (std::size_t offset = 1; offset < queues.size(); ++offset) {
+      Queue& victim = queues[(index + offset) % queues.size()];
+      std::size_t count = 0;
+      {
+        // Both queues at once: the values are never out of every queue, for another worker looking for some.
+        std::scoped_lock lock{victim.mutex, queue.mutex};
+        count            = (victim.values.size() + 1) / 2;
+        const auto first = victim.values.end() - static_cast<std::ptrdiff_t>(count);
+        std::move(first, victim.values.end(), std::back_inserter(queue.values));
+        victim.values.erase(first, victim.values.end());
+      }
+      if (0 != count) {
+        // A worker which looked at our queue before this steal, and at the victim's after, saw neither: wake it up
+        // if there's something left for it to steal.
+        if (1 < count) {
+          wake_idle();
+        }
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void wake_idle() {
+    {
+      std::scoped_lock idle_lock{idle_mutex};
+      generation.fetch_add(1, std::memory_order_release);
+    }
+    idle.notify_all();
+  }
+
+  Receiver<T, Policy> receiver;
+  Handler handler;
+  std::size_t batch_size;
+
+  // The worker pulling the next batch holds `receiving`.
+  std::mutex receiving;
+  std::atomic<bool> exhausted{false};
+  std::atomic<bool> failed{false};
+
+  // Bumped (under idle_mutex) after each pull, and each steal leaving values to steal, to wake up the idle workers.
+  std::mutex idle_mutex;
+  std::condition_variable idle;
+  std::atomic<std::uint64_t> generation{0};
+  std::exception_ptr failure;
+
+  std::vector<Queue> queues;
+  std::vector<std::thread> threads;
+};
+
+/* ======== Implementations ========= */
+
+template <typename T, typename Policy>
+[[nodiscard]] std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_channel(const typename Policy::allocator& allocator) {
+  static_assert(std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>,
+                "T should be copy-constructible or move-constructible.");
+  static_assert(not Policy::trace_latency or not std::is_same_v<typename Policy::backend, intrusive_backend>,
+                "Only node based backends trace latency.");
+
+  auto* channel = new detail::Channel<T, Policy>(allocator);
+  Sender<T, Policy> sender{*channel};
+  Receiver<T, Policy> receiver{*channel};
+  return std::tuple<Sender<T, Policy>, Receiver<T, Policy>>{std::move(sender), std::move(receiver)};
+}
+
+template <typename T, typename Policy>
+[[nodiscard]] std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_bounded_channel(std::size_t capacity) {
+  static_assert(std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>,
+                "T should be copy-constructible or move-constructible.");
+  static_assert(not Policy::trace_latency, "Only node based backends trace latency.");
+
+  if (0 == capacity) {
+    throw std::invalid_argument{"The capacity of a bounded channel should be at least 1."};
+  }
+
+  auto* channel = new detail::Channel<T, Policy>(capacity);
+  Sender<T, Policy> sender{*channel};
+  Receiver<T, Policy> receiver{*channel};
+  return std::tuple<Sender<T, Policy>, Receiver<T, Policy>>{std::move(sender), std::move(receiver)};
+}
+
+template <typename T, typename Policy>
+[[nodiscard]] std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_spsc_channel(std::size_t capacity) {
+  static_assert(std::is_same_v<typename Policy::backend, spsc_backend>, "The policy should select spsc_backend.");
+  return make_bounded_channel<T, Policy>(capacity);
+}
+
+template <typename T, typename Policy>
+[[nodiscard]] std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_mpmc_channel(std::size_t capacity) {
+  static_assert(std::is_same_v<typename Policy::backend, mpmc_backend>, "The policy should select mpmc_backend.");
+  return make_bounded_channel<T, Policy>(capacity);
+}
+
+template <typename T, typename Policy>
+[[nodiscard]] std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_broadcast_channel(std::size_t capacity) {
+  static_assert(std::is_same_v<typename Policy::backend, broadcast_backend>,
+                "The policy should select broadcast_backend.");
+  static_assert(std::is_copy_constructible_v<T>, "T should be copy-constructible: every receiver gets a copy.");
+  static_assert(not Policy::trace_latency, "Only node based backends trace latency.");
+
+  if (0 == capacity) {
+    throw std::invalid_argument{"The capacity of a bounded channel should be at least 1."};
+  }
+
+  auto* channel = new detail::Channel<T, Policy>(capacity);
+  Sender<T, Policy> sender{*channel};
+  Receiver<T, Policy> receiver{*channel->subscriptions.front()};
+  return std::tuple<Sender<T, Policy>, Receiver<T, Policy>>{std::move(sender), std::move(receiver)};
+}
+
+#if defined(__linux__)
+template <typename T, typename Policy>
+[[nodiscard]] std::tuple<Sender<T, Policy>, Receiver<T, Policy>> make_shm_channel(const std::string& name,
+                                                                                 std::size_t capacity) {
+  static_assert(std::is_same_v<typename Policy::backend, shm_backend>, "The policy should select shm_backend.");
+  static_assert(std::is_trivially_copyable_v<T>, "T should be trivially copyable: it's copied through shared memory.");
+  static_assert(not Policy::trace_latency, "Only node based backends trace latency.");
+  static_assert(alignof(T) <= detail::cache_line_size, "T shouldn't be aligned on more than a cache line.");
+  static_assert(std::atomic<std::size_t>::is_always_lock_free and std::atomic<std::uint32_t>::is_always_lock_free,
+                "Atomics in shared memory should be lock-free.");
+
+  if (0 == capacity) {
+    throw std::invalid_argument{"The capacity of a bounded channel should be at least 1."};
+  }
+
+  auto* channel = new detail::Channel<T, Policy>(name, capacity);
+  Sender<T, Policy> sender{*channel};
+  Receiver<T, Policy> receiver{*channel};
+  return std::tuple<Sender<T, Policy>, Receiver<T, Policy>>{std::move(sender), std::move(receiver)};
+}
+#endif
+
+namespace detail {
+// The index of the first ready receiver, or sizeof...(Receivers) if none is.
+template <typename... Receivers>
+std::size_t first_ready(Receivers&... receivers) {
+  std::size_t index = 0;
+  (void)((SelectAccess::channel(receivers).ready() or (++index, false)) or ...);
+  return index;
+}
+
+// Attach one waiter to every channel and park it with `park(waiter, ready)`.
+template <typename Park, typename... Receivers>
+std::optional<std::size_t> select_with(Park park, Receivers&... receivers) {
+  static_assert(sizeof...(Receivers) > 0, "select needs at least one receiver.");
+
+  std::size_t index = first_ready(receivers...);
+  if (index < sizeof...(Receivers)) {
+    return index;
+  }
+
+  SelectWaiter waiter;
+  const auto detach_all = [&] { (SelectAccess::channel(receivers).receive_hook().detach(), ...); };
+  struct Detacher {
+    const decltype(detach_all)& detach;
+    ~Detacher() { detach(); }
+  } detacher{detach_all};
+
+  (SelectAccess::channel(receivers).receive_hook().attach(waiter), ...);
+  const bool in_time = park(waiter, [&] {
+    index = first_ready(receivers...);
+    return index < sizeof...(Receivers);
+  });
+
+  return in_time ? std::optional<std::size_t>{index} : std::nullopt;
+}
+}  // namespace detail
+
+template <typename... Receivers>
+std::size_t select(Receivers&... receivers) {
+  const auto park = [](detail::SelectWaiter& waiter, auto ready) {
+    waiter.park_until(ready);
+    return true;
+  };
+  return *detail::select_with(park, receivers...);
+}
+
+template <typename Clock, typename Duration, typename... Receivers>
+std::optional<std::size_t> select_until(const std::chrono::time_point<Clock, Duration>& deadline,
+                                        Receivers&... receivers) {
+  const auto park = [&deadline](detail::SelectWaiter& waiter, auto ready) { return waiter.park_until(ready, deadline); };
+  return detail::select_with(park, receivers...);
+}
+
+template <typename Rep, typename Period, typename... Receivers>
+std::optional<std::size_t> select_for(const std::chrono::duration<Rep, Period>& timeout, Receivers&... receivers) {
+  return select_until(std::chrono::steady_clock::now() + timeout, receivers...);
+}
+
+template <typename T, typename Policy>
+detail::NodeAllocator<T, Policy>::~NodeAllocator() {
+  node_type* node = free_list.load(std::memory_order_acquire);
+  while (nullptr != node) {
+    node_type* next = node->next.load(std::memory_order_relaxed);
+    deallocate(node);
+    node = next;
+  }
+}
+
+template <typename T, typename Policy>
+typename detail::NodeAllocator<T, Policy>::node_type* detail::NodeAllocator<T, Policy>::pop_free() noexcept {
+  if (popping.test_and_set(std::memory_order_acquire)) {
+    return nullptr;
+  }
+
+  node_type* node = free_list.load(std::memory_order_acquire);
+  while (nullptr != node and
+         not free_list.compare_exchange_weak(
+             node, node->next.load(std::memory_order_relaxed), std::memory_order_acquire, std::memory_order_acquire)) {
+  }
+
+  popping.clear(std::memory_order_release);
+  return node;
+}
+
+template <typename T, typename Policy>
+void detail::NodeAllocator<T, Policy>::deallocate(node_type* node) noexcept {
+  auto* storage = static_cast<storage_type*>(node);
+  traits::destroy(allocator, storage);
+  traits::deallocate(allocator, storage, 1);
+}
+
+template <typename T, typename Policy>
+typename detail::NodeAllocator<T, Policy>::node_type* detail::NodeAllocator<T, Policy>::make_empty() {
+  if constexpr (Policy::recycle_nodes) {
+    if (node_type* node = pop_free(); nullptr != node) {
+      node->next.store(nullptr, std::memory_order_relaxed);
+      return node;
+    }
+  }
+
+  storage_type* node = traits::allocate(allocator, 1);
+  traits::construct(allocator, node);
+  return node;
+}
+
+template <typename T, typename Policy>
+typename detail::NodeAllocator<T, Policy>::node_type* detail::NodeAllocator<T, Policy>::try_make_empty() noexcept {
+  try {
+    return make_empty();
+  }
+  catch (...) {
+    return nullptr;
+  }
+}
+
+template <typename T, typename Policy>
+template <typename... Args>
+typename detail::NodeAllocator<T, Policy>::node_type* detail::NodeAllocator<T, Policy>::make(Args&&... args) {
+  return construct(make_empty(), std::forward<Args>(args)...);
+}
+
+template <typename T, typename Policy>
+template <typename InputIt>
+detail::NodeChain<T> detail::NodeAllocator<T, Policy>::make_chain(InputIt first, InputIt last) {
+  NodeChain<T> chain;
+  try {
+    for (; first != last; ++first) {
+      chain.push_back(make(*first));
+    }
+  }
+  catch (...) {
+    destroy(chain);
+    throw;
+  }
+  return chain;
+}
+
+template <typename T, typename Policy>
+template <typename... Args>
+typename detail::NodeAllocator<T, Policy>::node_type* detail::NodeAllocator<T, Policy>::construct(node_type* node,
+                                                                                                    Args&&... args) {
+  try {
+    ::new (static_cast<void*>(&node->value)) T(std::forward<Args>(args)...);
+  }
+  catch (...) {
+    release(node);
+    throw;
+  }
+  stamp(node);
+  return node;
+}
+
+template <typename T, typename Policy>
+void detail::NodeAllocator<T, Policy>::release(node_type* node) noexcept {
+  node->next.store(nullptr, std::memory_order_relaxed);
+  release(NodeChain<T>{node, node, 1});
+}
+
+template <typename T, typename Policy>
+void detail::NodeAllocator<T, Policy>::release(NodeChain<T> chain) noexcept {
+  if (chain.empty()) {
+    return;
+  }
+
+  if constexpr (Policy::recycle_nodes) {
+    node_type* top = free_list.load(std::memory_order_relaxed);
+    do {
+      chain.last->next.store(top, std::memory_order_relaxed);
+    } while (not free_list.compare_exchange_weak(top, chain.first, std::memory_order_release, std::memory_order_relaxed));
+  }
+  else {
+    while (not chain.empty()) {
+      deallocate(chain.pop_front());
+    }
+  }
+}
+
+template <typename T, typename Policy>
+void detail::NodeAllocator<T, Policy>::destroy(node_type* node) noexcept {
+  node->value.~T();
+  release(node);
+}
+
+template <typename T, typename Policy>
+void detail::NodeAllocator<T, Policy>::destroy(NodeChain<T> chain) noexcept {
+  node_type* node = chain.first;
+  for (std::size_t i = 0; i < chain.size; ++i, node = node->next.load(std::memory_order_relaxed)) {
+    node->value.~T();
+  }
+  release(chain);
+}
+
+template <typename T, typename Policy>
+detail::Channel<T, Policy, locked_backend>::~Channel() {
+  nodes.destroy(queue);
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, locked_backend>::enqueue(NodeChain<T> chain) {
+  std::unique_lock lock(mutex);
+  if (_closed) {
+    lock.unlock();
+    nodes.destroy(chain);
+    throw channel_closed_exception();
+  }
+
+  const std::size_t sent = chain.size;
+  counters.sent(sent);
+  queue.append(chain);
+  queued.store(queue.size, std::memory_order_relaxed);
+  lock.unlock();
+
+  wake_receiver(sent);
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, locked_backend>::send(T&& value) {
+  emplace(std::move(value));
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, locked_backend>::send(const T& value) {
+  emplace(value);
+}
+
+template <typename T, typename Policy>
+template <typename... Args>
+void detail::Channel<T, Policy, locked_backend>::emplace(Args&&... args) {
+  Node<T>* node = nodes.make(std::forward<Args>(args)...);
+  enqueue(NodeChain<T>{node, node, 1});
+}
+
+template <typename T, typename Policy>
+template <typename U>
+send_status detail::Channel<T, Policy, locked_backend>::try_send(U&& value, std::nothrow_t) {
+  // Producers racing a shutdown neither allocate nor lock; the check under the lock is the one which counts.
+  if (_closed.load(std::memory_order_acquire)) {
+    return send_status::closed;
+  }
+
+  Node<T>* node = nodes.try_make_empty();
+  if (nullptr == node) {
+    return send_status::full;
+  }
+
+  std::unique_lock lock(mutex);
+  if (_closed) {
+    lock.unlock();
+    nodes.release(node);
+    return send_status::closed;
+  }
+
+  // Only moved (or copied) once the channel is known to be open, under the lock.
+  try {
+    nodes.construct(node, std::forward<U>(value));
+  }
+  catch (...) {
+    lock.unlock();
+    throw;
+  }
+  counters.sent(1);
+  queue.push_back(node);
+  queued.store(queue.size, std::memory_order_relaxed);
+  lock.unlock();
+
+  wake_receiver(1);
+  return send_status::sent;
+}
+
+template <typename T, typename Policy>
+template <typename InputIt>
+void detail::Channel<T, Policy, locked_backend>::send_range(InputIt first, InputIt last) {
+  // Allocate the nodes before taking the lock.
+  enqueue(nodes.make_chain(first, last));
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, locked_backend>::commit(reservation_type reservation) {
+  nodes.stamp(reservation);
+  enqueue(NodeChain<T>{reservation, reservation, 1});
+}
+
+// Only the receiver empties the queue, so it stays non-empty until the receiver takes `mutex`, which also makes the
+// nodes visible.
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, locked_backend>::wait_ready() {
+  const auto ready = [this] { return this->ready(); };
+  counters.wait(ready, [&] { parker.park_until(ready); });
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+bool detail::Channel<T, Policy, locked_backend>::wait_ready(const std::chrono::time_point<Clock, Duration>& deadline) {
+  const auto ready = [this] { return this->ready(); };
+  return counters.wait(ready, [&] { return parker.park_until(ready, deadline); });
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, locked_backend>::wake_receiver(std::size_t sent) {
+  const bool parked = parker.unpark(sent);
+  if (hook.notify() or parked) {
+    counters.notified();
+  }
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, locked_backend>::receive() {
+  if (discarding()) {
+    return std::nullopt;
+  }
+
+  wait_ready();
+  return pop_ready();
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+std::optional<T> detail::Channel<T, Policy, locked_backend>::receive_until(
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  if (discarding() or not wait_ready(deadline)) {
+    return std::nullopt;
+  }
+
+  return pop_ready();
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, locked_backend>::pop_ready() {
+  std::unique_lock lock(mutex);
+
+  if (queue.empty() or discarding()) {
+    return {};
+  }
+
+  Node<T>* node = queue.pop_front();
+  queued.store(queue.size, std::memory_order_relaxed);
+  counters.received(1);
+  lock.unlock();
+
+  latency.record(nodes.sent(node), latency.now());
+  std::optional<T> result{std::move(node->value)};
+  nodes.destroy(node);
+  return result;
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, locked_backend>::try_receive() {
+  // Polling an empty channel doesn't touch the mutex.
+  if (0 == queued.load(std::memory_order_relaxed)) {
+    return {};
+  }
+
+  return pop_ready();
+}
+
+template <typename T, typename Policy>
+detail::NodeChain<T> detail::Channel<T, Policy, locked_backend>::take(std::size_t max) {
+  if (max >= queue.size) {
+    return std::exchange(queue, NodeChain<T>{});
+  }
+
+  NodeChain<T> batch{queue.first, queue.first, max};
+  for (std::size_t i = 1; i < max; ++i) {
+    batch.last = batch.last->next.load(std::memory_order_relaxed);
+  }
+  queue.first = batch.last->next.load(std::memory_order_relaxed);
+  queue.size -= max;
+  batch.last->next.store(nullptr, std::memory_order_relaxed);
+  return batch;
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, locked_backend>::consume(NodeChain<T> chain, OutputIt out) {
+  const auto received = latency.now();
+  NodeChain<T> delivered;
+  try {
+    while (not chain.empty()) {
+      Node<T>* node = chain.first;
+      latency.record(nodes.sent(node), received);
+      *out = std::move(node->value);
+      node->value.~T();
+      delivered.push_back(chain.pop_front());
+      ++out;
+    }
+  }
+  catch (...) {
+    counters.received(delivered.size);
+    nodes.release(delivered);
+    requeue(chain);
+    throw;
+  }
+
+  counters.received(delivered.size);
+  nodes.release(delivered);
+  return delivered.size;
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, locked_backend>::requeue(NodeChain<T> chain) {
+  if (chain.empty()) {
+    return;
+  }
+
+  std::lock_guard lock{mutex};
+  chain.append(queue);
+  queue = chain;
+  queued.store(queue.size, std::memory_order_relaxed);
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, locked_backend>::receive_many(OutputIt out, std::size_t max) {
+  if (0 == max) {
+    return 0;
+  }
+
+  if (discarding()) {
+    return 0;
+  }
+
+  wait_ready();
+
+  std::unique_lock lock(mutex);
+
+  if (queue.empty() or discarding()) {
+    return 0;
+  }
+
+  NodeChain<T> batch = take(max);
+  queued.store(queue.size, std::memory_order_relaxed);
+  lock.unlock();
+
+  return consume(batch, out);
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, locked_backend>::try_receive_many(OutputIt out, std::size_t max) {
+  if (0 == max or 0 == queued.load(std::memory_order_relaxed)) {
+    return 0;
+  }
+
+  std::unique_lock lock(mutex);
+
+  if (queue.empty() or discarding()) {
+    return 0;
+  }
+
+  NodeChain<T> batch = take(max);
+  queued.store(queue.size, std::memory_order_relaxed);
+  lock.unlock();
+
+  return consume(batch, out);
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, locked_backend>::close() {
+  {
+    std::lock_guard lock{mutex};
+    _closed.store(true, std::memory_order_relaxed);
+  }
+  wake_receiver();
+}
+
+template <typename T, typename Policy>
+bool detail::Channel<T, Policy, locked_backend>::closed() const {
+  return _closed.load(std::memory_order_acquire);
+}
+
+template <typename T, typename Policy>
+detail::SegmentQueue<T, Policy>::~SegmentQueue() {
+  for (Segment* list : {head, spares}) {
+    while (nullptr != list) {
+      deallocate(std::exchange(list, list->next));
+    }
+  }
+}
+
+template <typename T, typename Policy>
+void detail::SegmentQueue<T, Policy>::deallocate(Segment* segment) noexcept {
+  traits::destroy(allocator, segment);
+  traits::deallocate(allocator, segment, 1);
+}
+
+template <typename T, typename Policy>
+void detail::SegmentQueue<T, Policy>::grow() {
+  Segment* segment = spares;
+  if (nullptr != segment) {
+    spares        = segment->next;
+    segment->next = nullptr;
+  }
+  else {
+    segment = traits::allocate(allocator, 1);
+    traits::construct(allocator, segment);
+  }
+
+  if (nullptr == tail) {
+    head  = segment;
+    first = 0;
+  }
+  else {
+    tail->next = segment;
+  }
+  tail = segment;
+  end  = 0;
+}
+
+template <typename T, typename Policy>
+void detail::SegmentQueue<T, Policy>::advance() noexcept {
+  if (head != tail and Segment::capacity == first) {
+    Segment* drained = std::exchange(head, head->next);
+    first            = 0;
+    if (Policy::recycle_nodes or nullptr == spares) {
+      drained->next = spares;
+      spares        = drained;
+    }
+    else {
+      deallocate(drained);
+    }
+  }
+  else if (0 == count) {
+    first = end = 0;
+  }
+}
+
+template <typename T, typename Policy>
+void detail::SegmentQueue<T, Policy>::push(const T& value) {
+  if (nullptr == tail or Segment::capacity == end) {
+    grow();
+  }
+  std::memcpy(static_cast<void*>(tail->values() + end++), std::addressof(value), sizeof(T));
+  ++count;
+}
+
+template <typename T, typename Policy>
+template <typename InputIt>
+void detail::SegmentQueue<T, Policy>::append(InputIt first_value, InputIt last_value) {
+  if constexpr (is_move_iterator<InputIt>::value) {
+    // Moving a trivial value copies it.
+    append(first_value.base(), last_value.base());
+  }
+  else if constexpr (contiguous_iterator_of<InputIt, T>) {
+    const T* values   = std::to_address(first_value);
+    std::size_t left  = static_cast<std::size_t>(last_value - first_value);
+    while (0 != left) {
+      if (nullptr == tail or Segment::capacity == end) {
+        grow();
+      }
+      const std::size_t block = std::min(left, Segment::capacity - end);
+      std::memcpy(static_cast<void*>(tail->values() + end), values, block * sizeof(T));
+      end += block;
+      count += block;
+      values += block;
+      left -= block;
+    }
+  }
+  else {
+    for (; first_value != last_value; ++first_value) {
+      push(*first_value);
+    }
+  }
+}
+
+template <typename T, typename Policy>
+T detail::SegmentQueue<T, Policy>::pop() noexcept {
+  T value = std::move(head->values()[first++]);
+  --count;
+  advance();
+  return value;
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+OutputIt detail::SegmentQueue<T, Policy>::take(OutputIt out, std::size_t max) {
+  for (std::size_t left = std::min(max, count); 0 != left;) {
+    const std::size_t block = std::min(left, (head == tail ? end : Segment::capacity) - first);
+    T* values               = head->values() + first;
+    if constexpr (contiguous_iterator_of<OutputIt, T>) {
+      std::memcpy(static_cast<void*>(std::to_address(out)), values, block * sizeof(T));
+      out += static_cast<std::iter_difference_t<OutputIt>>(block);
+    }
+    else {
+      out = std::move(values, values + block, out);
+    }
+    first += block;
+    count -= block;
+    left -= block;
+    advance();
+  }
+  return out;
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, detail::segmented_backend>::publish(std::unique_lock<std::mutex>& lock, std::size_t sent) {
+  counters.sent(sent);
+  queued.store(queue.size(), std::memory_order_relaxed);
+  lock.unlock();
+
+  if (0 != sent) {
+    wake_receiver(sent);
+  }
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, detail::segmented_backend>::send(const T& value) {
+  std::unique_lock lock(mutex);
+  if (_closed) {
+    throw channel_closed_exception();
+  }
+
+  queue.push(value);
+  publish(lock, 1);
+}
+
+template <typename T, typename Policy>
+template <typename U>
+send_status detail::Channel<T, Policy, detail::segmented_backend>::try_send(U&& value, std::nothrow_t) {
+  if (_closed.load(std::memory_order_acquire)) {
+    return send_status::closed;
+  }
+
+  std::unique_lock lock(mutex);
+  if (_closed) {
+    return send_status::closed;
+  }
+
+  // Whatever the allocator throws for a new segment means there's no room.
+  try {
+    queue.push(value);
+  }
+  catch (...) {
+    return send_status::full;
+  }
+  publish(lock, 1);
+  return send_status::sent;
+}
+
+template <typename T, typename Policy>
+template <typename InputIt>
+void detail::Channel<T, Policy, detail::segmented_backend>::send_range(InputIt first, InputIt last) {
+  std::unique_lock lock(mutex);
+  if (_closed) {
+    throw channel_closed_exception();
+  }
+
+  const std::size_t before = queue.size();
+  send_then_commit([&] { queue.append(first, last); }, [&] { publish(lock, queue.size() - before); });
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, detail::segmented_backend>::wait_ready() {
+  const auto ready = [this] { return this->ready(); };
+  counters.wait(ready, [&] { parker.park_until(ready); });
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+bool detail::Channel<T, Policy, detail::segmented_backend>::wait_ready(
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  const auto ready = [this] { return this->ready(); };
+  return counters.wait(ready, [&] { return parker.park_until(ready, deadline); });
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, detail::segmented_backend>::wake_receiver(std::size_t sent) {
+  const bool parked = parker.unpark(sent);
+  if (hook.notify() or parked) {
+    counters.notified();
+  }
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, detail::segmented_backend>::receive() {
+  if (discarding()) {
+    return std::nullopt;
+  }
+
+  wait_ready();
+  return pop_ready();
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+std::optional<T> detail::Channel<T, Policy, detail::segmented_backend>::receive_until(
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  if (discarding() or not wait_ready(deadline)) {
+    return std::nullopt;
+  }
+
+  return pop_ready();
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, detail::segmented_backend>::pop_ready() {
+  std::lock_guard lock(mutex);
+
+  if (queue.empty() or discarding()) {
+    return {};
+  }
+
+  const T value = queue.pop();
+  queued.store(queue.size(), std::memory_order_relaxed);
+  counters.received(1);
+  return value;
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, detail::segmented_backend>::try_receive() {
+  // Polling an empty channel doesn't touch the mutex.
+  if (0 == queued.load(std::memory_order_relaxed)) {
+    return {};
+  }
+
+  return pop_ready();
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, detail::segmented_backend>::take(OutputIt out, std::size_t max) {
+  if constexpr (is_vector_appender<OutputIt>::value and std::is_default_constructible_v<T>) {
+    std::vector<T>& values = out.container();
+    const std::size_t size = values.size();
+    values.resize(size + std::min(max, queue.size()));
+    return take(values.data() + size, max);
+  }
+  else {
+    const std::size_t before = queue.size();
+    try {
+      queue.take(out, max);
+    }
+    catch (...) {
+      // An output iterator which throws keeps what it was given so far.
+      queued.store(queue.size(), std::memory_order_relaxed);
+      counters.received(before - queue.size());
+      throw;
+    }
+    queued.store(queue.size(), std::memory_order_relaxed);
+    counters.received(before - queue.size());
+    return before - queue.size();
+  }
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, detail::segmented_backend>::receive_many(OutputIt out, std::size_t max) {
+  if (0 == max) {
+    return 0;
+  }
+
+  if (discarding()) {
+    return 0;
+  }
+
+  wait_ready();
+
+  std::lock_guard lock(mutex);
+
+  if (queue.empty() or discarding()) {
+    return 0;
+  }
+
+  return take(out, max);
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, detail::segmented_backend>::try_receive_many(OutputIt out, std::size_t max) {
+  if (0 == max or 0 == queued.load(std::memory_order_relaxed)) {
+    return 0;
+  }
+
+  std::lock_guard lock(mutex);
+
+  if (queue.empty() or discarding()) {
+    return 0;
+  }
+
+  return take(out, max);
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, detail::segmented_backend>::close() {
+  {
+    std::lock_guard lock{mutex};
+    _closed.store(true, std::memory_order_relaxed);
+  }
+  wake_receiver();
+}
+
+template <typename T, typename Policy>
+bool detail::Channel<T, Policy, detail::segmented_backend>::closed() const {
+  return _closed.load(std::memory_order_acquire);
+}
+
+template <typename T, typename Policy>
+void detail::NodeQueue<T, Policy>::init(Node<T>* stub) noexcept {
+  head.store(stub, std::memory_order_relaxed);
+  tail.store(stub, std::memory_order_relaxed);
+}
+
+template <typename T, typename Policy>
+void detail::NodeQueue<T, Policy>::clear(NodeAllocator<T, Policy>& nodes) noexcept {
+  Node<T>* stub = tail.load(std::memory_order_relaxed);
+  if (nullptr == stub) {
+    return;
+  }
+  for (Node<T>* next = stub->next.load(std::memory_order_acquire); nullptr != next;
+       next          = stub->next.load(std::memory_order_acquire)) {
+    next->value.~T();
+    nodes.release(stub);
+    stub = next;
+  }
+  nodes.release(stub);
+  init(nullptr);
+}
+
+template <typename T, typename Policy>
+void detail::NodeQueue<T, Policy>::link(NodeChain<T> chain) noexcept {
+  Node<T>* prev = head.exchange(chain.last, std::memory_order_acq_rel);
+  prev->next.store(chain.first, std::memory_order_release);
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::NodeQueue<T, Policy>::pop(NodeAllocator<T, Policy>& nodes,
+                                                   Latencies<Policy::trace_latency>& latency) {
+  Node<T>* const stub = tail.load(std::memory_order_relaxed);
+  Node<T>* next       = stub->next.load(std::memory_order_acquire);
+  if (nullptr == next) {
+    // Either empty, or a producer is between its exchange and its link. It will unpark us once linked.
+    return std::nullopt;
+  }
+
+  latency.record(nodes.sent(next), latency.now());
+  std::optional<T> result{std::move(next->value)};
+  next->value.~T();
+  nodes.release(stub);
+  tail.store(next, std::memory_order_relaxed);
+  return result;
+}
+
+template <typename T, typename Policy>
+bool detail::NodeQueue<T, Policy>::await_link() const noexcept {
+  Node<T>* const stub = tail.load(std::memory_order_relaxed);
+  if (head.load(std::memory_order_acquire) == stub) {
+    return false;
+  }
+
+  // The producer is between two instructions, unless it got preempted there.
+  for (unsigned spins = 0; nullptr == stub->next.load(std::memory_order_acquire); ++spins) {
+    if (spins < 64) {
+      cpu_relax();
+    }
+    else {
+      std::this_thread::yield();
+    }
+  }
+  return true;
+}
+
+template <typename T, typename Policy>
+detail::Channel<T, Policy, lock_free_backend>::~Channel() {
+  queue.clear(nodes);
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, lock_free_backend>::link(NodeChain<T> chain) {
+  counters.sent(chain.size);
+  queue.link(chain);
+  wake_receiver(chain.size);
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, lock_free_backend>::wake_receiver(std::size_t sent) {
+  const bool parked = parker.unpark(sent);
+  if (hook.notify() or parked) {
+    counters.notified();
+  }
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, lock_free_backend>::wait_ready() {
+  const auto ready = [this] { return this->ready(); };
+  counters.wait(ready, [&] { parker.park_until(ready); });
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+bool detail::Channel<T, Policy, lock_free_backend>::wait_ready(
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  const auto ready = [this] { return this->ready(); };
+  return counters.wait(ready, [&] { return parker.park_until(ready, deadline); });
+}
+
+template <typename T, typename Policy>
+template <typename... Args>
+void detail::Channel<T, Policy, lock_free_backend>::push(Args&&... args) {
+  Node<T>* node = nodes.make(std::forward<Args>(args)...);
+  link(NodeChain<T>{node, node, 1});
+}
+
+template <typename T, typename Policy>
+template <typename InputIt>
+void detail::Channel<T, Policy, lock_free_backend>::send_range(InputIt first, InputIt last) {
+  if (_closed.load(std::memory_order_acquire)) {
+    throw channel_closed_exception();
+  }
+
+  NodeChain<T> batch = nodes.make_chain(first, last);
+
+  if (not batch.empty()) {
+    link(batch);
+  }
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, lock_free_backend>::pop() {
+  std::optional<T> result = queue.pop(nodes, latency);
+  if (result.has_value()) {
+    counters.received(1);
+  }
+  return result;
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, lock_free_backend>::send(T&& value) {
+  emplace(std::move(value));
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, lock_free_backend>::send(const T& value) {
+  emplace(value);
+}
+
+template <typename T, typename Policy>
+template <typename... Args>
+void detail::Channel<T, Policy, lock_free_backend>::emplace(Args&&... args) {
+  if (_closed.load(std::memory_order_acquire)) {
+    throw channel_closed_exception();
+  }
+
+  push(std::forward<Args>(args)...);
+}
+
+template <typename T, typename Policy>
+template <typename U>
+send_status detail::Channel<T, Policy, lock_free_backend>::try_send(U&& value, std::nothrow_t) {
+  if (_closed.load(std::memory_order_acquire)) {
+    return send_status::closed;
+  }
+
+  Node<T>* node = nodes.try_make_empty();
+  if (nullptr == node) {
+    return send_status::full;
+  }
+  link(NodeChain<T>{nodes.construct(node, std::forward<U>(value)), node, 1});
+  return send_status::sent;
+}
+
+template <typename T, typename Policy>
+template <typename... Args>
+typename detail::Channel<T, Policy, lock_free_backend>::reservation_type
+detail::Channel<T, Policy, lock_free_backend>::reserve(Args&&... args) {
+  if (_closed.load(std::memory_order_acquire)) {
+    throw channel_closed_exception();
+  }
+
+  return nodes.make(std::forward<Args>(args)...);
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, lock_free_backend>::commit(reservation_type reservation) {
+  if (_closed.load(std::memory_order_acquire)) {
+    nodes.destroy(reservation);
+    throw channel_closed_exception();
+  }
+
+  nodes.stamp(reservation);
+  link(NodeChain<T>{reservation, reservation, 1});
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, lock_free_backend>::receive() {
+  return PollingReceive::one(*this);
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+std::optional<T> detail::Channel<T, Policy, lock_free_backend>::receive_until(
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  return PollingReceive::one_until(*this, deadline);
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, lock_free_backend>::try_receive() {
+  if (exhausted()) {
+    return {};
+  }
+
+  if (auto result = pop(); result.has_value() or not queue.await_link()) {
+    return result;
+  }
+  return pop();
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, lock_free_backend>::pop_many(OutputIt out, std::size_t max) {
+  std::size_t received = 0;
+  for (; received < max; ++received) {
+    std::optional<T> value = pop();
+    if (not value.has_value()) {
+      break;
+    }
+    *out = std::move(value.value());
+    ++out;
+  }
+  return received;
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, lock_free_backend>::receive_many(OutputIt out, std::size_t max) {
+  return PollingReceive::many(*this, out, max);
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, lock_free_backend>::try_receive_many(OutputIt out, std::size_t max) {
+  if (0 == max or exhausted()) {
+    return 0;
+  }
+
+  if (const auto received = pop_many(out, max); received > 0 or not queue.await_link()) {
+    return received;
+  }
+  return pop_many(out, max);
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, lock_free_backend>::close() {
+  _closed.store(true, std::memory_order_release);
+  wake_receiver();
+}
+
+template <typename T, typename Policy>
+bool detail::Channel<T, Policy, lock_free_backend>::closed() const {
+  return _closed.load(std::memory_order_acquire);
+}
+
+template <typename T, typename Policy>
+detail::Channel<T, Policy, bounded_backend>::Channel(std::size_t capacity)
+  : slots{new Slot[ring_size(capacity)]}
+  , mask{ring_size(capacity) - 1}
+  , _capacity{capacity} {}
+
+template <typename T, typename Policy>
+detail::Channel<T, Policy, bounded_backend>::~Channel() {
+  for (; count > 0; --count, ++first) {
+    if (SlotState::discarded != slots[first & mask].state) {
+      slots[first & mask].value.~T();
+    }
+  }
+}
+
+template <typename T, typename Policy>
+std::size_t detail::Channel<T, Policy, bounded_backend>::ring_size(std::size_t capacity) {
+  std::size_t size = 1;
+  while (size < capacity) {
+    size <<= 1;
+  }
+  return size;
+}
+
+template <typename T, typename Policy>
+bool detail::Channel<T, Policy, bounded_backend>::front_ready() noexcept {
+  while (count > 0 and SlotState::discarded == slots[first & mask].state) {
+    ++first;
+    --count;
+  }
+  return count > 0 and SlotState::ready == slots[first & mask].state;
+}
+
+template <typename T, typename Policy>
+bool detail::Channel<T, Policy, bounded_backend>::wait_for_room(std::unique_lock<std::mutex>& lock) {
+  if (full() and not _closed) {
+    ++waiting_senders;
+    not_full.wait(lock, [this] { return not full() or _closed; });
+    --waiting_senders;
+  }
+  return not _closed;
+}
+
+template <typename T, typename Policy>
+template <typename... Args>
+void detail::Channel<T, Policy, bounded_backend>::place(Args&&... args) {
+  Slot& slot = slots[(first + count) & mask];
+  ::new (static_cast<void*>(&slot.value)) T(std::forward<Args>(args)...);
+  slot.state = SlotState::ready;
+  ++count;
+  counters.sent(1);
+}
+
+template <typename T, typename Policy>
+template <typename U>
+void detail::Channel<T, Policy, bounded_backend>::push(std::unique_lock<std::mutex>& lock, U&& value) {
+  place(std::forward<U>(value));
+  notify_receiver(lock);
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, bounded_backend>::notify_receiver(std::unique_lock<std::mutex>& lock) {
+  const bool wake_receiver = need_notify and front_ready() and (count >= wake_after or full());
+  need_notify              = need_notify and not wake_receiver;
+  lock.unlock();
+
+  if (wake_receiver) {
+    counters.notified();
+    not_empty.notify_one();
+  }
+  notify_hook();
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, bounded_backend>::notify_hook() {
+  if (hook.notify()) {
+    counters.notified();
+  }
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, bounded_backend>::wait_ready(std::unique_lock<std::mutex>& lock) {
+  using WaitStrategy = typename Policy::wait_strategy;
+
+  need_notify      = true;
+  const auto ready = [this] { return front_ready() or _closed; };
+  counters.wait(ready, [&] {
+    if constexpr (WaitStrategy::notify_every > 1) {
+      // Wait for a batch, or for the idle timeout; an idle channel then wakes the receiver with its next value.
+      wake_after = WaitStrategy::notify_every;
+      const bool batch = not_empty.wait_until(lock, std::chrono::steady_clock::now() + WaitStrategy::idle_timeout, ready);
+      wake_after       = 1;
+      if (batch) {
+        return;
+      }
+    }
+    not_empty.wait(lock, ready);
+  });
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+bool detail::Channel<T, Policy, bounded_backend>::wait_ready(std::unique_lock<std::mutex>& lock,
+                                                             const std::chrono::time_point<Clock, Duration>& deadline) {
+  need_notify      = true;
+  const auto ready = [this] { return front_ready() or _closed; };
+  if (not counters.wait(ready, [&] { return not_empty.wait_until(lock, deadline, ready); })) {
+    need_notify = false;
+    return false;
+  }
+  return true;
+}
+
+template <typename T, typename Policy>
+T detail::Channel<T, Policy, bounded_backend>::pop(std::unique_lock<std::mutex>& lock) {
+  Slot& slot = slots[first & mask];
+  T result   = std::move(slot.value);
+  slot.value.~T();
+  ++first;
+  --count;
+  counters.received(1);
+
+  AsyncSendWaiter<T>* admitted = admit_async_senders();
+  if (waiting_senders > 0 or nullptr != admitted) {
+    const bool wake_senders = waiting_senders > 0;
+    lock.unlock();
+    if (wake_senders) {
+      not_full.notify_one();
+    }
+    wake(admitted);
+  }
+  return result;
+}
+
+template <typename T, typename Policy>
+detail::AsyncSendWaiter<T>* detail::Channel<T, Policy, bounded_backend>::admit_async_senders() noexcept {
+  AsyncSendWaiter<T>* admitted = nullptr;
+  while (nullptr != async_senders and not full()) {
+    AsyncSendWaiter<T>* waiter = std::exchange(async_senders, async_senders->next);
+    try {
+      place(std::move(waiter->value));
+    }
+    catch (...) {
+      waiter->error = std::current_exception();
+    }
+    waiter->next = std::exchange(admitted, waiter);
+  }
+  if (nullptr == async_senders) {
+    async_senders_last = nullptr;
+  }
+  return admitted;
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, bounded_backend>::wake(AsyncSendWaiter<T>* waiters) {
+  while (nullptr != waiters) {
+    // Read `next` first: a woken coroutine may resume (and destroy its waiter) right away.
+    std::exchange(waiters, waiters->next)->wake();
+  }
+}
+
+template <typename T, typename Policy>
+bool detail::Channel<T, Policy, bounded_backend>::send_or_wait(AsyncSendWaiter<T>& waiter) {
+  std::unique_lock lock(mutex);
+  if (_closed) {
+    waiter.closed = true;
+    return false;
+  }
+  if (not full() and nullptr == async_senders) {
+    push(lock, std::move(waiter.value));
+    return false;
+  }
+
+  if (nullptr == async_senders) {
+    async_senders = &waiter;
+  }
+  else {
+    async_senders_last->next = &waiter;
+  }
+  async_senders_last = &waiter;
+  return true;
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, bounded_backend>::send(T&& value) {
+  emplace(std::move(value));
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, bounded_backend>::send(const T& value) {
+  emplace(value);
+}
+
+template <typename T, typename Policy>
+template <typename... Args>
+void detail::Channel<T, Policy, bounded_backend>::emplace(Args&&... args) {
+  std::unique_lock lock(mutex);
+  if (not wait_for_room(lock)) {
+    throw channel_closed_exception();
+  }
+
+  place(std::forward<Args>(args)...);
+  notify_receiver(lock);
+}
+
+template <typename T, typename Policy>
+template <typename InputIt>
+void detail::Channel<T, Policy, bounded_backend>::send_range(InputIt from, InputIt to) {
+  std::unique_lock lock(mutex);
+  if (_closed) {
+    throw channel_closed_exception();
+  }
+
+  const auto send = [&] {
+    for (; from != to; ++from) {
+      if (full()) {
+        // Let the receiver drain what is in the ring so far before waiting for room.
+        if (need_notify and front_ready()) {
+          need_notify = false;
+          counters.notified();
+          not_empty.notify_one();
+        }
+        lock.unlock();
+        notify_hook();
+        lock.lock();
+        if (not wait_for_room(lock)) {
+          throw channel_closed_exception();
+        }
+      }
+
+      place(*from);
+    }
+  };
+  // What was placed is sent, also before an exception: wake the receiver up for it.
+  send_then_commit(send, [&] {
+    if (lock.owns_lock()) {
+      notify_receiver(lock);
+    }
+  });
+}
+
+template <typename T, typename Policy>
+template <typename... Args>
+typename detail::Channel<T, Policy, bounded_backend>::reservation_type
+detail::Channel<T, Policy, bounded_backend>::reserve(Args&&... args) {
+  std::unique_lock lock(mutex);
+  if (not wait_for_room(lock)) {
+    throw channel_closed_exception();
+  }
+
+  const reservation_type position = first + count;
+  slots[position & mask].state    = SlotState::reserved;
+  ++count;
+  lock.unlock();
+
+  // Nobody else touches a reserved slot, so the value can be constructed without the lock.
+  try {
+    ::new (static_cast<void*>(&slots[position & mask].value)) T(std::forward<Args>(args)...);
+  }
+  catch (...) {
+    lock.lock();
+    slots[position & mask].state = SlotState::discarded;
+    throw;
+  }
+  return position;
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, bounded_backend>::commit(reservation_type position) {
+  std::unique_lock lock(mutex);
+  if (_closed) {
+    slots[position & mask].value.~T();
+    slots[position & mask].state = SlotState::discarded;
+    throw channel_closed_exception();
+  }
+
+  slots[position & mask].state = SlotState::ready;
+  counters.sent(1);
+  notify_receiver(lock);
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, bounded_backend>::discard(reservation_type position) {
+  std::unique_lock lock(mutex);
+  slots[position & mask].value.~T();
+  slots[position & mask].state = SlotState::discarded;
+
+  // The discarded slot may have been holding back the receiver, and reclaiming it makes room.
+  const std::size_t occupied = count;
+  front_ready();
+  const bool wake_senders      = count < occupied and waiting_senders > 0;
+  AsyncSendWaiter<T>* admitted = admit_async_senders();
+  const bool wake_receiver     = need_notify and front_ready();
+  need_notify                  = need_notify and not wake_receiver;
+  lock.unlock();
+
+  if (wake_receiver) {
+    counters.notified();
+    not_empty.notify_one();
+  }
+  if (wake_senders) {
+    not_full.notify_all();
+  }
+  wake(admitted);
+  notify_hook();
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, bounded_backend>::try_send(T&& value) {
+  std::unique_lock lock(mutex);
+  if (_closed) {
+    throw channel_closed_exception();
+  }
+  if (full()) {
+    return {std::move(value)};
+  }
+
+  push(lock, std::move(value));
+  return std::nullopt;
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, bounded_backend>::try_send(const T& value) {
+  std::unique_lock lock(mutex);
+  if (_closed) {
+    throw channel_closed_exception();
+  }
+  if (full()) {
+    return {value};
+  }
+
+  push(lock, value);
+  return std::nullopt;
+}
+
+template <typename T, typename Policy>
+template <typename U>
+send_status detail::Channel<T, Policy, bounded_backend>::try_send(U&& value, std::nothrow_t) {
+  std::unique_lock lock(mutex);
+  if (_closed) {
+    return send_status::closed;
+  }
+  if (full()) {
+    return send_status::full;
+  }
+
+  push(lock, std::forward<U>(value));
+  return send_status::sent;
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+std::optional<T> detail::Channel<T, Policy, bounded_backend>::send_until(
+    T&& value,
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  std::unique_lock lock(mutex);
+  if (full() and not _closed) {
+    ++waiting_senders;
+    const bool ready = not_full.wait_until(lock, deadline, [this] { return not full() or _closed; });
+    --waiting_senders;
+    if (not ready) {
+      return {std::move(value)};
+    }
+  }
+  if (_closed) {
+    throw channel_closed_exception();
+  }
+
+  push(lock, std::move(value));
+  return std::nullopt;
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+std::optional<T> detail::Channel<T, Policy, bounded_backend>::send_until(
+    const T& value,
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  std::unique_lock lock(mutex);
+  if (full() and not _closed) {
+    ++waiting_senders;
+    const bool ready = not_full.wait_until(lock, deadline, [this] { return not full() or _closed; });
+    --waiting_senders;
+    if (not ready) {
+      return {value};
+    }
+  }
+  if (_closed) {
+    throw channel_closed_exception();
+  }
+
+  push(lock, value);
+  return std::nullopt;
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, bounded_backend>::receive() {
+  std::unique_lock lock(mutex);
+
+  if (finished()) {
+    return std::nullopt;
+  }
+
+  if (not front_ready()) {
+    wait_ready(lock);
+  }
+
+  if (finished()) {
+    return {};
+  }
+
+  return {pop(lock)};
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+std::optional<T> detail::Channel<T, Policy, bounded_backend>::receive_until(
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  std::unique_lock lock(mutex);
+
+  if (finished()) {
+    return std::nullopt;
+  }
+
+  if (not front_ready() and not wait_ready(lock, deadline)) {
+    return std::nullopt;
+  }
+
+  if (finished()) {
+    return {};
+  }
+
+  return {pop(lock)};
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, bounded_backend>::try_receive() {
+  std::unique_lock lock(mutex);
+
+  if (finished() or not front_ready()) {
+    return {};
+  }
+
+  return {pop(lock)};
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, bounded_backend>::pop_many(std::unique_lock<std::mutex>& lock,
+                                                                 OutputIt out,
+                                                                 std::size_t max) {
+  std::size_t received = 0;
+  for (; received < max and front_ready(); ++received, ++first, --count) {
+    Slot& slot = slots[first & mask];
+    *out       = std::move(slot.value);
+    ++out;
+    slot.value.~T();
+  }
+  counters.received(received);
+
+  AsyncSendWaiter<T>* admitted = admit_async_senders();
+  if (received > 0 and (waiting_senders > 0 or nullptr != admitted)) {
+    const bool wake_senders = waiting_senders > 0;
+    lock.unlock();
+    if (wake_senders) {
+      not_full.notify_all();
+    }
+    wake(admitted);
+  }
+  return received;
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, bounded_backend>::receive_many(OutputIt out, std::size_t max) {
+  if (0 == max) {
+    return 0;
+  }
+
+  std::unique_lock lock(mutex);
+
+  if (finished()) {
+    return 0;
+  }
+
+  if (not front_ready()) {
+    wait_ready(lock);
+  }
+
+  if (finished()) {
+    return 0;
+  }
+
+  return pop_many(lock, out, max);
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, bounded_backend>::try_receive_many(OutputIt out, std::size_t max) {
+  std::unique_lock lock(mutex);
+
+  if (finished()) {
+    return 0;
+  }
+
+  return pop_many(lock, out, max);
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, bounded_backend>::close() {
+  std::unique_lock lock{mutex};
+
+  _closed                  = true;
+  const bool wake_senders  = waiting_senders > 0;
+  const bool wake_receiver = need_notify;
+  need_notify              = false;
+
+  AsyncSendWaiter<T>* refused = std::exchange(async_senders, nullptr);
+  async_senders_last          = nullptr;
+  for (AsyncSendWaiter<T>* waiter = refused; nullptr != waiter; waiter = waiter->next) {
+    waiter->closed = true;
+  }
+  lock.unlock();
+
+  if (wake_receiver) {
+    counters.notified();
+    not_empty.notify_one();
+  }
+  if (wake_senders) {
+    not_full.notify_all();
+  }
+  wake(refused);
+  notify_hook();
+}
+
+template <typename T, typename Policy>
+bool detail::Channel<T, Policy, bounded_backend>::ready() {
+  std::lock_guard lock{mutex};
+
+  return front_ready() or _closed;
+}
+
+template <typename T, typename Policy>
+bool detail::Channel<T, Policy, bounded_backend>::closed() const {
+  std::unique_lock lock{mutex};
+
+  return _closed;
+}
+
+template <typename T, typename Policy>
+detail::Channel<T, Policy, spsc_backend>::Channel(std::size_t capacity)
+  : slots{new Slot[std::bit_ceil(capacity)]}
+  , mask{std::bit_ceil(capacity) - 1}
+  , _capacity{capacity} {}
+
+template <typename T, typename Policy>
+detail::Channel<T, Policy, spsc_backend>::~Channel() {
+  const std::size_t end = tail.load(std::memory_order_relaxed);
+  for (std::size_t position = head.load(std::memory_order_relaxed); position != end; ++position) {
+    slots[position & mask].value.~T();
+  }
+}
+
+template <typename T, typename Policy>
+bool detail::Channel<T, Policy, spsc_backend>::has_room(std::size_t position) noexcept {
+  if (position - cached_head < _capacity) {
+    return true;
+  }
+  cached_head = head.load(std::memory_order_acquire);
+  return position - cached_head < _capacity;
+}
+
+template <typename T, typename Policy>
+bool detail::Channel<T, Policy, spsc_backend>::wait_for_room(std::size_t position) {
+  if (not has_room(position)) {
+    sender_parker.park_until([&] { return has_room(position) or _closed.load(std::memory_order_acquire); });
+  }
+  return not _closed.load(std::memory_order_acquire);
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+bool detail::Channel<T, Policy, spsc_backend>::wait_for_room(std::size_t position,
+                                                             const std::chrono::time_point<Clock, Duration>& deadline) {
+  return has_room(position) or
+         sender_parker.park_until([&] { return has_room(position) or _closed.load(std::memory_order_acquire); },
+                                  deadline);
+}
+
+template <typename T, typename Policy>
+template <typename... Args>
+void detail::Channel<T, Policy, spsc_backend>::place(std::size_t position, Args&&... args) {
+  ::new (static_cast<void*>(&slots[position & mask].value)) T(std::forward<Args>(args)...);
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, spsc_backend>::publish(std::size_t position) {
+  const std::size_t sent = position - tail.load(std::memory_order_relaxed);
+  counters.sent(sent);
+  tail.store(position, std::memory_order_release);
+  wake_receiver(sent);
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, spsc_backend>::wake_receiver(std::size_t sent) {
+  const bool parked = receiver_parker.unpark(sent);
+  if (hook.notify() or parked) {
+    counters.notified();
+  }
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, spsc_backend>::send(T&& value) {
+  emplace(std::move(value));
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, spsc_backend>::send(const T& value) {
+  emplace(value);
+}
+
+template <typename T, typename Policy>
+template <typename... Args>
+void detail::Channel<T, Policy, spsc_backend>::emplace(Args&&... args) {
+  const std::size_t position = tail.load(std::memory_order_relaxed);
+  if (_closed.load(std::memory_order_acquire) or not wait_for_room(position)) {
+    throw channel_closed_exception();
+  }
+
+  place(position, std::forward<Args>(args)...);
+  publish(position + 1);
+}
+
+template <typename T, typename Policy>
+template <typename InputIt>
+void detail::Channel<T, Policy, spsc_backend>::send_range(InputIt first, InputIt last) {
+  if (_closed.load(std::memory_order_acquire)) {
+    throw channel_closed_exception();
+  }
+
+  std::size_t published = tail.load(std::memory_order_relaxed);
+  std::size_t position  = published;
+  const auto publish_placed = [&] {
+    if (position != published) {
+      publish(position);
+      published = position;
+    }
+  };
+  const auto send = [&] {
+    for (; first != last; ++first, ++position) {
+      if (not has_room(position)) {
+        // Let the receiver drain what is in the ring so far before waiting for room.
+        publish_placed();
+        if (not wait_for_room(position)) {
+          throw channel_closed_exception();
+        }
+      }
+      place(position, *first);
+    }
+  };
+  send_then_commit(send, publish_placed);
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, spsc_backend>::try_send(T&& value) {
+  if (_closed.load(std::memory_order_acquire)) {
+    throw channel_closed_exception();
+  }
+  const std::size_t position = tail.load(std::memory_order_relaxed);
+  if (not has_room(position)) {
+    return {std::move(value)};
+  }
+
+  place(position, std::move(value));
+  publish(position + 1);
+  return std::nullopt;
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, spsc_backend>::try_send(const T& value) {
+  if (_closed.load(std::memory_order_acquire)) {
+    throw channel_closed_exception();
+  }
+  const std::size_t position = tail.load(std::memory_order_relaxed);
+  if (not has_room(position)) {
+    return {value};
+  }
+
+  place(position, value);
+  publish(position + 1);
+  return std::nullopt;
+}
+
+template <typename T, typename Policy>
+template <typename U>
+send_status detail::Channel<T, Policy, spsc_backend>::try_send(U&& value, std::nothrow_t) {
+  if (_closed.load(std::memory_order_acquire)) {
+    return send_status::closed;
+  }
+  const std::size_t position = tail.load(std::memory_order_relaxed);
+  if (not has_room(position)) {
+    return send_status::full;
+  }
+
+  place(position, std::forward<U>(value));
+  publish(position + 1);
+  return send_status::sent;
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+std::optional<T> detail::Channel<T, Policy, spsc_backend>::send_until(
+    T&& value,
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  const std::size_t position = tail.load(std::memory_order_relaxed);
+  if (not _closed.load(std::memory_order_acquire) and not wait_for_room(position, deadline)) {
+    return {std::move(value)};
+  }
+  if (_closed.load(std::memory_order_acquire)) {
+    throw channel_closed_exception();
+  }
+
+  place(position, std::move(value));
+  publish(position + 1);
+  return std::nullopt;
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+std::optional<T> detail::Channel<T, Policy, spsc_backend>::send_until(
+    const T& value,
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  const std::size_t position = tail.load(std::memory_order_relaxed);
+  if (not _closed.load(std::memory_order_acquire) and not wait_for_room(position, deadline)) {
+    return {value};
+  }
+  if (_closed.load(std::memory_order_acquire)) {
+    throw channel_closed_exception();
+  }
+
+  place(position, value);
+  publish(position + 1);
+  return std::nullopt;
+}
+
+template <typename T, typename Policy>
+bool detail::Channel<T, Policy, spsc_backend>::front_ready() noexcept {
+  const std::size_t position = head.load(std::memory_order_relaxed);
+  if (position != cached_tail) {
+    return true;
+  }
+  cached_tail = tail.load(std::memory_order_acquire);
+  return position != cached_tail;
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, spsc_backend>::wait_ready() {
+  const auto ready = [this] { return this->ready(); };
+  counters.wait(ready, [&] { receiver_parker.park_until(ready); });
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+bool detail::Channel<T, Policy, spsc_backend>::wait_ready(const std::chrono::time_point<Clock, Duration>& deadline) {
+  const auto ready = [this] { return this->ready(); };
+  return counters.wait(ready, [&] { return receiver_parker.park_until(ready, deadline); });
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, spsc_backend>::pop() {
+  if (not front_ready()) {
+    return std::nullopt;
+  }
+
+  const std::size_t position = head.load(std::memory_order_relaxed);
+  Slot& slot                 = slots[position & mask];
+  std::optional<T> result{std::move(slot.value)};
+  slot.value.~T();
+  release(position + 1);
+  return result;
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, spsc_backend>::pop_many(OutputIt out, std::size_t max) {
+  const std::size_t first = head.load(std::memory_order_relaxed);
+  std::size_t position    = first;
+  try {
+    while (position - first < max) {
+      if (position == cached_tail) {
+        cached_tail = tail.load(std::memory_order_acquire);
+        if (position == cached_tail) {
+          break;
+        }
+      }
+      Slot& slot = slots[position & mask];
+      *out       = std::move(slot.value);
+      slot.value.~T();
+      ++position;
+      ++out;
+    }
+  }
+  catch (...) {
+    release(position);
+    throw;
+  }
+
+  release(position);
+  return position - first;
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, spsc_backend>::release(std::size_t position) {
+  const std::size_t received = position - head.load(std::memory_order_relaxed);
+  if (received > 0) {
+    counters.received(received);
+    head.store(position, std::memory_order_release);
+    sender_parker.unpark();
+  }
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, spsc_backend>::receive() {
+  return PollingReceive::one(*this);
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+std::optional<T> detail::Channel<T, Policy, spsc_backend>::receive_until(
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  return PollingReceive::one_until(*this, deadline);
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, spsc_backend>::try_receive() {
+  if (exhausted()) {
+    return {};
+  }
+
+  return pop();
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, spsc_backend>::receive_many(OutputIt out, std::size_t max) {
+  return PollingReceive::many(*this, out, max);
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, spsc_backend>::try_receive_many(OutputIt out, std::size_t max) {
+  if (0 == max or exhausted()) {
+    return 0;
+  }
+
+  return pop_many(out, max);
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, spsc_backend>::close() {
+  _closed.store(true, std::memory_order_release);
+  wake_receiver();
+  sender_parker.unpark();
+}
+
+template <typename T, typename Policy>
+bool detail::Channel<T, Policy, spsc_backend>::closed() const {
+  return _closed.load(std::memory_order_acquire);
+}
+
+template <typename T, typename Policy>
+detail::Channel<T, Policy, mpmc_backend>::Channel(std::size_t capacity)
+  : cells{new Cell[std::bit_ceil(std::max<std::size_t>(capacity, 2))]}
+  , mask{std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1} {
+  for (std::size_t position = 0; position <= mask; ++position) {
+    cells[position].sequence.store(position, std::memory_order_relaxed);
+  }
+}
+
+template <typename T, typename Policy>
+detail::Channel<T, Policy, mpmc_backend>::~Channel() {
+  const std::size_t end = enqueue_position.load(std::memory_order_relaxed);
+  for (std::size_t position = dequeue_position.load(std::memory_order_relaxed); position != end; ++position) {
+    Cell& cell = cells[position & mask];
+    if (cell.filled) {
+      cell.value.~T();
+    }
+  }
+}
+
+template <typename T, typename Policy>
+template <typename... Args>
+bool detail::Channel<T, Policy, mpmc_backend>::try_push(Args&&... args) {
+  std::size_t position = 0;
+  if (0 == try_claim(1, position)) {
+    return false;
+  }
+
+  fill(position, std::forward<Args>(args)...);
+  if (receivers.notify_one()) {
+    counters.notified();
+  }
+  return true;
+}
+
+template <typename T, typename Policy>
+std::size_t detail::Channel<T, Policy, mpmc_backend>::try_claim(std::size_t max, std::size_t& position) noexcept {
+  position = enqueue_position.load(std::memory_order_relaxed);
+  for (;;) {
+    // A free cell stays free until its position is claimed, so the run can't shrink before the CAS succeeds.
+    std::size_t run     = 0;
+    std::ptrdiff_t turn = 0;
+    for (; run < max; ++run) {
+      const std::size_t next = position + run;
+      turn = static_cast<std::ptrdiff_t>(cells[next & mask].sequence.load(std::memory_order_acquire) - next);
+      if (0 != turn) {
+        break;
+      }
+    }
+
+    if (0 != run) {
+      if (enqueue_position.compare_exchange_weak(position, position + run, std::memory_order_relaxed)) {
+        return run;
+      }
+    }
+    else if (turn < 0) {
+      // The cell still holds the value of a lap ago.
+      return 0;
+    }
+    else {
+      position = enqueue_position.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+template <typename T, typename Policy>
+template <typename... Args>
+void detail::Channel<T, Policy, mpmc_backend>::fill(std::size_t position, Args&&... args) {
+  Cell& cell = cells[position & mask];
+  try {
+    ::new (static_cast<void*>(&cell.value)) T(std::forward<Args>(args)...);
+  }
+  catch (...) {
+    abandon(position);
+    throw;
+  }
+  cell.filled = true;
+  counters.sent(1);
+  cell.sequence.store(position + 1, std::memory_order_release);
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, mpmc_backend>::abandon(std::size_t position) noexcept {
+  Cell& cell  = cells[position & mask];
+  cell.filled = false;
+  cell.sequence.store(position + 1, std::memory_order_release);
+}
+
+template <typename T, typename Policy>
+bool detail::Channel<T, Policy, mpmc_backend>::has_room() const noexcept {
+  const std::size_t position = enqueue_position.load(std::memory_order_relaxed);
+  return cells[position & mask].sequence.load(std::memory_order_acquire) == position;
+}
+
+template <typename T, typename Policy>
+bool detail::Channel<T, Policy, mpmc_backend>::wait_for_room() {
+  senders.wait([this] { return has_room() or _closed.load(std::memory_order_acquire); });
+  return not _closed.load(std::memory_order_acquire);
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+bool detail::Channel<T, Policy, mpmc_backend>::wait_for_room(const std::chrono::time_point<Clock, Duration>& deadline) {
+  return senders.wait_until([this] { return has_room() or _closed.load(std::memory_order_acquire); }, deadline) and
+         not _closed.load(std::memory_order_acquire);
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, mpmc_backend>::pass_on_senders() {
+  if (has_room()) {
+    senders.notify_one();
+  }
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, mpmc_backend>::send(T&& value) {
+  emplace(std::move(value));
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, mpmc_backend>::send(const T& value) {
+  emplace(value);
+}
+
+template <typename T, typename Policy>
+template <typename... Args>
+void detail::Channel<T, Policy, mpmc_backend>::emplace(Args&&... args) {
+  bool waited = false;
+  // try_push only uses `args` once it claimed a cell.
+  while (_closed.load(std::memory_order_acquire) or not try_push(std::forward<Args>(args)...)) {
+    if (not wait_for_room()) {
+      throw channel_closed_exception();
+    }
+    waited = true;
+  }
+
+  if (waited) {
+    pass_on_senders();
+  }
+}
+
+template <typename T, typename Policy>
+template <typename InputIt>
+void detail::Channel<T, Policy, mpmc_backend>::send_range(InputIt first, InputIt last) {
+  if constexpr (std::forward_iterator<InputIt>) {
+    bool waited = false;
+    for (auto left = static_cast<std::size_t>(std::distance(first, last)); 0 != left;) {
+      std::size_t position      = 0;
+      const std::size_t claimed = _closed.load(std::memory_order_acquire) ? 0 : try_claim(left, position);
+      if (0 == claimed) {
+        if (not wait_for_room()) {
+          throw channel_closed_exception();
+        }
+        waited = true;
+        continue;
+      }
+
+      for (std::size_t i = 0; i < claimed; ++i, ++first) {
+        try {
+          fill(position + i, *first);
+        }
+        catch (...) {
+          // The cells claimed after it are skipped by the receivers, which get the values filled before it.
+          for (std::size_t rest = i + 1; rest < claimed; ++rest) {
+            abandon(position + rest);
+          }
+          if (receivers.notify_one()) {
+            counters.notified();
+          }
+          throw;
+        }
+      }
+      left -= claimed;
+      if (receivers.notify_one()) {
+        counters.notified();
+      }
+    }
+
+    if (waited) {
+      pass_on_senders();
+    }
+  }
+  else {
+    for (; first != last; ++first) {
+      emplace(*first);
+    }
+  }
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, mpmc_backend>::try_send(T&& value) {
+  if (_closed.load(std::memory_order_acquire)) {
+    throw channel_closed_exception();
+  }
+  if (not try_push(std::move(value))) {
+    return {std::move(value)};
+  }
+  return std::nullopt;
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, mpmc_backend>::try_send(const T& value) {
+  if (_closed.load(std::memory_order_acquire)) {
+    throw channel_closed_exception();
+  }
+  if (not try_push(value)) {
+    return {value};
+  }
+  return std::nullopt;
+}
+
+template <typename T, typename Policy>
+template <typename U>
+send_status detail::Channel<T, Policy, mpmc_backend>::try_send(U&& value, std::nothrow_t) {
+  if (_closed.load(std::memory_order_acquire)) {
+    return send_status::closed;
+  }
+  return try_push(std::forward<U>(value)) ? send_status::sent : send_status::full;
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+std::optional<T> detail::Channel<T, Policy, mpmc_backend>::send_until(
+    T&& value,
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  bool waited = false;
+  while (_closed.load(std::memory_order_acquire) or not try_push(std::move(value))) {
+    if (not wait_for_room(deadline)) {
+      if (_closed.load(std::memory_order_acquire)) {
+        throw channel_closed_exception();
+      }
+      return {std::move(value)};
+    }
+    waited = true;
+  }
+
+  if (waited) {
+    pass_on_senders();
+  }
+  return std::nullopt;
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+std::optional<T> detail::Channel<T, Policy, mpmc_backend>::send_until(
+    const T& value,
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  bool waited = false;
+  while (_closed.load(std::memory_order_acquire) or not try_push(value)) {
+    if (not wait_for_room(deadline)) {
+      if (_closed.load(std::memory_order_acquire)) {
+        throw channel_closed_exception();
+      }
+      return {value};
+    }
+    waited = true;
+  }
+
+  if (waited) {
+    pass_on_senders();
+  }
+  return std::nullopt;
+}
+
+template <typename T, typename Policy>
+bool detail::Channel<T, Policy, mpmc_backend>::front_ready() const noexcept {
+  const std::size_t position = dequeue_position.load(std::memory_order_relaxed);
+  return cells[position & mask].sequence.load(std::memory_order_acquire) == position + 1;
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, mpmc_backend>::wait_ready() {
+  const auto ready = [this] { return this->ready(); };
+  counters.wait(ready, [&] { receivers.wait(ready); });
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+bool detail::Channel<T, Policy, mpmc_backend>::wait_ready(const std::chrono::time_point<Clock, Duration>& deadline) {
+  const auto ready = [this] { return this->ready(); };
+  return counters.wait(ready, [&] { return receivers.wait_until(ready, deadline); });
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, mpmc_backend>::pass_on_receivers() {
+  if (front_ready() and receivers.notify_one()) {
+    counters.notified();
+  }
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, mpmc_backend>::pop() {
+  for (;;) {
+    std::size_t position = dequeue_position.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &cells[position & mask];
+      const std::ptrdiff_t turn =
+          static_cast<std::ptrdiff_t>(cell->sequence.load(std::memory_order_acquire) - (position + 1));
+      if (0 == turn) {
+        if (dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      }
+      else if (turn < 0) {
+        // Not filled yet.
+        return std::nullopt;
+      }
+      else {
+        position = dequeue_position.load(std::memory_order_relaxed);
+      }
+    }
+
+    std::optional<T> result;
+    if (cell->filled) {
+      result.emplace(std::move(cell->value));
+      cell->value.~T();
+    }
+    cell->sequence.store(position + mask + 1, std::memory_order_release);
+    senders.notify_one();
+
+    if (result.has_value()) {
+      counters.received(1);
+      return result;
+    }
+  }
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, mpmc_backend>::pop_many(OutputIt out, std::size_t max) {
+  std::size_t received = 0;
+  for (; received < max; ++received) {
+    auto value = pop();
+    if (not value.has_value()) {
+      break;
+    }
+    *out = std::move(*value);
+    ++out;
+  }
+  return received;
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, mpmc_backend>::receive() {
+  for (bool waited = false; not exhausted(); waited = true) {
+    if (auto result = pop(); result.has_value()) {
+      if (waited) {
+        pass_on_receivers();
+      }
+      return result;
+    }
+
+    wait_ready();
+  }
+
+  return std::nullopt;
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+std::optional<T> detail::Channel<T, Policy, mpmc_backend>::receive_until(
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  for (bool waited = false; not exhausted(); waited = true) {
+    if (auto result = pop(); result.has_value()) {
+      if (waited) {
+        pass_on_receivers();
+      }
+      return result;
+    }
+
+    if (not wait_ready(deadline)) {
+      break;
+    }
+  }
+
+  return std::nullopt;
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, mpmc_backend>::try_receive() {
+  if (exhausted()) {
+    return {};
+  }
+
+  return pop();
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, mpmc_backend>::receive_many(OutputIt out, std::size_t max) {
+  if (0 == max) {
+    return 0;
+  }
+
+  for (bool waited = false; not exhausted(); waited = true) {
+    if (const auto received = pop_many(out, max); received > 0) {
+      if (waited) {
+        pass_on_receivers();
+      }
+      return received;
+    }
+
+    wait_ready();
+  }
+
+  return 0;
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, mpmc_backend>::try_receive_many(OutputIt out, std::size_t max) {
+  if (0 == max or exhausted()) {
+    return 0;
+  }
+
+  return pop_many(out, max);
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, mpmc_backend>::close() {
+  _closed.store(true, std::memory_order_release);
+  if (receivers.notify_all()) {
+    counters.notified();
+  }
+  senders.notify_all();
+}
+
+template <typename T, typename Policy>
+bool detail::Channel<T, Policy, mpmc_backend>::closed() const {
+  return _closed.load(std::memory_order_acquire);
+}
+
+template <typename T, typename Policy>
+detail::Channel<T, Policy, broadcast_backend>::Channel(std::size_t capacity)
+  : slots{new Slot[std::bit_ceil(capacity)]}
+  , mask{std::bit_ceil(capacity) - 1} {
+  subscriptions.reserve(1);
+  subscriptions.push_back(new Subscription<T, Policy>{*this, 0});
+}
+
+template <typename T, typename Policy>
+detail::Channel<T, Policy, broadcast_backend>::~Channel() {
+  const std::size_t end = tail.load(std::memory_order_relaxed);
+  for (std::size_t position = oldest; position != end; ++position) {
+    slots[position & mask].value.~T();
+  }
+}
+
+template <typename T, typename Policy>
+bool detail::Channel<T, Policy, broadcast_backend>::has_room(std::size_t position) {
+  if (position - slowest <= mask) {
+    return true;
+  }
+  slowest = position;
+  for (const auto* subscription : subscriptions) {
+    slowest = std::min(slowest, subscription->cursor.load(std::memory_order_acquire));
+  }
+  return position - slowest <= mask;
+}
+
+template <typename T, typename Policy>
+std::size_t detail::Channel<T, Policy, broadcast_backend>::wait_for_room(std::unique_lock<std::mutex>& lock) {
+  for (;;) {
+    if (_closed.load(std::memory_order_relaxed)) {
+      throw channel_closed_exception();
+    }
+    const std::size_t position = tail.load(std::memory_order_relaxed);
+    if (has_room(position)) {
+      return position;
+    }
+    // Subscriptions check `waiting_senders` after moving their cursor on.
+    waiting_senders.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (not has_room(position) and not _closed.load(std::memory_order_relaxed)) {
+      room.wait(lock);
+    }
+    waiting_senders.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+std::optional<std::size_t> detail::Channel<T, Policy, broadcast_backend>::wait_for_room(
+    std::unique_lock<std::mutex>& lock,
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  for (bool timed_out = false;;) {
+    if (_closed.load(std::memory_order_relaxed)) {
+      throw channel_closed_exception();
+    }
+    const std::size_t position = tail.load(std::memory_order_relaxed);
+    if (has_room(position)) {
+      return position;
+    }
+    if (timed_out) {
+      return std::nullopt;
+    }
+    waiting_senders.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    timed_out = not has_room(position) and not _closed.load(std::memory_order_relaxed) and
+                std::cv_status::timeout == room.wait_until(lock, deadline);
+    waiting_senders.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+template <typename T, typename Policy>
+template <typename... Args>
+void detail::Channel<T, Policy, broadcast_backend>::place(std::size_t position, Args&&... args) {
+  Slot& slot = slots[position & mask];
+  if (position - oldest > mask) {
+    slot.value.~T();
+    ++oldest;
+  }
+  ::new (static_cast<void*>(&slot.value)) T(std::forward<Args>(args)...);
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, broadcast_backend>::publish(std::unique_lock<std::mutex>& lock, std::size_t position) {
+  tail.store(position, std::memory_order_release);
+  lock.unlock();
+  receivers.notify_all();
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, broadcast_backend>::send(T&& value) {
+  emplace(std::move(value));
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, broadcast_backend>::send(const T& value) {
+  emplace(value);
+}
+
+template <typename T, typename Policy>
+template <typename... Args>
+void detail::Channel<T, Policy, broadcast_backend>::emplace(Args&&... args) {
+  std::unique_lock lock{mutex};
+  const std::size_t position = wait_for_room(lock);
+
+  place(position, std::forward<Args>(args)...);
+  publish(lock, position + 1);
+}
+
+template <typename T, typename Policy>
+template <typename InputIt>
+void detail::Channel<T, Policy, broadcast_backend>::send_range(InputIt first, InputIt last) {
+  std::unique_lock lock{mutex};
+  if (_closed.load(std::memory_order_relaxed)) {
+    throw channel_closed_exception();
+  }
+
+  std::size_t position = tail.load(std::memory_order_relaxed);
+  const auto send = [&] {
+    for (; first != last; ++first, ++position) {
+      if (not has_room(position)) {
+        // Let the receivers read what is in the ring so far before waiting for room.
+        if (position != tail.load(std::memory_order_relaxed)) {
+          publish(lock, position);
+          lock.lock();
+        }
+        position = wait_for_room(lock);
+      }
+      place(position, *first);
+    }
+  };
+  send_then_commit(send, [&] {
+    if (lock.owns_lock() and position != tail.load(std::memory_order_relaxed)) {
+      publish(lock, position);
+    }
+  });
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, broadcast_backend>::try_send(T&& value) {
+  std::unique_lock lock{mutex};
+  if (_closed.load(std::memory_order_relaxed)) {
+    throw channel_closed_exception();
+  }
+  const std::size_t position = tail.load(std::memory_order_relaxed);
+  if (not has_room(position)) {
+    return {std::move(value)};
+  }
+
+  place(position, std::move(value));
+  publish(lock, position + 1);
+  return std::nullopt;
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, broadcast_backend>::try_send(const T& value) {
+  std::unique_lock lock{mutex};
+  if (_closed.load(std::memory_order_relaxed)) {
+    throw channel_closed_exception();
+  }
+  const std::size_t position = tail.load(std::memory_order_relaxed);
+  if (not has_room(position)) {
+    return {value};
+  }
+
+  place(position, value);
+  publish(lock, position + 1);
+  return std::nullopt;
+}
+
+template <typename T, typename Policy>
+template <typename U>
+send_status detail::Channel<T, Policy, broadcast_backend>::try_send(U&& value, std::nothrow_t) {
+  std::unique_lock lock{mutex};
+  if (_closed.load(std::memory_order_relaxed)) {
+    return send_status::closed;
+  }
+  const std::size_t position = tail.load(std::memory_order_relaxed);
+  if (not has_room(position)) {
+    return send_status::full;
+  }
+
+  place(position, std::forward<U>(value));
+  publish(lock, position + 1);
+  return send_status::sent;
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+std::optional<T> detail::Channel<T, Policy, broadcast_backend>::send_until(
+    T&& value,
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  std::unique_lock lock{mutex};
+  const std::optional<std::size_t> position = wait_for_room(lock, deadline);
+  if (not position.has_value()) {
+    return {std::move(value)};
+  }
+
+  place(*position, std::move(value));
+  publish(lock, *position + 1);
+  return std::nullopt;
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+std::optional<T> detail::Channel<T, Policy, broadcast_backend>::send_until(
+    const T& value,
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  std::unique_lock lock{mutex};
+  const std::optional<std::size_t> position = wait_for_room(lock, deadline);
+  if (not position.has_value()) {
+    return {value};
+  }
+
+  place(*position, value);
+  publish(lock, *position + 1);
+  return std::nullopt;
+}
+
+template <typename T, typename Policy>
+detail::Subscription<T, Policy>* detail::Channel<T, Policy, broadcast_backend>::subscribe(std::size_t cursor) {
+  std::unique_ptr<Subscription<T, Policy>> subscription{new Subscription<T, Policy>{*this, cursor}};
+  {
+    std::lock_guard lock{mutex};
+    subscriptions.push_back(subscription.get());
+  }
+  owners.add_owner();
+  return subscription.release();
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, broadcast_backend>::unsubscribe(Subscription<T, Policy>& subscription) noexcept {
+  {
+    std::lock_guard lock{mutex};
+    subscriptions.erase(std::find(subscriptions.begin(), subscriptions.end(), &subscription));
+  }
+  // The slowest receiver may have gone.
+  room.notify_all();
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, broadcast_backend>::advanced() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (0 != waiting_senders.load(std::memory_order_relaxed)) {
+    // A waiting sender checks the cursors with `mutex` held before sleeping.
+    { std::lock_guard lock{mutex}; }
+    room.notify_all();
+  }
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, broadcast_backend>::close() {
+  _closed.store(true, std::memory_order_release);
+  { std::lock_guard lock{mutex}; }
+  room.notify_all();
+  receivers.notify_all();
+}
+
+template <typename T, typename Policy>
+bool detail::Channel<T, Policy, broadcast_backend>::closed() const {
+  return _closed.load(std::memory_order_acquire);
+}
+
+template <typename T, typename Policy>
+detail::Subscription<T, Policy>::~Subscription() {
+  channel.unsubscribe(*this);
+  if (channel.ownership().release()) {
+    delete &channel;
+  }
+}
+
+template <typename T, typename Policy>
+void detail::Subscription<T, Policy>::wait_ready() {
+  channel.receivers.wait([this] { return ready(); });
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+bool detail::Subscription<T, Policy>::wait_ready(const std::chrono::time_point<Clock, Duration>& deadline) {
+  return channel.receivers.wait_until([this] { return ready(); }, deadline);
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Subscription<T, Policy>::pop() {
+  const std::size_t position = cursor.load(std::memory_order_relaxed);
+  if (position == channel.tail.load(std::memory_order_acquire)) {
+    return std::nullopt;
+  }
+
+  std::optional<T> result{channel.slots[position & channel.mask].value};
+  cursor.store(position + 1, std::memory_order_release);
+  channel.advanced();
+  return result;
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Subscription<T, Policy>::pop_many(OutputIt out, std::size_t max) {
+  const std::size_t first = cursor.load(std::memory_order_relaxed);
+  const std::size_t end   = channel.tail.load(std::memory_order_acquire);
+  const std::size_t count = std::min(max, end - first);
+  if (0 == count) {
+    return 0;
+  }
+
+  for (std::size_t position = first; position != first + count; ++position) {
+    *out = channel.slots[position & channel.mask].value;
+    ++out;
+  }
+  cursor.store(first + count, std::memory_order_release);
+  channel.advanced();
+  return count;
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Subscription<T, Policy>::receive() {
+  while (not exhausted()) {
+    if (auto result = pop(); result.has_value()) {
+      return result;
+    }
+
+    wait_ready();
+  }
+
+  return std::nullopt;
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+std::optional<T> detail::Subscription<T, Policy>::receive_until(
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  while (not exhausted()) {
+    if (auto result = pop(); result.has_value()) {
+      return result;
+    }
+
+    if (not wait_ready(deadline)) {
+      break;
+    }
+  }
+
+  return std::nullopt;
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Subscription<T, Policy>::try_receive() {
+  if (exhausted()) {
+    return {};
+  }
+
+  return pop();
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Subscription<T, Policy>::receive_many(OutputIt out, std::size_t max) {
+  if (0 == max) {
+    return 0;
+  }
+
+  while (not exhausted()) {
+    if (const auto received = pop_many(out, max); received > 0) {
+      return received;
+    }
+
+    wait_ready();
+  }
+
+  return 0;
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Subscription<T, Policy>::try_receive_many(OutputIt out, std::size_t max) {
+  if (0 == max or exhausted()) {
+    return 0;
+  }
+
+  return pop_many(out, max);
+}
+
+template <typename T, typename Policy>
+detail::Channel<T, Policy, intrusive_backend>::~Channel() {
+  while (pop().has_value()) {
+  }
+}
+
+template <typename T, typename Policy>
+intrusive_hook* detail::Channel<T, Policy, intrusive_backend>::release(T&& value) {
+  if (nullptr == value) {
+    throw std::invalid_argument{"An intrusive channel can't send an empty std::unique_ptr."};
+  }
+  intrusive_hook* message = value.release();
+  message->next.store(nullptr, std::memory_order_relaxed);
+  return message;
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, intrusive_backend>::link(intrusive_hook* first, intrusive_hook* last, std::size_t count) {
+  counters.sent(count);
+  append(first, last);
+  wake_receiver(count);
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, intrusive_backend>::append(intrusive_hook* first, intrusive_hook* last) noexcept {
+  intrusive_hook* prev = head.exchange(last, std::memory_order_acq_rel);
+  prev->next.store(first, std::memory_order_release);
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, intrusive_backend>::wake_receiver(std::size_t sent) {
+  const bool parked = parker.unpark(sent);
+  if (hook.notify() or parked) {
+    counters.notified();
+  }
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, intrusive_backend>::wait_ready() {
+  const auto ready = [this] { return this->ready(); };
+  counters.wait(ready, [&] { parker.park_until(ready); });
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+bool detail::Channel<T, Policy, intrusive_backend>::wait_ready(
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  const auto ready = [this] { return this->ready(); };
+  return counters.wait(ready, [&] { return parker.park_until(ready, deadline); });
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, intrusive_backend>::send(T&& value) {
+  if (_closed.load(std::memory_order_acquire)) {
+    throw channel_closed_exception();
+  }
+
+  intrusive_hook* message = release(std::move(value));
+  link(message, message, 1);
+}
+
+template <typename T, typename Policy>
+template <typename... Args>
+void detail::Channel<T, Policy, intrusive_backend>::emplace(Args&&... args) {
+  send(T(std::forward<Args>(args)...));
+}
+
+template <typename T, typename Policy>
+template <typename U>
+send_status detail::Channel<T, Policy, intrusive_backend>::try_send(U&& value, std::nothrow_t) {
+  if (_closed.load(std::memory_order_acquire)) {
+    return send_status::closed;
+  }
+  if (nullptr == value) {
+    return send_status::invalid;
+  }
+
+  intrusive_hook* message = release(std::forward<U>(value));
+  link(message, message, 1);
+  return send_status::sent;
+}
+
+template <typename T, typename Policy>
+template <typename InputIt>
+void detail::Channel<T, Policy, intrusive_backend>::send_range(InputIt first, InputIt last) {
+  if (_closed.load(std::memory_order_acquire)) {
+    throw channel_closed_exception();
+  }
+
+  intrusive_hook* batch_first = nullptr;
+  intrusive_hook* batch_last  = nullptr;
+  std::size_t count           = 0;
+  for (; first != last; ++first, ++count) {
+    T value(*first);
+    if (nullptr == value) {
+      // The messages taken so far are destroyed, as the lock-free backend destroys its nodes.
+      for (intrusive_hook* message = batch_first; nullptr != message;) {
+        intrusive_hook* next = message->next.load(std::memory_order_relaxed);
+        const T destroyed{static_cast<message_type*>(message)};
+        message = next;
+      }
+      throw std::invalid_argument{"An intrusive channel can't send an empty std::unique_ptr."};
+    }
+    intrusive_hook* message = release(std::move(value));
+    if (nullptr == batch_last) {
+      batch_first = message;
+    }
+    else {
+      batch_last->next.store(message, std::memory_order_relaxed);
+    }
+    batch_last = message;
+  }
+
+  if (0 != count) {
+    link(batch_first, batch_last, count);
+  }
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, intrusive_backend>::pop() {
+  intrusive_hook* first = tail.load(std::memory_order_relaxed);
+  intrusive_hook* next  = first->next.load(std::memory_order_acquire);
+  if (&stub == first) {
+    if (nullptr == next) {
+      return std::nullopt;
+    }
+    // Skip the stub.
+    tail.store(next, std::memory_order_relaxed);
+    first = next;
+    next  = next->next.load(std::memory_order_acquire);
+  }
+
+  if (nullptr == next) {
+    if (head.load(std::memory_order_acquire) != first) {
+      // A producer is between its exchange and its link. It will unpark us once linked.
+      return std::nullopt;
+    }
+    // `first` is the last message: put the stub behind it, so that it can go.
+    stub.next.store(nullptr, std::memory_order_relaxed);
+    append(&stub, &stub);
+    next = first->next.load(std::memory_order_acquire);
+    if (nullptr == next) {
+      // A producer exchanged `head` before the stub got linked.
+      return std::nullopt;
+    }
+  }
+
+  tail.store(next, std::memory_order_relaxed);
+  counters.received(1);
+  return std::optional<T>{std::in_place, static_cast<message_type*>(first)};
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, intrusive_backend>::receive() {
+  return PollingReceive::one(*this);
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+std::optional<T> detail::Channel<T, Policy, intrusive_backend>::receive_until(
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  return PollingReceive::one_until(*this, deadline);
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, intrusive_backend>::try_receive() {
+  if (exhausted()) {
+    return {};
+  }
+
+  if (auto result = pop(); result.has_value() or not await_link()) {
+    return result;
+  }
+  return pop();
+}
+
+template <typename T, typename Policy>
+bool detail::Channel<T, Policy, intrusive_backend>::await_link() noexcept {
+  intrusive_hook* const first = tail.load(std::memory_order_relaxed);
+  if (head.load(std::memory_order_acquire) == first) {
+    return &stub != first;
+  }
+
+  // The producer is between two instructions, unless it got preempted there.
+  for (unsigned spins = 0; nullptr == first->next.load(std::memory_order_acquire); ++spins) {
+    if (spins < 64) {
+      cpu_relax();
+    }
+    else {
+      std::this_thread::yield();
+    }
+  }
+  return true;
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, intrusive_backend>::pop_many(OutputIt out, std::size_t max) {
+  std::size_t received = 0;
+  for (; received < max; ++received) {
+    std::optional<T> value = pop();
+    if (not value.has_value()) {
+      break;
+    }
+    *out = std::move(value.value());
+    ++out;
+  }
+  return received;
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, intrusive_backend>::receive_many(OutputIt out, std::size_t max) {
+  return PollingReceive::many(*this, out, max);
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, intrusive_backend>::try_receive_many(OutputIt out, std::size_t max) {
+  if (0 == max or exhausted()) {
+    return 0;
+  }
+
+  if (const auto received = pop_many(out, max); received > 0 or not await_link()) {
+    return received;
+  }
+  return pop_many(out, max);
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, intrusive_backend>::close() {
+  _closed.store(true, std::memory_order_release);
+  wake_receiver();
+}
+
+template <typename T, typename Policy>
+bool detail::Channel<T, Policy, intrusive_backend>::closed() const {
+  return _closed.load(std::memory_order_acquire);
+}
+
+template <typename T, typename Policy, std::size_t Lanes>
+detail::Channel<T, Policy, priority_backend<Lanes>>::Channel(const typename Policy::allocator& allocator)
+  : nodes{allocator} {
+  try {
+    for (Lane& lane : lanes) {
+      lane.init(nodes.make_empty());
+    }
+  }
+  catch (...) {
+    for (Lane& lane : lanes) {
+      lane.clear(nodes);
+    }
+    throw;
+  }
+}
+
+template <typename T, typename Policy, std::size_t Lanes>
+detail::Channel<T, Policy, priority_backend<Lanes>>::~Channel() {
+  for (Lane& lane : lanes) {
+    lane.clear(nodes);
+  }
+}
+
+template <typename T, typename Policy, std::size_t Lanes>
+typename detail::Channel<T, Policy, priority_backend<Lanes>>::Lane&
+detail::Channel<T, Policy, priority_backend<Lanes>>::lane(std::size_t priority) {
+  if (priority >= Lanes) {
+    throw std::invalid_argument{"The priority should be less than the number of lanes of the channel."};
+  }
+  return lanes[priority];
+}
+
+template <typename T, typename Policy, std::size_t Lanes>
+void detail::Channel<T, Policy, priority_backend<Lanes>>::link(Lane& lane, NodeChain<T> chain) {
+  counters.sent(chain.size);
+  lane.link(chain);
+  wake_receiver(chain.size);
+}
+
+template <typename T, typename Policy, std::size_t Lanes>
+void detail::Channel<T, Policy, priority_backend<Lanes>>::wake_receiver(std::size_t sent) {
+  const bool parked = parker.unpark(sent);
+  if (hook.notify() or parked) {
+    counters.notified();
+  }
+}
+
+template <typename T, typename Policy, std::size_t Lanes>
+void detail::Channel<T, Policy, priority_backend<Lanes>>::wait_ready() {
+  const auto ready = [this] { return this->ready(); };
+  counters.wait(ready, [&] { parker.park_until(ready); });
+}
+
+template <typename T, typename Policy, std::size_t Lanes>
+template <typename Clock, typename Duration>
+bool detail::Channel<T, Policy, priority_backend<Lanes>>::wait_ready(
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  const auto ready = [this] { return this->ready(); };
+  return counters.wait(ready, [&] { return parker.park_until(ready, deadline); });
+}
+
+template <typename T, typename Policy, std::size_t Lanes>
+template <typename... Args>
+void detail::Channel<T, Policy, priority_backend<Lanes>>::push(Lane& lane, Args&&... args) {
+  if (_closed.load(std::memory_order_acquire)) {
+    throw channel_closed_exception();
+  }
+
+  Node<T>* node = nodes.make(std::forward<Args>(args)...);
+  link(lane, NodeChain<T>{node, node, 1});
+}
+
+template <typename T, typename Policy, std::size_t Lanes>
+void detail::Channel<T, Policy, priority_backend<Lanes>>::send(T&& value, std::size_t priority) {
+  push(lane(priority), std::move(value));
+}
+
+template <typename T, typename Policy, std::size_t Lanes>
+void detail::Channel<T, Policy, priority_backend<Lanes>>::send(const T& value, std::size_t priority) {
+  push(lane(priority), value);
+}
+
+template <typename T, typename Policy, std::size_t Lanes>
+template <typename... Args>
+void detail::Channel<T, Policy, priority_backend<Lanes>>::emplace(Args&&... args) {
+  push(lanes.front(), std::forward<Args>(args)...);
+}
+
+template <typename T, typename Policy, std::size_t Lanes>
+template <typename U>
+send_status detail::Channel<T, Policy, priority_backend<Lanes>>::try_send(U&& value, std::nothrow_t) {
+  if (_closed.load(std::memory_order_acquire)) {
+    return send_status::closed;
+  }
+
+  Node<T>* node = nodes.try_make_empty();
+  if (nullptr == node) {
+    return send_status::full;
+  }
+  link(lanes.front(), NodeChain<T>{nodes.construct(node, std::forward<U>(value)), node, 1});
+  return send_status::sent;
+}
+
+template <typename T, typename Policy, std::size_t Lanes>
+template <typename InputIt>
+void detail::Channel<T, Policy, priority_backend<Lanes>>::send_range(InputIt first, InputIt last) {
+  if (_closed.load(std::memory_order_acquire)) {
+    throw channel_closed_exception();
+  }
+
+  NodeChain<T> batch = nodes.make_chain(first, last);
+
+  if (not batch.empty()) {
+    link(lanes.front(), batch);
+  }
+}
+
+template <typename T, typename Policy, std::size_t Lanes>
+std::optional<T> detail::Channel<T, Policy, priority_backend<Lanes>>::pop(Lane& lane) {
+  std::optional<T> result = lane.pop(nodes, latency);
+  if (result.has_value()) {
+    counters.received(1);
+  }
+  return result;
+}
+
+template <typename T, typename Policy, std::size_t Lanes>
+std::optional<T> detail::Channel<T, Policy, priority_backend<Lanes>>::pop() {
+  for (auto lane = lanes.rbegin(); lane != lanes.rend(); ++lane) {
+    if (auto result = pop(*lane); result.has_value()) {
+      return result;
+    }
+  }
+  return std::nullopt;
+}
+
+template <typename T, typename Policy, std::size_t Lanes>
+std::optional<T> detail::Channel<T, Policy, priority_backend<Lanes>>::receive() {
+  return PollingReceive::one(*this);
+}
+
+template <typename T, typename Policy, std::size_t Lanes>
+template <typename Clock, typename Duration>
+std::optional<T> detail::Channel<T, Policy, priority_backend<Lanes>>::receive_until(
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  return PollingReceive::one_until(*this, deadline);
+}
+
+template <typename T, typename Policy, std::size_t Lanes>
+std::optional<T> detail::Channel<T, Policy, priority_backend<Lanes>>::try_receive() {
+  if (exhausted()) {
+    return {};
+  }
+
+  if (auto result = pop(); result.has_value() or not await_link()) {
+    return result;
+  }
+  return pop();
+}
+
+template <typename T, typename Policy, std::size_t Lanes>
+bool detail::Channel<T, Policy, priority_backend<Lanes>>::await_link() noexcept {
+  return std::any_of(lanes.rbegin(), lanes.rend(), [](const Lane& lane) { return lane.await_link(); });
+}
+
+template <typename T, typename Policy, std::size_t Lanes>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, priority_backend<Lanes>>::pop_many(OutputIt out, std::size_t max) {
+  std::size_t received = 0;
+  for (auto lane = lanes.rbegin(); lane != lanes.rend() and received < max; ++lane) {
+    for (; received < max; ++received) {
+      std::optional<T> value = pop(*lane);
+      if (not value.has_value()) {
+        break;
+      }
+      *out = std::move(value.value());
+      ++out;
+    }
+  }
+  return received;
+}
+
+template <typename T, typename Policy, std::size_t Lanes>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, priority_backend<Lanes>>::receive_many(OutputIt out, std::size_t max) {
+  return PollingReceive::many(*this, out, max);
+}
+
+template <typename T, typename Policy, std::size_t Lanes>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, priority_backend<Lanes>>::try_receive_many(OutputIt out, std::size_t max) {
+  if (0 == max or exhausted()) {
+    return 0;
+  }
+
+  if (const auto received = pop_many(out, max); received > 0 or not await_link()) {
+    return received;
+  }
+  return pop_many(out, max);
+}
+
+template <typename T, typename Policy, std::size_t Lanes>
+void detail::Channel<T, Policy, priority_backend<Lanes>>::close() {
+  _closed.store(true, std::memory_order_release);
+  wake_receiver();
+}
+
+template <typename T, typename Policy, std::size_t Lanes>
+bool detail::Channel<T, Policy, priority_backend<Lanes>>::closed() const {
+  return _closed.load(std::memory_order_acquire);
+}
+
+template <typename T, typename Policy, std::size_t Shards, typename ShardOf>
+detail::Channel<T, Policy, sharded_backend<Shards, ShardOf>>::Channel(const typename Policy::allocator& allocator)
+  : nodes{allocator} {
+  try {
+    for (Shard& shard : shards) {
+      shard.init(nodes.make_empty());
+    }
+  }
+  catch (...) {
+    for (Shard& shard : shards) {
+      shard.clear(nodes);
+    }
+    throw;
+  }
+}
+
+template <typename T, typename Policy, std::size_t Shards, typename ShardOf>
+detail::Channel<T, Policy, sharded_backend<Shards, ShardOf>>::~Channel() {
+  for (Shard& shard : shards) {
+    shard.clear(nodes);
+  }
+}
+
+template <typename T, typename Policy, std::size_t Shards, typename ShardOf>
+void detail::Channel<T, Policy, sharded_backend<Shards, ShardOf>>::link(Shard& shard, NodeChain<T> chain) {
+  counters.sent(chain.size);
+  shard.link(chain);
+  wake_receiver(chain.size);
+}
+
+template <typename T, typename Policy, std::size_t Shards, typename ShardOf>
+void detail::Channel<T, Policy, sharded_backend<Shards, ShardOf>>::wake_receiver(std::size_t sent) {
+  const bool parked = parker.unpark(sent);
+  if (hook.notify() or parked) {
+    counters.notified();
+  }
+}
+
+template <typename T, typename Policy, std::size_t Shards, typename ShardOf>
+void detail::Channel<T, Policy, sharded_backend<Shards, ShardOf>>::wait_ready() {
+  const auto ready = [this] { return this->ready(); };
+  counters.wait(ready, [&] { parker.park_until(ready); });
+}
+
+template <typename T, typename Policy, std::size_t Shards, typename ShardOf>
+template <typename Clock, typename Duration>
+bool detail::Channel<T, Policy, sharded_backend<Shards, ShardOf>>::wait_ready(
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  const auto ready = [this] { return this->ready(); };
+  return counters.wait(ready, [&] { return parker.park_until(ready, deadline); });
+}
+
+template <typename T, typename Policy, std::size_t Shards, typename ShardOf>
+template <typename... Args>
+void detail::Channel<T, Policy, sharded_backend<Shards, ShardOf>>::push(Shard& shard, Args&&... args) {
+  if (_closed.load(std::memory_order_acquire)) {
+    throw channel_closed_exception();
+  }
+
+  Node<T>* node = nodes.make(std::forward<Args>(args)...);
+  link(shard, NodeChain<T>{node, node, 1});
+}
+
+template <typename T, typename Policy, std::size_t Shards, typename ShardOf>
+template <typename U>
+send_status detail::Channel<T, Policy, sharded_backend<Shards, ShardOf>>::try_send(U&& value, std::nothrow_t) {
+  if (_closed.load(std::memory_order_acquire)) {
+    return send_status::closed;
+  }
+
+  Node<T>* node = nodes.try_make_empty();
+  if (nullptr == node) {
+    return send_status::full;
+  }
+  link(shard(), NodeChain<T>{nodes.construct(node, std::forward<U>(value)), node, 1});
+  return send_status::sent;
+}
+
+template <typename T, typename Policy, std::size_t Shards, typename ShardOf>
+template <typename InputIt>
+void detail::Channel<T, Policy, sharded_backend<Shards, ShardOf>>::send_range(InputIt first, InputIt last) {
+  if (_closed.load(std::memory_order_acquire)) {
+    throw channel_closed_exception();
+  }
+
+  NodeChain<T> batch = nodes.make_chain(first, last);
+
+  if (not batch.empty()) {
+    link(shard(), batch);
+  }
+}
+
+template <typename T, typename Policy, std::size_t Shards, typename ShardOf>
+std::optional<T> detail::Channel<T, Policy, sharded_backend<Shards, ShardOf>>::pop(Shard& shard) {
+  std::optional<T> result = shard.pop(nodes, latency);
+  if (result.has_value()) {
+    counters.received(1);
+  }
+  return result;
+}
+
+template <typename T, typename Policy, std::size_t Shards, typename ShardOf>
+void detail::Channel<T, Policy, sharded_backend<Shards, ShardOf>>::next_shard() noexcept {
+  current = (current + 1) % Shards;
+  taken   = 0;
+}
+
+template <typename T, typename Policy, std::size_t Shards, typename ShardOf>
+std::optional<T> detail::Channel<T, Policy, sharded_backend<Shards, ShardOf>>::pop() {
+  for (std::size_t visited = 0; visited < Shards; ++visited, next_shard()) {
+    if (auto result = pop(shards[current]); result.has_value()) {
+      if (++taken == fair_share) {
+        next_shard();
+      }
+      return result;
+    }
+  }
+  return std::nullopt;
+}
+
+template <typename T, typename Policy, std::size_t Shards, typename ShardOf>
+std::optional<T> detail::Channel<T, Policy, sharded_backend<Shards, ShardOf>>::receive() {
+  return PollingReceive::one(*this);
+}
+
+template <typename T, typename Policy, std::size_t Shards, typename ShardOf>
+template <typename Clock, typename Duration>
+std::optional<T> detail::Channel<T, Policy, sharded_backend<Shards, ShardOf>>::receive_until(
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  return PollingReceive::one_until(*this, deadline);
+}
+
+template <typename T, typename Policy, std::size_t Shards, typename ShardOf>
+std::optional<T> detail::Channel<T, Policy, sharded_backend<Shards, ShardOf>>::try_receive() {
+  if (exhausted()) {
+    return {};
+  }
+
+  if (auto result = pop(); result.has_value() or not await_link()) {
+    return result;
+  }
+  return pop();
+}
+
+template <typename T, typename Policy, std::size_t Shards, typename ShardOf>
+bool detail::Channel<T, Policy, sharded_backend<Shards, ShardOf>>::await_link() noexcept {
+  return std::any_of(shards.begin(), shards.end(), [](const Shard& shard) { return shard.await_link(); });
+}
+
+template <typename T, typename Policy, std::size_t Shards, typename ShardOf>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, sharded_backend<Shards, ShardOf>>::pop_many(OutputIt out, std::size_t max) {
+  std::size_t received = 0;
+  // Each shard gives at most its fair share, then the next one gets its turn.
+  for (std::size_t visited = 0; visited < Shards and received < max;) {
+    std::optional<T> value = pop(shards[current]);
+    if (not value.has_value()) {
+      next_shard();
+      ++visited;
+      continue;
+    }
+    *out = std::move(value.value());
+    ++out;
+    ++received;
+    if (++taken == fair_share) {
+      next_shard();
+      visited = 0;
+    }
+  }
+  return received;
+}
+
+template <typename T, typename Policy, std::size_t Shards, typename ShardOf>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, sharded_backend<Shards, ShardOf>>::receive_many(OutputIt out, std::size_t max) {
+  return PollingReceive::many(*this, out, max);
+}
+
+template <typename T, typename Policy, std::size_t Shards, typename ShardOf>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, sharded_backend<Shards, ShardOf>>::try_receive_many(OutputIt out, std::size_t max) {
+  if (0 == max or exhausted()) {
+    return 0;
+  }
+
+  if (const auto received = pop_many(out, max); received > 0 or not await_link()) {
+    return received;
+  }
+  return pop_many(out, max);
+}
+
+template <typename T, typename Policy, std::size_t Shards, typename ShardOf>
+void detail::Channel<T, Policy, sharded_backend<Shards, ShardOf>>::close() {
+  _closed.store(true, std::memory_order_release);
+  wake_receiver();
+}
+
+template <typename T, typename Policy, std::size_t Shards, typename ShardOf>
+bool detail::Channel<T, Policy, sharded_backend<Shards, ShardOf>>::closed() const {
+  return _closed.load(std::memory_order_acquire);
+}
+
+#if defined(__linux__)
+template <typename T, typename Policy>
+detail::Channel<T, Policy, shm_backend>::Channel(std::string name, std::size_t capacity)
+  : name{std::move(name)}
+  , mask{std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1} {
+  const std::size_t size = Ring::size(mask);
+  const char* path       = this->name.c_str();
+
+  bool created = true;
+  int fd       = ::shm_open(path, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0 and EEXIST == errno) {
+    created = false;
+    fd      = ::shm_open(path, O_RDWR, 0);
+  }
+  if (fd < 0) {
+    throw std::system_error{errno, std::system_category(), "shm_open " + this->name};
+  }
+
+  const auto fail = [&](int error, const char* what) {
+    ::close(fd);
+    if (created) {
+      ::shm_unlink(path);
+    }
+    throw std::system_error{error, std::system_category(), what};
+  };
+
+  if (created) {
+    if (0 != ::ftruncate(fd, static_cast<off_t>(size))) {
+      fail(errno, "ftruncate");
+    }
+  }
+  else {
+    // The process creating the region may not have sized it yet.
+    struct stat status {};
+    for (int tries = 0; 0 == status.st_size and tries < 1000; ++tries) {
+      if (0 != ::fstat(fd, &status)) {
+        fail(errno, "fstat");
+      }
+      if (0 == status.st_size) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+      }
+    }
+    if (static_cast<std::size_t>(status.st_size) != size) {
+      ::close(fd);
+      throw std::invalid_argument{"The shared memory channel " + this->name + " holds another type or capacity."};
+    }
+  }
+
+  void* address = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (MAP_FAILED == address) {
+    fail(errno, "mmap");
+  }
+  ::close(fd);
+
+  if (created) {
+    ring  = ::new (address) Ring{mask};
+    cells = ring->cells();
+    for (std::size_t position = 0; position <= mask; ++position) {
+      ::new (static_cast<void*>(&cells[position])) Cell{};
+      cells[position].sequence.store(position, std::memory_order_relaxed);
+    }
+    ring->initialized.store(1, std::memory_order_release);
+  }
+  else {
+    ring  = static_cast<Ring*>(address);
+    cells = ring->cells();
+    for (int tries = 0; 0 == ring->initialized.load(std::memory_order_acquire) and tries < 1000; ++tries) {
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    if (0 == ring->initialized.load(std::memory_order_acquire) or Ring::magic_number != ring->magic or
+        sizeof(T) != ring->value_size or mask != ring->mask) {
+      ::munmap(address, size);
+      throw std::invalid_argument{"The shared memory channel " + this->name + " holds another type or capacity."};
+    }
+  }
+  ring->attached.fetch_add(1, std::memory_order_acq_rel);
+  ring->senders.fetch_add(1, std::memory_order_acq_rel);
+}
+
+template <typename T, typename Policy>
+detail::Channel<T, Policy, shm_backend>::~Channel() {
+  if (receiver) {
+    ring->receiving.store(0, std::memory_order_release);
+  }
+  const bool last = 1 == ring->attached.fetch_sub(1, std::memory_order_acq_rel);
+  ::munmap(ring, Ring::size(mask));
+  if (last) {
+    ::shm_unlink(name.c_str());
+  }
+}
+
+template <typename T, typename Policy>
+template <typename... Args>
+bool detail::Channel<T, Policy, shm_backend>::try_push(Args&&... args) {
+  std::size_t position = ring->enqueue_position.load(std::memory_order_relaxed);
+  Cell* cell;
+  for (;;) {
+    cell                      = &cells[position & mask];
+    const std::ptrdiff_t turn = static_cast<std::ptrdiff_t>(cell->sequence.load(std::memory_order_acquire) - position);
+    if (0 == turn) {
+      if (ring->enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    else if (turn < 0) {
+      // The cell still holds the value of a lap ago.
+      return false;
+    }
+    else {
+      position = ring->enqueue_position.load(std::memory_order_relaxed);
+    }
+  }
+
+  ::new (static_cast<void*>(&cell->value)) T(std::forward<Args>(args)...);
+  counters.sent(1);
+  cell->sequence.store(position + 1, std::memory_order_release);
+  wake_receiver();
+  return true;
+}
+
+template <typename T, typename Policy>
+bool detail::Channel<T, Policy, shm_backend>::has_room() const noexcept {
+  const std::size_t position = ring->enqueue_position.load(std::memory_order_relaxed);
+  return cells[position & mask].sequence.load(std::memory_order_acquire) == position;
+}
+
+template <typename T, typename Policy>
+bool detail::Channel<T, Policy, shm_backend>::wait_for_room() {
+  // Announce ourselves before checking, as the receiver only bumps `room` while somebody waits.
+  ring->waiting_senders.fetch_add(1, std::memory_order_seq_cst);
+  for (;;) {
+    const std::uint32_t epoch = ring->room.load(std::memory_order_acquire);
+    if (has_room() or closed()) {
+      break;
+    }
+    futex_wait(ring->room, epoch);
+  }
+  ring->waiting_senders.fetch_sub(1, std::memory_order_relaxed);
+  return not closed();
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+bool detail::Channel<T, Policy, shm_backend>::wait_for_room(const std::chrono::time_point<Clock, Duration>& deadline) {
+  ring->waiting_senders.fetch_add(1, std::memory_order_seq_cst);
+  bool result = false;
+  for (;;) {
+    const std::uint32_t epoch = ring->room.load(std::memory_order_acquire);
+    if (has_room() or closed()) {
+      result = not closed();
+      break;
+    }
+    if (not futex_wait_until(ring->room, epoch, deadline)) {
+      break;
+    }
+  }
+  ring->waiting_senders.fetch_sub(1, std::memory_order_relaxed);
+  return result;
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, shm_backend>::wake_receiver() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (ring->receiver_state.load(std::memory_order_relaxed) == parked and
+      ring->receiver_state.exchange(awake, std::memory_order_acq_rel) == parked) {
+    futex_wake(ring->receiver_state, 1);
+    counters.notified();
+  }
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, shm_backend>::wake_senders() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (ring->waiting_senders.load(std::memory_order_relaxed) > 0) {
+    ring->room.fetch_add(1, std::memory_order_release);
+    futex_wake(ring->room, 1);
+  }
+}
+
+template <typename T, typename Policy>
+template <typename... Args>
+void detail::Channel<T, Policy, shm_backend>::emplace(Args&&... args) {
+  // Constructed up front, so that a throwing constructor doesn't leave a claimed cell behind.
+  const T value(std::forward<Args>(args)...);
+  while (closed_here() or not try_push(value)) {
+    if (closed_here() or not wait_for_room()) {
+      throw channel_closed_exception();
+    }
+  }
+}
+
+template <typename T, typename Policy>
+template <typename InputIt>
+void detail::Channel<T, Policy, shm_backend>::send_range(InputIt first, InputIt last) {
+  for (; first != last; ++first) {
+    emplace(*first);
+  }
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, shm_backend>::try_send(const T& value) {
+  if (closed_here()) {
+    throw channel_closed_exception();
+  }
+  if (not try_push(value)) {
+    return {value};
+  }
+  return std::nullopt;
+}
+
+template <typename T, typename Policy>
+template <typename U>
+send_status detail::Channel<T, Policy, shm_backend>::try_send(U&& value, std::nothrow_t) {
+  if (closed_here()) {
+    return send_status::closed;
+  }
+  return try_push(value) ? send_status::sent : send_status::full;
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+std::optional<T> detail::Channel<T, Policy, shm_backend>::send_until(
+    const T& value,
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  while (closed_here() or not try_push(value)) {
+    if (closed_here() or not wait_for_room(deadline)) {
+      if (closed_here()) {
+        throw channel_closed_exception();
+      }
+      return {value};
+    }
+  }
+  return std::nullopt;
+}
+
+template <typename T, typename Policy>
+bool detail::Channel<T, Policy, shm_backend>::front_ready() const noexcept {
+  const std::size_t position = ring->dequeue_position.load(std::memory_order_relaxed);
+  return cells[position & mask].sequence.load(std::memory_order_acquire) == position + 1;
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, shm_backend>::wait_ready() {
+  const auto ready = [this] { return this->ready(); };
+  counters.wait(ready, [&] {
+    if (spin<typename Policy::wait_strategy>(ready)) {
+      return;
+    }
+    // As Parker does, on a futex shared with the other processes.
+    while (not ready()) {
+      ring->receiver_state.store(parked, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (ready()) {
+        break;
+      }
+      futex_wait(ring->receiver_state, parked);
+    }
+    ring->receiver_state.store(awake, std::memory_order_relaxed);
+  });
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+bool detail::Channel<T, Policy, shm_backend>::wait_ready(const std::chrono::time_point<Clock, Duration>& deadline) {
+  const auto ready = [this] { return this->ready(); };
+  return counters.wait(ready, [&] {
+    if (spin<typename Policy::wait_strategy>(ready)) {
+      return true;
+    }
+    bool result = true;
+    while (not ready()) {
+      ring->receiver_state.store(parked, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (ready()) {
+        break;
+      }
+      if (not futex_wait_until(ring->receiver_state, parked, deadline)) {
+        result = ready();
+        break;
+      }
+    }
+    ring->receiver_state.store(awake, std::memory_order_relaxed);
+    return result;
+  });
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, shm_backend>::claim_receiver() {
+  std::uint32_t unclaimed = 0;
+  if (not ring->receiving.compare_exchange_strong(unclaimed, 1, std::memory_order_acq_rel)) {
+    throw std::invalid_argument{"Another receiver already receives from the shared memory channel " + name + "."};
+  }
+  receiver = true;
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, shm_backend>::pop() {
+  if (not receiver) {
+    claim_receiver();
+  }
+
+  const std::size_t position = ring->dequeue_position.load(std::memory_order_relaxed);
+  Cell& cell                 = cells[position & mask];
+  if (cell.sequence.load(std::memory_order_acquire) != position + 1) {
+    // Either empty, or a sender between claiming the cell and filling it. It wakes us once filled.
+    return std::nullopt;
+  }
+
+  std::optional<T> result{cell.value};
+  cell.sequence.store(position + mask + 1, std::memory_order_release);
+  ring->dequeue_position.store(position + 1, std::memory_order_relaxed);
+  counters.received(1);
+  wake_senders();
+  return result;
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, shm_backend>::pop_many(OutputIt out, std::size_t max) {
+  std::size_t received = 0;
+  for (; received < max; ++received) {
+    auto value = pop();
+    if (not value.has_value()) {
+      break;
+    }
+    *out = *value;
+    ++out;
+  }
+  return received;
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, shm_backend>::receive() {
+  return PollingReceive::one(*this);
+}
+
+template <typename T, typename Policy>
+template <typename Clock, typename Duration>
+std::optional<T> detail::Channel<T, Policy, shm_backend>::receive_until(
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  return PollingReceive::one_until(*this, deadline);
+}
+
+template <typename T, typename Policy>
+std::optional<T> detail::Channel<T, Policy, shm_backend>::try_receive() {
+  if (exhausted()) {
+    return {};
+  }
+
+  return pop();
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, shm_backend>::receive_many(OutputIt out, std::size_t max) {
+  return PollingReceive::many(*this, out, max);
+}
+
+template <typename T, typename Policy>
+template <typename OutputIt>
+std::size_t detail::Channel<T, Policy, shm_backend>::try_receive_many(OutputIt out, std::size_t max) {
+  if (0 == max or exhausted()) {
+    return 0;
+  }
+
+  return pop_many(out, max);
+}
+
+template <typename T, typename Policy>
+void detail::Channel<T, Policy, shm_backend>::close() {
+  // Only the last sending process ends the stream.
+  if (sending.exchange(false, std::memory_order_acq_rel) and 1 == ring->senders.fetch_sub(1, std::memory_order_acq_rel)) {
+    ring->closed.store(1, std::memory_order_release);
+    wake_receiver();
+    ring->room.fetch_add(1, std::memory_order_release);
+    futex_wake(ring->room, INT_MAX);
+  }
+}
+
+template <typename T, typename Policy>
+bool detail::Channel<T, Policy, shm_backend>::closed() const {
+  return 0 != ring->closed.load(std::memory_order_acquire);
 }
+#endif
 
 }  // namespace mpsc
@@ -8,16 +8,99 @@
 #include <mpsc/channel.hpp>
 
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_template_test_macros.hpp>
 
 #include <random>
+#include <numeric>
 #include <algorithm>
 #include <vector>
+#include <array>
+#include <list>
+#include <set>
 #include <future>
 #include <condition_variable>
+#include <coroutine>
 #include <chrono>
+#include <ranges>
+#include <string>
+#include <thread>
+#include <filesystem>
+#include <cctype>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 using namespace std::chrono_literals;
 
+#if defined(__linux__)
+// A shared memory name of its own for every channel of the test run.
+std::string unique_shm_name() {
+    static std::atomic<int> count{0};
+    return "/mpsc-test-" + std::to_string(::getpid()) + "-" + std::to_string(count++);
+}
+#endif
+
+// The default backend with a node per value, as it has for values it doesn't store by value: an `int` otherwise goes
+// to the segmented storage.
+struct NodesPolicy : mpsc::default_policy {
+    static constexpr std::size_t inline_size = 0;
+};
+
+// Create a channel of any backend; bounded ones get a capacity large enough to not get in the way.
+template <typename T, typename Policy>
+auto make_test_channel() {
+    if constexpr (std::is_same_v<typename Policy::backend, mpsc::spsc_backend>) {
+        return mpsc::make_spsc_channel<T, Policy>(1024);
+    } else if constexpr (std::is_same_v<typename Policy::backend, mpsc::mpmc_backend>) {
+        return mpsc::make_mpmc_channel<T, Policy>(1024);
+    } else if constexpr (std::is_same_v<typename Policy::backend, mpsc::broadcast_backend>) {
+        return mpsc::make_broadcast_channel<T, Policy>(1024);
+    } else if constexpr (std::is_same_v<typename Policy::backend, mpsc::bounded_backend>) {
+        return mpsc::make_bounded_channel<T, Policy>(1024);
+#if defined(__linux__)
+    } else if constexpr (std::is_same_v<typename Policy::backend, mpsc::shm_backend>) {
+        return mpsc::make_shm_channel<T, Policy>(unique_shm_name(), 1024);
+#endif
+    } else {
+        return mpsc::make_channel<T, Policy>();
+    }
+}
+
+// Appends to `values` like std::back_inserter, but throws once they hold `limit` values.
+template <typename T>
+struct LimitedInserter {
+    using iterator_category = std::output_iterator_tag;
+    using value_type = void;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = void;
+
+    LimitedInserter(std::vector<T>& values, std::size_t limit) : values{&values}, limit{limit} {}
+
+    template <typename U>
+    LimitedInserter& operator=(U&& value) {
+        if (values->size() == limit) {
+            throw std::runtime_error{"The output is full."};
+        }
+        values->push_back(std::forward<U>(value));
+        return *this;
+    }
+
+    LimitedInserter& operator*() { return *this; }
+    LimitedInserter& operator++() { return *this; }
+    LimitedInserter operator++(int) { return *this; }
+
+    std::vector<T>* values;
+    std::size_t limit;
+};
+
 TEST_CASE("Channel tests") {
     auto rng = std::mt19937_64{7654236};  // Arbitrary seed.
 
@@ -64,6 +147,8 @@ TEST_CASE("Channel tests") {
             tx.send(12);
 
             auto async_recv = std::async([&]() {
+                // Only notifies once the main thread waits, and releases mtx.
+                std::unique_lock{mtx}.unlock();
                 receiving_now.notify_all();
                 std::copy(rx.begin(), rx.end(), std::back_inserter(recvd));
             });
@@ -120,5 +205,2757 @@ TEST_CASE("Channel tests") {
 
             REQUIRE(rx_1.closed());
         }
+
+        SECTION("A closed sender, and its copies, keep the channel alive without keeping it open") {
+            auto [tx_1, rx_1] = mpsc::make_channel<double>();
+            auto tx_2 = tx_1;
+            tx_1.close();
+            tx_1.close();
+            auto tx_3 = tx_1;
+            REQUIRE_FALSE(rx_1.closed());
+
+            tx_2 = tx_3;
+            REQUIRE(rx_1.closed());
+            {
+                auto rx_to_kill = std::move(rx_1);
+            }
+            REQUIRE(tx_2.closed());
+            REQUIRE(tx_3.closed());
+        }
+
+        SECTION("Senders copied and dropped by many threads close the channel once they are all gone") {
+            auto [tx, rx] = mpsc::make_channel<int>();
+            std::vector<std::jthread> threads;
+            for (int i = 0; i < 8; ++i) {
+                threads.emplace_back([tx = tx]() mutable {
+                    for (int n = 0; n < 1000; ++n) {
+                        auto copy = tx;
+                        copy.send(n);
+                    }
+                });
+            }
+            {
+                auto tx_to_kill = std::move(tx);
+            }
+
+            std::size_t received = 0;
+            while (rx.receive()) {
+                ++received;
+            }
+            REQUIRE(rx.closed());
+            REQUIRE(received <= 8 * 1000);
+        }
+    }
+
+    SECTION("A batch receive whose output throws puts back the values it didn't deliver") {
+        auto [tx, rx] = mpsc::make_channel<std::shared_ptr<int>>();
+        for (int i = 0; i < 4; ++i) {
+            tx.send(std::make_shared<int>(i));
+        }
+
+        auto received = std::vector<std::shared_ptr<int>>{};
+        REQUIRE_THROWS_AS(rx.receive_many(LimitedInserter{received, 2}, 4), std::runtime_error);
+        REQUIRE(2 == received.size());
+        tx.send(std::make_shared<int>(4));
+        for (int i = 2; i <= 4; ++i) {
+            REQUIRE(i == *rx.receive().value());
+        }
+        REQUIRE_FALSE(rx.try_receive().has_value());
+    }
+}
+
+TEST_CASE("Lock-free channel tests") {
+    auto [tx, rx] = mpsc::make_channel<int, mpsc::lock_free_policy>();
+
+    SECTION("A single value can be sent and received") {
+        tx.send(42);
+        const auto rcvd = rx.receive();
+
+        REQUIRE(rcvd.has_value());
+        REQUIRE(42 == rcvd.value());
+    }
+
+    SECTION("try_receive doesn't block on an empty channel") {
+        REQUIRE_FALSE(rx.try_receive().has_value());
+
+        tx.send(1);
+        REQUIRE(1 == rx.try_receive().value());
+    }
+
+    SECTION("Values from multiple producers all arrive, in order per producer") {
+        constexpr int producers = 4;
+        constexpr int per_producer = 10000;
+
+        auto threads = std::vector<std::thread>{};
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([p, tx = tx]() mutable {
+                for (int i = 0; i < per_producer; ++i) {
+                    tx.send(p * per_producer + i);
+                }
+            });
+        }
+
+        auto last_seen = std::vector<int>(producers, -1);
+        for (int n = 0; n < producers * per_producer; ++n) {
+            const auto v = rx.receive().value();
+            const auto p = v / per_producer;
+            REQUIRE(last_seen[p] < v % per_producer);
+            last_seen[p] = v % per_producer;
+        }
+
+        for (auto& t: threads) {
+            t.join();
+        }
+        REQUIRE(std::vector<int>(producers, per_producer - 1) == last_seen);
+    }
+
+    SECTION("Closing sender wakes up a parked receiver") {
+        auto async_recv = std::async(std::launch::async, [&]() { return rx.receive(); });
+
+        std::this_thread::sleep_for(10ms);
+        tx.close();
+
+        REQUIRE(std::future_status::ready == async_recv.wait_for(1s));
+        REQUIRE_FALSE(async_recv.get().has_value());
+        REQUIRE(rx.closed());
+    }
+
+    SECTION("Values still queued when the channel is destroyed are released") {
+        auto [tx_1, rx_1] = mpsc::make_channel<std::shared_ptr<int>, mpsc::lock_free_policy>();
+        auto value = std::make_shared<int>(3);
+        tx_1.send(value);
+        tx_1.send(value);
+        REQUIRE(3 == value.use_count());
+
+        {
+            auto _tx = std::move(tx_1);
+            auto _rx = std::move(rx_1);
+        }
+        REQUIRE(1 == value.use_count());
+    }
+}
+
+struct Frame : mpsc::intrusive_hook {
+    explicit Frame(int id, std::atomic<int>* alive = nullptr) : id{id}, alive{alive} {
+        if (nullptr != alive) {
+            ++*alive;
+        }
+    }
+    ~Frame() {
+        if (nullptr != alive) {
+            --*alive;
+        }
+    }
+
+    int id;
+    std::atomic<int>* alive;
+};
+
+// Stateless, as the deleters of intrusive channels have to be: counts the frames it deletes, as a pool would take them
+// back.
+struct CountingDeleter {
+    static inline std::atomic<int> deleted{0};
+
+    void operator()(Frame* frame) const noexcept {
+        ++deleted;
+        delete frame;
+    }
+};
+
+TEST_CASE("Intrusive channel tests") {
+    auto [tx, rx] = mpsc::make_channel<std::unique_ptr<Frame>, mpsc::intrusive_policy>();
+
+    SECTION("A stateless deleter is used for the received messages and those left in the channel") {
+        const int initial = CountingDeleter::deleted;
+        {
+            using Pointer = std::unique_ptr<Frame, CountingDeleter>;
+            auto [frames_tx, frames_rx] = mpsc::make_channel<Pointer, mpsc::intrusive_policy>();
+            frames_tx.send(Pointer{new Frame(1)});
+            frames_tx.send(Pointer{new Frame(2)});
+            REQUIRE(1 == frames_rx.receive().value()->id);
+            REQUIRE(initial + 1 == CountingDeleter::deleted);
+        }
+        REQUIRE(initial + 2 == CountingDeleter::deleted);
+    }
+
+    SECTION("The message itself goes through the channel") {
+        auto frame = std::make_unique<Frame>(1);
+        const Frame* sent = frame.get();
+        tx.send(std::move(frame));
+
+        const auto received = rx.receive();
+        REQUIRE(sent == received.value().get());
+        REQUIRE(1 == received.value()->id);
+        REQUIRE_FALSE(rx.try_receive().has_value());
+    }
+
+    SECTION("Messages are received in order, one by one and in batches") {
+        for (int i = 0; i < 3; ++i) {
+            tx.send(std::make_unique<Frame>(i));
+        }
+        auto batch = std::vector<std::unique_ptr<Frame>>{};
+        for (int i = 3; i < 6; ++i) {
+            batch.push_back(std::make_unique<Frame>(i));
+        }
+        tx.send_bulk(std::move(batch));
+        tx.emplace(new Frame{6});
+
+        REQUIRE(0 == rx.receive().value()->id);
+        auto frames = std::vector<std::unique_ptr<Frame>>{};
+        REQUIRE(2 == rx.receive_many(std::back_inserter(frames), 2));
+        REQUIRE(4 == rx.try_drain_into(frames));
+        for (int i = 0; i < 6; ++i) {
+            REQUIRE(i + 1 == frames[i]->id);
+        }
+        REQUIRE_FALSE(rx.receive_for(1ms).has_value());
+    }
+
+    SECTION("A message can be sent again once received") {
+        auto frame = std::make_unique<Frame>(1);
+        for (int i = 0; i < 3; ++i) {
+            tx.send(std::move(frame));
+            frame = rx.receive().value();
+        }
+        REQUIRE(1 == frame->id);
+    }
+
+    SECTION("An empty pointer can't be sent") {
+        REQUIRE_THROWS_AS(tx.send(nullptr), std::invalid_argument);
+
+        auto alive = std::atomic<int>{0};
+        auto batch = std::vector<std::unique_ptr<Frame>>{};
+        batch.push_back(std::make_unique<Frame>(1, &alive));
+        batch.push_back(nullptr);
+        REQUIRE_THROWS_AS(tx.send_bulk(std::move(batch)), std::invalid_argument);
+        REQUIRE(0 == alive);
+        REQUIRE_FALSE(rx.try_receive().has_value());
+    }
+
+    SECTION("An empty pointer is reported by a non-throwing send") {
+        const mpsc::send_result<std::unique_ptr<Frame>> result = tx.try_send(std::unique_ptr<Frame>{}, std::nothrow);
+        REQUIRE_FALSE(result);
+        REQUIRE(mpsc::send_status::invalid == result.status);
+        REQUIRE(nullptr == result.value.value());
+        REQUIRE_FALSE(rx.try_receive().has_value());
+    }
+
+    SECTION("Many producers send to the receiver") {
+        constexpr int producers_count = 4;
+        constexpr int per_producer = 20000;
+        auto producers = std::vector<std::thread>{};
+        for (int p = 0; p < producers_count; ++p) {
+            producers.emplace_back([tx = tx, p]() mutable {
+                for (int i = 0; i < per_producer; ++i) {
+                    tx.send(std::make_unique<Frame>(p * per_producer + i));
+                }
+            });
+        }
+
+        auto last = std::vector<int>(producers_count, -1);
+        auto in_order = true;
+        for (int i = 0; i < producers_count * per_producer; ++i) {
+            const int id = rx.receive().value()->id;
+            in_order = in_order and last[id / per_producer] < id;
+            last[id / per_producer] = id;
+        }
+        for (auto& t: producers) {
+            t.join();
+        }
+        REQUIRE(in_order);
+        REQUIRE_FALSE(rx.try_receive().has_value());
+    }
+
+    SECTION("A waiting receiver is woken up, also through select") {
+        auto async_send = std::async(std::launch::async, [&tx] {
+            std::this_thread::sleep_for(10ms);
+            tx.send(std::make_unique<Frame>(1));
+        });
+        REQUIRE(0 == mpsc::select(rx));
+        REQUIRE(1 == rx.receive().value()->id);
+        async_send.get();
+    }
+
+    SECTION("Messages left in the channel are destroyed with it") {
+        auto alive = std::atomic<int>{0};
+        {
+            auto [frame_tx, frame_rx] = mpsc::make_channel<std::unique_ptr<Frame>, mpsc::intrusive_policy>();
+            frame_tx.send(std::make_unique<Frame>(1, &alive));
+            frame_tx.send(std::make_unique<Frame>(2, &alive));
+            REQUIRE(2 == alive);
+        }
+        REQUIRE(0 == alive);
+    }
+}
+
+TEST_CASE("Priority channel tests") {
+    auto [tx, rx] = mpsc::make_channel<int, mpsc::priority_policy<3>>();
+
+    SECTION("The most urgent lane is received first, each lane in order") {
+        tx.send(1).send(2, 1).send(3, 2).send(4).send(5, 2).send(6, 1);
+
+        auto values = std::vector<int>{};
+        REQUIRE(6 == rx.try_drain_into(values));
+        REQUIRE(std::vector<int>{3, 5, 2, 6, 1, 4} == values);
+    }
+
+    SECTION("An urgent value overtakes a backlog") {
+        const auto backlog = std::views::iota(0, 100);
+        tx.send_range(backlog.begin(), backlog.end());
+        REQUIRE(0 == rx.receive().value());
+        tx.send(-1, 2);
+        REQUIRE(-1 == rx.receive().value());
+        auto values = std::vector<int>{};
+        REQUIRE(10 == rx.receive_many(std::back_inserter(values), 10));
+        REQUIRE(1 == values.front());
+    }
+
+    SECTION("A priority out of range is rejected") {
+        REQUIRE_THROWS_AS(tx.send(1, 3), std::invalid_argument);
+        REQUIRE_FALSE(rx.try_receive().has_value());
+    }
+
+    SECTION("A waiting receiver is woken up by any lane") {
+        for (std::size_t priority = 0; priority < 3; ++priority) {
+            auto async_send = std::async(std::launch::async, [&tx, priority] {
+                std::this_thread::sleep_for(10ms);
+                tx.send(static_cast<int>(priority), priority);
+            });
+            REQUIRE(static_cast<int>(priority) == rx.receive().value());
+            async_send.get();
+        }
+    }
+
+    SECTION("Many producers send to all the lanes") {
+        constexpr int producers_count = 3;
+        constexpr int per_producer = 20000;
+        auto producers = std::vector<std::thread>{};
+        for (int p = 0; p < producers_count; ++p) {
+            producers.emplace_back([tx = tx, p]() mutable {
+                for (int i = 0; i < per_producer; ++i) {
+                    tx.send(p * per_producer + i, static_cast<std::size_t>(p));
+                }
+            });
+        }
+
+        auto last = std::vector<int>(producers_count, -1);
+        auto in_order = true;
+        for (int i = 0; i < producers_count * per_producer; ++i) {
+            const int value = rx.receive().value();
+            in_order = in_order and last[value / per_producer] < value;
+            last[value / per_producer] = value;
+        }
+        for (auto& t: producers) {
+            t.join();
+        }
+        REQUIRE(in_order);
+        REQUIRE_FALSE(rx.try_receive().has_value());
+    }
+
+    SECTION("Values left in the lanes are destroyed with the channel") {
+        auto value = std::make_shared<int>(1);
+        {
+            auto [ptr_tx, ptr_rx] = mpsc::make_channel<std::shared_ptr<int>, mpsc::priority_policy<2>>();
+            ptr_tx.send(value).send(value, 1);
+            REQUIRE(3 == value.use_count());
+        }
+        REQUIRE(1 == value.use_count());
+    }
+}
+
+// Sends to the shard the test thread picks.
+thread_local std::size_t test_shard = 0;
+
+#if defined(__linux__)
+void pin_to_cpu(int cpu) {
+    cpu_set_t only;
+    CPU_ZERO(&only);
+    CPU_SET(cpu, &only);
+    ::sched_setaffinity(0, sizeof(only), &only);
+}
+
+// The NUMA node sysfs lists the CPU under; 0 without NUMA support.
+std::size_t node_of_cpu(int cpu) {
+    const auto path = std::filesystem::path{"/sys/devices/system/cpu"} / ("cpu" + std::to_string(cpu));
+    auto error = std::error_code{};
+    for (const auto& entry: std::filesystem::directory_iterator{path, error}) {
+        const auto name = entry.path().filename().string();
+        if (name.starts_with("node") and name.size() > 4 and std::isdigit(static_cast<unsigned char>(name[4]))) {
+            return std::stoul(name.substr(4));
+        }
+    }
+    return 0;
+}
+#endif
+
+struct TestShard {
+    std::size_t operator()() const noexcept { return test_shard; }
+};
+
+TEST_CASE("Sharded channel tests") {
+    using Policy = mpsc::sharded_policy<3, TestShard>;
+    auto [tx, rx] = mpsc::make_channel<int, Policy>();
+    constexpr int fair_share = static_cast<int>(mpsc::sharded_backend<3, TestShard>::fair_share);
+
+    SECTION("The receiver takes a fair share of each shard in turn, each shard in order") {
+        for (test_shard = 0; test_shard < 2; ++test_shard) {
+            const auto values = std::views::iota(static_cast<int>(test_shard) * 1000, static_cast<int>(test_shard) * 1000 + 100);
+            tx.send_range(values.begin(), values.end());
+        }
+        test_shard = 0;
+
+        auto values = std::vector<int>{};
+        REQUIRE(200 == rx.try_drain_into(values));
+        auto expected = std::vector<int>{};
+        for (const auto& [first, last]: {std::pair{0, fair_share}, {1000, 1000 + fair_share}, {fair_share, 100},
+                                         {1000 + fair_share, 1100}}) {
+            for (int v = first; v < last; ++v) {
+                expected.push_back(v);
+            }
+        }
+        REQUIRE(expected == values);
+    }
+
+    SECTION("A busy shard doesn't starve the others") {
+        for (int i = 0; i < 1000; ++i) {
+            tx.send(i);
+        }
+        test_shard = 2;
+        tx.send(-1);
+        test_shard = 0;
+
+        auto position = 0;
+        while (-1 != rx.receive().value()) {
+            ++position;
+        }
+        REQUIRE(fair_share == position);
+    }
+
+    SECTION("Many producers send to their own shards") {
+        constexpr int producers_count = 3;
+        constexpr int per_producer = 20000;
+        auto producers = std::vector<std::thread>{};
+        for (int p = 0; p < producers_count; ++p) {
+            producers.emplace_back([tx = tx, p]() mutable {
+                test_shard = static_cast<std::size_t>(p);
+                for (int i = 0; i < per_producer; ++i) {
+                    tx.send(p * per_producer + i);
+                }
+            });
+        }
+
+        auto last = std::vector<int>(producers_count, -1);
+        auto in_order = true;
+        for (int i = 0; i < producers_count * per_producer; ++i) {
+            const int value = rx.receive().value();
+            in_order = in_order and last[value / per_producer] < value;
+            last[value / per_producer] = value;
+        }
+        for (auto& t: producers) {
+            t.join();
+        }
+        REQUIRE(in_order);
+        REQUIRE_FALSE(rx.try_receive().has_value());
+    }
+
+#if defined(__linux__)
+    SECTION("A thread sends to the shard of the CPU, and of the node, it first sent on") {
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        REQUIRE(0 == ::sched_getaffinity(0, sizeof(allowed), &allowed));
+        auto cpus = std::vector<int>{};
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &allowed)) {
+                cpus.push_back(cpu);
+            }
+        }
+
+        for (std::size_t i = 0; i < cpus.size(); ++i) {
+            const int cpu = cpus[i];
+            const int other = cpus[(i + 1) % cpus.size()];
+            auto picked = std::array<std::size_t, 4>{};
+            std::thread{[&] {
+                pin_to_cpu(cpu);
+                picked[0] = mpsc::first_cpu{}();
+                picked[1] = mpsc::first_node{}();
+                // Moved to another CPU, it keeps both.
+                pin_to_cpu(other);
+                picked[2] = mpsc::first_cpu{}();
+                picked[3] = mpsc::first_node{}();
+            }}.join();
+
+            REQUIRE(static_cast<std::size_t>(cpu) == picked[0]);
+            REQUIRE(node_of_cpu(cpu) == picked[1]);
+            REQUIRE(picked[0] == picked[2]);
+            REQUIRE(picked[1] == picked[3]);
+        }
+    }
+#endif
+
+    SECTION("Values left in the shards are destroyed with the channel") {
+        auto value = std::make_shared<int>(1);
+        {
+            auto [ptr_tx, ptr_rx] = mpsc::make_channel<std::shared_ptr<int>, Policy>();
+            ptr_tx.send(value);
+            test_shard = 1;
+            ptr_tx.send(value);
+            test_shard = 0;
+            REQUIRE(3 == value.use_count());
+        }
+        REQUIRE(1 == value.use_count());
+    }
+}
+
+TEST_CASE("Bounded channel tests") {
+    auto [tx, rx] = mpsc::make_bounded_channel<int>(4);
+
+    SECTION("A zero capacity is rejected") {
+        REQUIRE_THROWS_AS(mpsc::make_bounded_channel<int>(0), std::invalid_argument);
+    }
+
+    SECTION("Values can be sent up to the capacity and received in order") {
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE_FALSE(tx.try_send(i).has_value());
+        }
+
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(i == rx.receive().value());
+        }
+        REQUIRE_FALSE(rx.try_receive().has_value());
+    }
+
+    SECTION("try_send returns the value back when the channel is full") {
+        for (int i = 0; i < 4; ++i) {
+            tx.send(i);
+        }
+
+        const auto rejected = tx.try_send(17);
+        REQUIRE(rejected.has_value());
+        REQUIRE(17 == rejected.value());
+
+        REQUIRE(0 == rx.receive().value());
+        REQUIRE_FALSE(tx.try_send(17).has_value());
+    }
+
+    SECTION("send_for times out on a full channel") {
+        for (int i = 0; i < 4; ++i) {
+            tx.send(i);
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto rejected = tx.send_for(5, 20ms);
+        REQUIRE(rejected.has_value());
+        REQUIRE(std::chrono::steady_clock::now() - start >= 20ms);
+    }
+
+    SECTION("A blocked send resumes once the receiver makes room") {
+        for (int i = 0; i < 4; ++i) {
+            tx.send(i);
+        }
+
+        auto async_send = std::async(std::launch::async, [tx = tx]() mutable { tx.send(4); });
+        REQUIRE(std::future_status::timeout == async_send.wait_for(10ms));
+
+        REQUIRE(0 == rx.receive().value());
+        REQUIRE(std::future_status::ready == async_send.wait_for(1s));
+        for (int i = 1; i <= 4; ++i) {
+            REQUIRE(i == rx.receive().value());
+        }
+    }
+
+    SECTION("Many values go through a small ring") {
+        constexpr int total = 10000;
+        auto producer = std::thread([tx = tx]() mutable {
+            for (int i = 0; i < total; ++i) {
+                tx.send(i);
+            }
+        });
+
+        for (int i = 0; i < total; ++i) {
+            REQUIRE(i == rx.receive().value());
+        }
+        producer.join();
+    }
+
+    SECTION("A batch larger than the capacity is sent as the receiver makes room") {
+        auto sent = std::vector<int>(100);
+        std::iota(sent.begin(), sent.end(), 0);
+        auto async_send = std::async(std::launch::async, [tx = tx, &sent]() mutable { tx.send_range(sent.begin(), sent.end()); });
+
+        auto vals = std::vector<int>{};
+        while (vals.size() < sent.size()) {
+            rx.drain_into(vals);
+            REQUIRE(vals.size() <= sent.size());
+        }
+        REQUIRE(std::future_status::ready == async_send.wait_for(1s));
+        REQUIRE(sent == vals);
+    }
+
+    SECTION("What a throwing batch placed so far wakes up a blocked receiver") {
+        auto async_recv = std::async(std::launch::async, [&]() { return rx.receive(); });
+        std::this_thread::sleep_for(10ms);
+
+        const auto batch = std::views::iota(0, 3) | std::views::transform([](int i) {
+                               if (2 == i) {
+                                   throw std::runtime_error{"batch"};
+                               }
+                               return i;
+                           });
+        REQUIRE_THROWS_AS(tx.send_range(batch.begin(), batch.end()), std::runtime_error);
+        REQUIRE(std::future_status::ready == async_recv.wait_for(1s));
+        REQUIRE(0 == async_recv.get().value());
+        REQUIRE(1 == rx.try_receive().value());
+    }
+
+    SECTION("Closing the channel wakes up blocked senders") {
+        for (int i = 0; i < 4; ++i) {
+            tx.send(i);
+        }
+
+        auto async_send = std::async(std::launch::async, [&]() { tx.send(4); });
+        std::this_thread::sleep_for(10ms);
+        tx.close();
+
+        REQUIRE(std::future_status::ready == async_send.wait_for(1s));
+        REQUIRE_THROWS_AS(async_send.get(), mpsc::channel_closed_exception);
+    }
+}
+
+TEST_CASE("SPSC channel tests") {
+    auto [tx, rx] = mpsc::make_spsc_channel<int>(4);
+
+    static_assert(not std::is_copy_constructible_v<decltype(tx)>);
+    static_assert(not std::is_copy_assignable_v<decltype(tx)>);
+    static_assert(std::is_move_constructible_v<decltype(tx)>);
+
+    SECTION("Values can be sent up to the capacity and received in order") {
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE_FALSE(tx.try_send(i).has_value());
+        }
+        REQUIRE(4 == tx.try_send(4).value());
+
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(i == rx.receive().value());
+        }
+        REQUIRE_FALSE(rx.try_receive().has_value());
+    }
+
+    SECTION("send_for times out on a full channel") {
+        for (int i = 0; i < 4; ++i) {
+            tx.send(i);
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        REQUIRE(5 == tx.send_for(5, 20ms).value());
+        REQUIRE(std::chrono::steady_clock::now() - start >= 20ms);
+    }
+
+    SECTION("A blocked send resumes once the receiver makes room") {
+        for (int i = 0; i < 4; ++i) {
+            tx.send(i);
+        }
+
+        auto async_send = std::async(std::launch::async, [tx = std::move(tx)]() mutable { tx.send(4); });
+        REQUIRE(std::future_status::timeout == async_send.wait_for(10ms));
+
+        REQUIRE(0 == rx.receive().value());
+        REQUIRE(std::future_status::ready == async_send.wait_for(1s));
+        for (int i = 1; i <= 4; ++i) {
+            REQUIRE(i == rx.receive().value());
+        }
+        REQUIRE_FALSE(rx.try_receive().has_value());
+    }
+
+    SECTION("Many values go through the ring, one by one and in batches") {
+        constexpr int total = 100000;
+        auto producer = std::thread([&tx] {
+            auto batch = std::vector<int>(7);
+            for (int i = 0; i < total;) {
+                if (i % 3 == 0 and i + 7 <= total) {
+                    std::iota(batch.begin(), batch.end(), i);
+                    tx.send_range(batch.begin(), batch.end());
+                    i += 7;
+                } else {
+                    tx.send(i++);
+                }
+            }
+        });
+
+        auto vals = std::vector<int>{};
+        while (vals.size() < total) {
+            if (vals.size() % 2 == 0) {
+                vals.push_back(rx.receive().value());
+            } else {
+                rx.receive_many(std::back_inserter(vals), 3);
+            }
+        }
+        producer.join();
+
+        auto expected = std::vector<int>(total);
+        std::iota(expected.begin(), expected.end(), 0);
+        REQUIRE(expected == vals);
+    }
+
+    SECTION("Closing the channel wakes up a waiting receiver") {
+        auto async_recv = std::async(std::launch::async, [&rx] { return rx.receive(); });
+        std::this_thread::sleep_for(10ms);
+        tx.close();
+
+        REQUIRE(std::future_status::ready == async_recv.wait_for(1s));
+        REQUIRE_FALSE(async_recv.get().has_value());
+        REQUIRE_THROWS_AS(tx.send(1), mpsc::channel_closed_exception);
+    }
+
+    SECTION("A batch receive whose output throws keeps the values it didn't deliver") {
+        auto [ptr_tx, ptr_rx] = mpsc::make_spsc_channel<std::shared_ptr<int>>(8);
+        for (int i = 0; i < 4; ++i) {
+            ptr_tx.send(std::make_shared<int>(i));
+        }
+
+        auto received = std::vector<std::shared_ptr<int>>{};
+        REQUIRE_THROWS_AS(ptr_rx.receive_many(LimitedInserter{received, 2}, 4), std::runtime_error);
+        REQUIRE(2 == received.size());
+        for (int i = 2; i < 4; ++i) {
+            REQUIRE(i == *ptr_rx.receive().value());
+        }
+        REQUIRE_FALSE(ptr_rx.try_receive().has_value());
+    }
+
+    SECTION("Values left in the ring are destroyed with it") {
+        auto value = std::make_shared<int>(3);
+        {
+            auto [ptr_tx, ptr_rx] = mpsc::make_spsc_channel<std::shared_ptr<int>>(2);
+            ptr_tx.send(value);
+            ptr_tx.send(value);
+            REQUIRE(3 == value.use_count());
+        }
+        REQUIRE(1 == value.use_count());
+    }
+}
+
+TEST_CASE("MPMC channel tests") {
+    auto [tx, rx] = mpsc::make_mpmc_channel<int>(4);
+
+    static_assert(std::is_copy_constructible_v<decltype(rx)>);
+    static_assert(std::is_copy_assignable_v<decltype(rx)>);
+    static_assert(not std::is_copy_constructible_v<mpsc::Receiver<int>>);
+
+    SECTION("The capacity is rounded up to a power of two") {
+        REQUIRE(3 == std::get<0>(mpsc::make_mpmc_channel<int>(1)).send(1).send(2).try_send(3).value());
+        REQUIRE(9 == std::get<0>(mpsc::make_mpmc_channel<int>(5)).send_bulk({1, 2, 3, 4, 5, 6, 7, 8}).try_send(9).value());
+    }
+
+    SECTION("Copies of the receiver share the values") {
+        auto other = rx;
+        tx.send_bulk({1, 2, 3, 4});
+        REQUIRE(5 == tx.try_send(5).value());
+
+        REQUIRE(1 == rx.receive().value());
+        REQUIRE(2 == other.receive().value());
+        REQUIRE(3 == rx.try_receive().value());
+        REQUIRE(4 == other.try_receive().value());
+        REQUIRE_FALSE(rx.try_receive().has_value());
+        REQUIRE_FALSE(other.try_receive().has_value());
+    }
+
+    SECTION("The channel outlives the first receiver") {
+        auto other = rx;
+        { auto first = std::move(rx); }
+        tx.send(1);
+        REQUIRE(1 == other.receive().value());
+    }
+
+    SECTION("A blocked send resumes once a receiver makes room") {
+        tx.send_bulk({0, 1, 2, 3});
+
+        auto async_send = std::async(std::launch::async, [&tx] { tx.send(4); });
+        REQUIRE(std::future_status::timeout == async_send.wait_for(10ms));
+
+        REQUIRE(0 == rx.receive().value());
+        REQUIRE(std::future_status::ready == async_send.wait_for(1s));
+        REQUIRE(5 == tx.send_for(5, 1ms).value());
+    }
+
+    SECTION("Closing the channel wakes up every waiting receiver") {
+        auto other = rx;
+        auto first = std::async(std::launch::async, [&rx] { return rx.receive(); });
+        auto second = std::async(std::launch::async, [&other] { return other.receive(); });
+        std::this_thread::sleep_for(10ms);
+        tx.close();
+
+        REQUIRE_FALSE(first.get().has_value());
+        REQUIRE_FALSE(second.get().has_value());
+    }
+
+    SECTION("Many producers and receivers get every value exactly once") {
+        constexpr int producers_count = 4;
+        constexpr int per_producer = 20000;
+
+        auto producers = std::vector<std::thread>{};
+        for (int p = 0; p < producers_count; ++p) {
+            producers.emplace_back([tx = tx, p]() mutable {
+                for (int i = 0; i < per_producer; ++i) {
+                    tx.send(p * per_producer + i);
+                }
+            });
+        }
+
+        auto received = std::vector<std::vector<int>>(4);
+        auto receivers = std::vector<std::thread>{};
+        for (auto& vals: received) {
+            receivers.emplace_back([rx = rx, &vals]() mutable {
+                for (int v: rx) {
+                    vals.push_back(v);
+                    if (vals.size() % 5 == 0) {
+                        rx.try_drain_into(vals);
+                    }
+                }
+            });
+        }
+
+        for (auto& t: producers) {
+            t.join();
+        }
+        // Wait for everything to be taken before closing, which drops what is left.
+        while (rx.ready()) {
+            std::this_thread::sleep_for(1ms);
+        }
+        tx.close();
+        for (auto& t: receivers) {
+            t.join();
+        }
+
+        auto vals = std::vector<int>{};
+        for (const auto& part: received) {
+            // Each receiver takes the values of a producer in the order they were sent.
+            auto last = std::vector<int>(producers_count, -1);
+            auto in_order = true;
+            for (int v: part) {
+                in_order = in_order and last[v / per_producer] < v;
+                last[v / per_producer] = v;
+            }
+            REQUIRE(in_order);
+            vals.insert(vals.end(), part.begin(), part.end());
+        }
+        std::sort(vals.begin(), vals.end());
+        auto expected = std::vector<int>(producers_count * per_producer);
+        std::iota(expected.begin(), expected.end(), 0);
+        REQUIRE(expected == vals);
+    }
+
+    SECTION("A value whose constructor throws is skipped") {
+        struct Throwing {
+            explicit Throwing(int value) : value{value} {
+                if (value < 0) {
+                    throw std::runtime_error{"negative"};
+                }
+            }
+            int value;
+        };
+        auto [throwing_tx, throwing_rx] = mpsc::make_mpmc_channel<Throwing>(4);
+        throwing_tx.emplace(1);
+        REQUIRE_THROWS_AS(throwing_tx.emplace(-1), std::runtime_error);
+        throwing_tx.emplace(2);
+
+        REQUIRE(1 == throwing_rx.receive().value().value);
+        REQUIRE(2 == throwing_rx.receive().value().value);
+        REQUIRE_FALSE(throwing_rx.try_receive().has_value());
+
+        // So are the cells a batch claimed after the value which threw.
+        const auto batch = std::views::iota(3, 7) | std::views::transform([](int v) { return 5 == v ? -1 : v; });
+        REQUIRE_THROWS_AS(throwing_tx.send_range(batch.begin(), batch.end()), std::runtime_error);
+        REQUIRE(3 == throwing_rx.receive().value().value);
+        REQUIRE(4 == throwing_rx.receive().value().value);
+        throwing_tx.emplace(7);
+        REQUIRE(7 == throwing_rx.receive().value().value);
+        REQUIRE_FALSE(throwing_rx.try_receive().has_value());
+    }
+
+    SECTION("A batch claims the free cells at once, and waits for room for the rest") {
+        auto batch = std::vector<int>(10);
+        std::iota(batch.begin(), batch.end(), 0);
+        auto async_send = std::async(std::launch::async, [&] { tx.send_range(batch.begin(), batch.end()); });
+
+        auto vals = std::vector<int>{};
+        while (vals.size() < batch.size()) {
+            vals.push_back(rx.receive().value());
+        }
+        REQUIRE(std::future_status::ready == async_send.wait_for(1s));
+        REQUIRE(batch == vals);
+        REQUIRE_FALSE(rx.try_receive().has_value());
+    }
+
+    SECTION("Values left in the ring are destroyed with it") {
+        auto value = std::make_shared<int>(3);
+        {
+            auto [ptr_tx, ptr_rx] = mpsc::make_mpmc_channel<std::shared_ptr<int>>(2);
+            ptr_tx.send(value);
+            ptr_tx.send(value);
+            REQUIRE(3 == value.use_count());
+        }
+        REQUIRE(1 == value.use_count());
+    }
+}
+
+TEST_CASE("Broadcast channel tests") {
+    auto [tx, rx] = mpsc::make_broadcast_channel<int>(4);
+
+    static_assert(std::is_copy_constructible_v<decltype(rx)>);
+    static_assert(std::is_copy_assignable_v<decltype(rx)>);
+
+    SECTION("Every receiver gets every value") {
+        auto other = rx;
+        tx.send_bulk({1, 2, 3});
+
+        auto vals = std::vector<int>{};
+        REQUIRE(3 == rx.try_drain_into(vals));
+        REQUIRE(1 == other.receive().value());
+        REQUIRE(2 == other.receive().value());
+        REQUIRE(3 == other.try_receive().value());
+        REQUIRE(std::vector{1, 2, 3} == vals);
+    }
+
+    SECTION("A copy starts where the receiver it was copied from is") {
+        tx.send_bulk({1, 2, 3});
+        REQUIRE(1 == rx.receive().value());
+
+        auto other = rx;
+        REQUIRE(2 == other.receive().value());
+        REQUIRE(2 == rx.receive().value());
+    }
+
+    SECTION("Senders wait for the slowest receiver") {
+        auto slow = rx;
+        tx.send_bulk({0, 1, 2, 3});
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(i == rx.receive().value());
+        }
+        REQUIRE(4 == tx.try_send(4).value());
+
+        auto async_send = std::async(std::launch::async, [&tx] { tx.send(4); });
+        REQUIRE(std::future_status::timeout == async_send.wait_for(10ms));
+        REQUIRE(0 == slow.receive().value());
+        REQUIRE(std::future_status::ready == async_send.wait_for(1s));
+        REQUIRE(4 == rx.receive().value());
+    }
+
+    SECTION("A receiver which is gone doesn't hold senders back") {
+        auto gone = std::optional{rx};
+        tx.send_bulk({0, 1, 2, 3});
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(i == rx.receive().value());
+        }
+
+        auto async_send = std::async(std::launch::async, [&tx] { tx.send(4); });
+        REQUIRE(std::future_status::timeout == async_send.wait_for(10ms));
+        gone.reset();
+        REQUIRE(std::future_status::ready == async_send.wait_for(1s));
+        REQUIRE(4 == rx.receive().value());
+    }
+
+    SECTION("Closing the channel wakes up every waiting receiver") {
+        auto other = rx;
+        auto first = std::async(std::launch::async, [&rx] { return rx.receive(); });
+        auto second = std::async(std::launch::async, [&other] { return other.receive(); });
+        std::this_thread::sleep_for(10ms);
+        tx.close();
+
+        REQUIRE_FALSE(first.get().has_value());
+        REQUIRE_FALSE(second.get().has_value());
+        REQUIRE_THROWS_AS(tx.send(1), mpsc::channel_closed_exception);
+    }
+
+    SECTION("Many producers and receivers: each receiver gets every value, in the order of each producer") {
+        constexpr int producers_count = 3;
+        constexpr int per_producer = 10000;
+
+        auto receivers = std::vector<std::future<std::vector<int>>>{};
+        for (int r = 0; r < 3; ++r) {
+            receivers.push_back(std::async(std::launch::async, [rx = rx]() mutable {
+                auto vals = std::vector<int>{};
+                while (vals.size() < producers_count * per_producer) {
+                    rx.receive_many(std::back_inserter(vals), 16);
+                }
+                return vals;
+            }));
+        }
+
+        // The first receiver would hold the producers back.
+        { auto first = std::move(rx); }
+
+        auto producers = std::vector<std::thread>{};
+        for (int p = 0; p < producers_count; ++p) {
+            producers.emplace_back([&tx, p] {
+                for (int i = 0; i < per_producer; ++i) {
+                    tx.send(p * per_producer + i);
+                }
+            });
+        }
+        for (auto& t: producers) {
+            t.join();
+        }
+
+        for (auto& receiver: receivers) {
+            auto vals = receiver.get();
+            auto last = std::vector<int>(producers_count, -1);
+            auto in_order = true;
+            for (int v: vals) {
+                in_order = in_order and last[v / per_producer] < v;
+                last[v / per_producer] = v;
+            }
+            REQUIRE(in_order);
+            std::sort(vals.begin(), vals.end());
+            auto expected = std::vector<int>(producers_count * per_producer);
+            std::iota(expected.begin(), expected.end(), 0);
+            REQUIRE(expected == vals);
+        }
+    }
+
+    SECTION("Values left in the ring are destroyed with it") {
+        auto value = std::make_shared<int>(3);
+        {
+            auto [ptr_tx, ptr_rx] = mpsc::make_broadcast_channel<std::shared_ptr<int>>(2);
+            auto other = ptr_rx;
+            ptr_tx.send(value);
+            ptr_tx.send(value);
+            REQUIRE(3 == value.use_count());
+            REQUIRE(value == ptr_rx.receive().value());
+            REQUIRE(value == other.receive().value());
+            ptr_tx.send(value);
+            REQUIRE(3 == value.use_count());
+        }
+        REQUIRE(1 == value.use_count());
+    }
+}
+
+TEMPLATE_TEST_CASE("Batch receive tests", "", mpsc::default_policy, NodesPolicy, mpsc::lock_free_policy, mpsc::bounded_policy,
+                   mpsc::spsc_policy, mpsc::mpmc_policy, mpsc::broadcast_policy, mpsc::priority_policy<3>,
+                   mpsc::sharded_policy<4>,
+                   mpsc::shm_policy) {
+    auto [tx, rx] = make_test_channel<int, TestType>();
+
+    SECTION("receive_many takes at most max values, in order") {
+        for (int i = 0; i < 10; ++i) {
+            tx.send(i);
+        }
+
+        auto vals = std::vector<int>{};
+        REQUIRE(4 == rx.receive_many(std::back_inserter(vals), 4));
+        REQUIRE(std::vector{0, 1, 2, 3} == vals);
+
+        REQUIRE(6 == rx.receive_many(std::back_inserter(vals), 100));
+        REQUIRE(std::vector{0, 1, 2, 3, 4, 5, 6, 7, 8, 9} == vals);
+    }
+
+    SECTION("try_receive_many and try_drain_into return 0 on an empty channel") {
+        auto vals = std::vector<int>{};
+        REQUIRE(0 == rx.try_receive_many(std::back_inserter(vals), 4));
+        REQUIRE(0 == rx.try_drain_into(vals));
+        REQUIRE(vals.empty());
+    }
+
+    SECTION("drain_into appends everything present") {
+        auto vals = std::vector<int>{-1};
+        tx.send(1);
+        tx.send(2);
+        tx.send(3);
+
+        REQUIRE(3 == rx.drain_into(vals));
+        REQUIRE(std::vector{-1, 1, 2, 3} == vals);
+        REQUIRE_FALSE(rx.try_receive().has_value());
+    }
+
+    SECTION("receive_many blocks until a value arrives") {
+        auto vals = std::vector<int>{};
+        auto async_recv = std::async(std::launch::async, [&]() { return rx.receive_many(std::back_inserter(vals), 8); });
+        REQUIRE(std::future_status::timeout == async_recv.wait_for(10ms));
+
+        tx.send(5);
+        REQUIRE(std::future_status::ready == async_recv.wait_for(1s));
+        REQUIRE(1 == async_recv.get());
+        REQUIRE(std::vector{5} == vals);
+    }
+
+    SECTION("receive_many returns 0 once the channel is closed") {
+        auto vals = std::vector<int>{};
+        auto async_recv = std::async(std::launch::async, [&]() { return rx.drain_into(vals); });
+
+        std::this_thread::sleep_for(10ms);
+        tx.close();
+        REQUIRE(std::future_status::ready == async_recv.wait_for(1s));
+        REQUIRE(0 == async_recv.get());
+    }
+}
+
+TEMPLATE_TEST_CASE("Range tests", "", mpsc::default_policy, NodesPolicy, mpsc::lock_free_policy, mpsc::bounded_policy,
+                   mpsc::spsc_policy, mpsc::mpmc_policy) {
+    using Receiver = mpsc::Receiver<int, TestType>;
+    static_assert(std::ranges::input_range<Receiver>);
+    static_assert(std::sentinel_for<std::default_sentinel_t, typename Receiver::iterator>);
+    static_assert(std::ranges::input_range<mpsc::ChunkedView<int, TestType>>);
+
+    auto [tx, rx] = make_test_channel<int, TestType>();
+
+    SECTION("A receiver composes with std::views lazily") {
+        for (int i = 0; i < 10; ++i) {
+            tx.send(i);
+        }
+
+        auto vals = std::vector<int>{};
+        for (int v: rx | std::views::filter([](int v) { return v % 2 == 0; }) |
+                        std::views::transform([](int v) { return v * 10; }) | std::views::take(3)) {
+            vals.push_back(v);
+        }
+        REQUIRE(std::vector{0, 20, 40} == vals);
+        // filter() looked for the next match when take() moved past the last value.
+        REQUIRE(7 == rx.try_receive().value());
+    }
+
+    SECTION("Only what is looked at is received") {
+        tx.send(1);
+        tx.send(2);
+
+        auto vals = std::vector<int>{};
+        // take() doesn't wait for a third value.
+        for (int v: rx | std::views::take(2)) {
+            vals.push_back(v);
+        }
+        REQUIRE(std::vector{1, 2} == vals);
+
+        tx.send(3);
+        auto it = rx.begin();
+        REQUIRE(3 == *it);
+        tx.send(4);
+        tx.send(5);
+        // Incrementing skips the value which was never looked at.
+        it++;
+        ++it;
+        REQUIRE(5 == *it);
+        REQUIRE(5 == *it);
+        REQUIRE_FALSE(rx.try_receive().has_value());
+    }
+
+    SECTION("chunked pulls everything present, up to the chunk size") {
+        for (int i = 0; i < 10; ++i) {
+            tx.send(i);
+        }
+
+        auto chunks = rx | mpsc::chunked(4);
+        auto chunk  = chunks.begin();
+        REQUIRE(std::vector{0, 1, 2, 3} == *chunk);
+        ++chunk;
+        REQUIRE(std::vector{4, 5, 6, 7} == *chunk);
+        ++chunk;
+        REQUIRE(std::vector{8, 9} == *chunk);
+        REQUIRE_FALSE(rx.try_receive().has_value());
+
+        REQUIRE_THROWS_AS(mpsc::chunked(0), std::invalid_argument);
+    }
+
+    SECTION("chunked ends with the stream") {
+        auto all_received = std::promise<void>{};
+        auto producer = std::thread{[&tx, done = all_received.get_future()] {
+            for (int i = 0; i < 1000; ++i) {
+                tx.send(i);
+            }
+            done.wait();
+            tx.close();
+        }};
+
+        auto received = 0;
+        auto in_order = true;
+        for (const auto& chunk: rx | mpsc::chunked(64)) {
+            REQUIRE_FALSE(chunk.empty());
+            REQUIRE(chunk.size() <= 64);
+            for (int v: chunk) {
+                in_order = in_order and received++ == v;
+            }
+            if (received == 1000) {
+                all_received.set_value();
+            }
+        }
+        producer.join();
+        REQUIRE(in_order);
+        REQUIRE(1000 == received);
+        REQUIRE_FALSE(rx.receive().has_value());
+    }
+}
+
+TEMPLATE_TEST_CASE("Batch send tests", "", mpsc::default_policy, NodesPolicy, mpsc::lock_free_policy, mpsc::bounded_policy,
+                   mpsc::spsc_policy, mpsc::mpmc_policy, mpsc::broadcast_policy, mpsc::priority_policy<3>,
+                   mpsc::sharded_policy<4>) {
+    auto [tx, rx] = make_test_channel<std::string, TestType>();
+
+    SECTION("send_range enqueues the whole range in order") {
+        const auto sent = std::vector<std::string>{"a", "b", "c"};
+        tx.send_range(sent.begin(), sent.end());
+
+        auto vals = std::vector<std::string>{};
+        REQUIRE(3 == rx.try_drain_into(vals));
+        REQUIRE(sent == vals);
+    }
+
+    SECTION("send_bulk moves the values out of the vector") {
+        auto sent = std::vector<std::string>{"a", "b"};
+        tx.send_bulk(std::move(sent));
+        tx.send("c");
+
+        REQUIRE("a" == rx.receive().value());
+        REQUIRE("b" == rx.receive().value());
+        REQUIRE("c" == rx.receive().value());
+    }
+
+    SECTION("An empty batch sends nothing") {
+        tx.send_bulk({});
+        REQUIRE_FALSE(rx.try_receive().has_value());
+    }
+
+    SECTION("A batch wakes up a receiver blocked on an empty channel") {
+        auto vals = std::vector<std::string>{};
+        auto async_recv = std::async(std::launch::async, [&]() {
+            while (vals.size() < 3) {
+                rx.drain_into(vals);
+            }
+        });
+        std::this_thread::sleep_for(10ms);
+
+        tx.send_bulk({"x", "y", "z"});
+        REQUIRE(std::future_status::ready == async_recv.wait_for(1s));
+        REQUIRE(std::vector<std::string>{"x", "y", "z"} == vals);
+    }
+
+    SECTION("Sending a batch to a closed channel throws") {
+        tx.close();
+        REQUIRE_THROWS_AS(tx.send_bulk({"a"}), mpsc::channel_closed_exception);
+    }
+}
+
+namespace {
+struct Message {
+    Message(int id, std::string text) : id{id}, text{std::move(text)} {}
+    Message(Message&&) = default;
+
+    int id;
+    std::string text;
+};
+}  // namespace
+
+TEMPLATE_TEST_CASE("Emplace and reservation tests", "", mpsc::default_policy, NodesPolicy, mpsc::lock_free_policy,
+                   mpsc::bounded_policy) {
+    auto [tx, rx] = make_test_channel<Message, TestType>();
+
+    SECTION("emplace constructs the value from its arguments") {
+        tx.emplace(1, "one").emplace(2, "two");
+
+        const auto first = rx.receive();
+        REQUIRE(1 == first->id);
+        REQUIRE("one" == first->text);
+        REQUIRE(2 == rx.receive()->id);
+    }
+
+    SECTION("A reserved value is only received once committed") {
+        auto reservation = tx.reserve(1, "");
+        reservation->text = "filled in place";
+        REQUIRE_FALSE(rx.try_receive().has_value());
+
+        reservation.commit();
+        const auto rcvd = rx.try_receive();
+        REQUIRE(rcvd.has_value());
+        REQUIRE("filled in place" == rcvd->text);
+        REQUIRE_THROWS_AS(reservation.commit(), std::invalid_argument);
+    }
+
+    SECTION("A reservation which isn't committed is discarded") {
+        {
+            auto reservation = tx.reserve(1, "dropped");
+        }
+        tx.emplace(2, "kept");
+
+        REQUIRE(2 == rx.receive()->id);
+        REQUIRE_FALSE(rx.try_receive().has_value());
+    }
+
+    SECTION("A commit wakes up the receiver") {
+        auto reservation = tx.reserve(3, "");
+        auto async_recv = std::async(std::launch::async, [&]() { return rx.receive(); });
+        REQUIRE(std::future_status::timeout == async_recv.wait_for(10ms));
+
+        reservation.commit();
+        REQUIRE(std::future_status::ready == async_recv.wait_for(1s));
+        REQUIRE(3 == async_recv.get()->id);
+    }
+
+    SECTION("emplace on a closed channel throws") {
+        tx.close();
+        REQUIRE_THROWS_AS(tx.emplace(1, "late"), mpsc::channel_closed_exception);
+    }
+}
+
+TEST_CASE("Bounded channel reservation tests") {
+    auto [tx, rx] = mpsc::make_bounded_channel<int>(2);
+
+    SECTION("A reservation holds back the values sent behind it") {
+        auto reservation = tx.reserve(1);
+        tx.send(2);
+        REQUIRE_FALSE(rx.try_receive().has_value());
+        REQUIRE(tx.try_send(3).has_value());
+
+        reservation.commit();
+        REQUIRE(1 == rx.receive().value());
+        REQUIRE(2 == rx.receive().value());
+    }
+
+    SECTION("Discarding a reservation releases its slot and what is behind it") {
+        auto reservation = std::optional{tx.reserve(1)};
+        tx.send(2);
+        auto async_recv = std::async(std::launch::async, [&]() { return rx.receive(); });
+        REQUIRE(std::future_status::timeout == async_recv.wait_for(10ms));
+
+        reservation.reset();
+        REQUIRE(std::future_status::ready == async_recv.wait_for(1s));
+        REQUIRE(2 == async_recv.get().value());
+        REQUIRE_FALSE(tx.try_send(3).has_value());
+        REQUIRE_FALSE(tx.try_send(4).has_value());
+    }
+}
+
+namespace {
+// Counts the allocations made through it, in a counter shared by its copies.
+template <typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    explicit CountingAllocator(std::shared_ptr<std::atomic<int>> allocations) : allocations{std::move(allocations)} {}
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& other) : allocations{other.allocations} {}
+
+    T* allocate(std::size_t n) {
+        ++*allocations;
+        return std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n) { std::allocator<T>{}.deallocate(p, n); }
+
+    template <typename U>
+    bool operator==(const CountingAllocator<U>& other) const noexcept {
+        return allocations == other.allocations;
+    }
+
+    std::shared_ptr<std::atomic<int>> allocations;
+};
+
+template <typename Base, bool Recycle>
+struct CountingPolicy : Base {
+    using allocator = CountingAllocator<void>;
+    static constexpr bool recycle_nodes = Recycle;
+    // Nodes are what's counted here, even for an int.
+    static constexpr std::size_t inline_size = 0;
+};
+
+struct CountingSegmentPolicy : mpsc::default_policy {
+    using allocator = CountingAllocator<void>;
+};
+
+// Throws something else than std::bad_alloc once `failing` is set.
+template <typename T>
+struct FailingAllocator {
+    using value_type = T;
+
+    explicit FailingAllocator(std::shared_ptr<std::atomic<bool>> failing) : failing{std::move(failing)} {}
+
+    template <typename U>
+    FailingAllocator(const FailingAllocator<U>& other) : failing{other.failing} {}
+
+    T* allocate(std::size_t n) {
+        if (*failing) {
+            throw std::runtime_error{"This allocator is out of luck."};
+        }
+        return std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n) { std::allocator<T>{}.deallocate(p, n); }
+
+    template <typename U>
+    bool operator==(const FailingAllocator<U>& other) const noexcept {
+        return failing == other.failing;
+    }
+
+    std::shared_ptr<std::atomic<bool>> failing;
+};
+
+template <typename Base>
+struct FailingPolicy : Base {
+    using allocator = FailingAllocator<void>;
+};
+}  // namespace
+
+TEMPLATE_TEST_CASE("Node allocation tests", "", mpsc::default_policy, mpsc::lock_free_policy, mpsc::priority_policy<3>,
+                   mpsc::sharded_policy<4>) {
+    auto allocations = std::make_shared<std::atomic<int>>(0);
+
+    SECTION("Nodes are allocated from the allocator of the policy") {
+        using Policy = CountingPolicy<TestType, false>;
+        auto [tx, rx] = mpsc::make_channel<int, Policy>(CountingAllocator<void>{allocations});
+        const int initial = *allocations;
+
+        tx.send(1);
+        tx.send_bulk({2, 3});
+        REQUIRE(initial + 3 == *allocations);
+        REQUIRE(1 == rx.receive().value());
+    }
+
+    SECTION("A channel recycling its nodes doesn't allocate in a steady state") {
+        using Policy = CountingPolicy<TestType, true>;
+        auto [tx, rx] = mpsc::make_channel<int, Policy>(CountingAllocator<void>{allocations});
+
+        for (int i = 0; i < 4; ++i) {
+            tx.send(i);
+        }
+        auto vals = std::vector<int>{};
+        rx.drain_into(vals);
+        const int warmed_up = *allocations;
+
+        for (int i = 0; i < 1000; ++i) {
+            tx.send(i);
+            tx.emplace(i);
+            tx.send_bulk({i, i});
+            REQUIRE(i == rx.receive().value());
+            REQUIRE(3 == rx.receive_many(std::back_inserter(vals), 3));
+        }
+        REQUIRE(warmed_up == *allocations);
+    }
+
+    SECTION("Recycled nodes survive many producers") {
+        auto [tx, rx] = mpsc::make_channel<int, CountingPolicy<TestType, true>>(CountingAllocator<void>{allocations});
+
+        auto threads = std::vector<std::thread>{};
+        for (int p = 0; p < 4; ++p) {
+            threads.emplace_back([tx = tx]() mutable {
+                for (int i = 0; i < 5000; ++i) {
+                    tx.send(i);
+                }
+            });
+        }
+
+        long long sum = 0;
+        for (int n = 0; n < 4 * 5000; ++n) {
+            sum += rx.receive().value();
+        }
+        for (auto& t: threads) {
+            t.join();
+        }
+        REQUIRE(4LL * (4999 * 5000 / 2) == sum);
+    }
+
+    SECTION("A non-throwing send to a closed channel doesn't allocate") {
+        auto [tx, rx] = mpsc::make_channel<int, CountingPolicy<TestType, false>>(CountingAllocator<void>{allocations});
+        tx.close();
+        const int initial = *allocations;
+
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(mpsc::send_status::closed == tx.try_send(i, std::nothrow).status);
+        }
+        REQUIRE(initial == *allocations);
+    }
+
+    SECTION("Any exception of the allocator makes a non-throwing send report a full channel") {
+        auto failing  = std::make_shared<std::atomic<bool>>(false);
+        auto [tx, rx] = mpsc::make_channel<int, FailingPolicy<TestType>>(FailingAllocator<void>{failing});
+        *failing      = true;
+
+        // Segments have room for more values before they need another allocation.
+        mpsc::send_result<int> result{mpsc::send_status::sent, std::nullopt};
+        int sent = 0;
+        for (; result and sent < 10000; ++sent) {
+            result = tx.try_send(sent, std::nothrow);
+        }
+        REQUIRE(mpsc::send_status::full == result.status);
+        REQUIRE(sent - 1 == result.value.value());
+
+        *failing = false;
+        REQUIRE(tx.try_send(sent - 1, std::nothrow));
+        auto received = std::vector<int>{};
+        for (int i = 0; i < sent; ++i) {
+            received.push_back(rx.receive().value());
+        }
+        std::sort(received.begin(), received.end());
+        auto expected = std::vector<int>(static_cast<std::size_t>(sent));
+        std::iota(expected.begin(), expected.end(), 0);
+        REQUIRE(expected == received);
+    }
+}
+
+namespace {
+// Trivially copyable, but not trivial: its default constructor isn't.
+struct Tick {
+    int id = -1;
+    double price = 0.0;
+};
+}  // namespace
+
+static_assert(std::is_same_v<mpsc::detail::backend_of<int, mpsc::default_policy>, mpsc::detail::segmented_backend>,
+              "Small trivial values are stored by value.");
+static_assert(std::is_same_v<mpsc::detail::backend_of<Tick, mpsc::default_policy>, mpsc::detail::segmented_backend>,
+              "Trivially copyable values are stored by value, even with default member initializers.");
+static_assert(std::is_same_v<mpsc::detail::backend_of<std::string, mpsc::default_policy>, mpsc::locked_backend>,
+              "Other values get a node each.");
+static_assert(std::is_same_v<mpsc::detail::backend_of<std::array<int, 8>, mpsc::default_policy>, mpsc::locked_backend>,
+              "Values larger than inline_size get a node each.");
+static_assert(std::is_same_v<mpsc::detail::backend_of<int, NodesPolicy>, mpsc::locked_backend>,
+              "An inline_size of 0 keeps a node per value.");
+static_assert(std::is_same_v<mpsc::detail::backend_of<int, mpsc::lock_free_policy>, mpsc::lock_free_backend>,
+              "Only the locked backend stores values by value.");
+
+TEST_CASE("Segmented storage tests") {
+    auto [tx, rx] = mpsc::make_channel<int>();
+
+    SECTION("Values keep their order across many segments") {
+        for (int i = 0; i < 10000; ++i) {
+            tx.send(i);
+        }
+        for (int i = 0; i < 5000; ++i) {
+            REQUIRE(i == rx.receive().value());
+        }
+        auto vals = std::vector<int>(5000);
+        for (std::size_t received = 0; received < vals.size();) {
+            received += rx.receive_many(vals.begin() + static_cast<std::ptrdiff_t>(received), 777);
+        }
+        for (int i = 0; i < 5000; ++i) {
+            REQUIRE(5000 + i == vals[static_cast<std::size_t>(i)]);
+        }
+        REQUIRE_FALSE(rx.try_receive().has_value());
+    }
+
+    SECTION("Batches spanning segments are copied in and out whole") {
+        auto batch = std::vector<int>(3000);
+        std::iota(batch.begin(), batch.end(), 0);
+        tx.send_range(batch.begin(), batch.end());
+        tx.send_bulk(std::vector<int>(batch));
+        const auto rest = std::list<int>{-1, -2};
+        tx.send_range(rest.begin(), rest.end());
+
+        int block[1000];
+        REQUIRE(1000 == rx.receive_many(block, 1000));
+        REQUIRE(999 == block[999]);
+        auto vals = std::vector<int>{};
+        REQUIRE(5002 == rx.receive_many(std::back_inserter(vals), 6000));
+        REQUIRE(1000 == vals.front());
+        REQUIRE(2999 == vals[1999]);
+        REQUIRE(0 == vals[2000]);
+        REQUIRE(2999 == vals[4999]);
+        REQUIRE(-2 == vals.back());
+    }
+
+    SECTION("drain_into and chunked grow the vector once for a whole batch") {
+        auto batch = std::vector<int>(3000);
+        std::iota(batch.begin(), batch.end(), 0);
+        tx.send_range(batch.begin(), batch.end());
+
+        // Growing it a value at a time would leave room for more.
+        auto vals = std::vector<int>{};
+        REQUIRE(3000 == rx.drain_into(vals));
+        REQUIRE(batch == vals);
+        REQUIRE(3000 == vals.capacity());
+
+        tx.send_range(batch.begin(), batch.end());
+        vals.resize(1);
+        REQUIRE(3000 == rx.try_drain_into(vals));
+        REQUIRE(0 == vals[1]);
+        REQUIRE(2999 == vals.back());
+        REQUIRE(3001 == vals.size());
+
+        tx.send_range(batch.begin(), batch.end());
+        auto chunks = rx | mpsc::chunked(1000);
+        auto chunk = chunks.begin();
+        for (int first = 0; first < 3000; first += 1000, ++chunk) {
+            REQUIRE(1000 == chunk->size());
+            REQUIRE(first == chunk->front());
+            REQUIRE(first + 999 == chunk->back());
+        }
+        REQUIRE_FALSE(rx.try_receive().has_value());
+    }
+
+    SECTION("Trivially copyable values with default member initializers are copied as they are") {
+        auto [ticks_tx, ticks_rx] = mpsc::make_channel<Tick>();
+        auto batch                = std::vector<Tick>(500);
+        for (int i = 0; i < 500; ++i) {
+            batch[static_cast<std::size_t>(i)] = Tick{i, i * 0.5};
+        }
+        ticks_tx.send(Tick{});
+        ticks_tx.send_range(batch.begin(), batch.end());
+
+        REQUIRE(-1 == ticks_rx.receive().value().id);
+        Tick block[200];
+        REQUIRE(200 == ticks_rx.receive_many(block, 200));
+        REQUIRE(199 == block[199].id);
+        auto vals = std::vector<Tick>{};
+        REQUIRE(300 == ticks_rx.receive_many(std::back_inserter(vals), 1000));
+        REQUIRE(200 == vals.front().id);
+        REQUIRE(499 == vals.back().id);
+        REQUIRE(249.5 == vals.back().price);
+    }
+}
+
+TEST_CASE("Segment allocation tests") {
+    auto allocations = std::make_shared<std::atomic<int>>(0);
+    auto [tx, rx]    = mpsc::make_channel<int, CountingSegmentPolicy>(CountingAllocator<void>{allocations});
+
+    SECTION("Segments are allocated from the allocator of the policy, not one per value") {
+        const int initial = *allocations;
+        for (int i = 0; i < 100; ++i) {
+            tx.send(i);
+        }
+        REQUIRE(initial + 1 == *allocations);
+    }
+
+    SECTION("A channel in a steady state reuses its segments") {
+        auto vals = std::vector<int>{};
+        for (int i = 0; i < 300; ++i) {
+            tx.send(i);
+        }
+        rx.drain_into(vals);
+        const int warmed_up = *allocations;
+
+        for (int round = 0; round < 100; ++round) {
+            for (int i = 0; i < 300; ++i) {
+                tx.send(i);
+            }
+            vals.clear();
+            REQUIRE(300 == rx.receive_many(std::back_inserter(vals), 300));
+            REQUIRE(299 == vals.back());
+        }
+        REQUIRE(warmed_up == *allocations);
+    }
+}
+
+template <typename Base>
+struct SpinningPolicy : Base {
+    using wait_strategy = mpsc::spin_then_park<64, 4>;
+};
+
+template <typename Base, std::size_t Items = 4, unsigned IdleMicroseconds = 100>
+struct CoalescingPolicy : Base {
+    using wait_strategy = mpsc::coalesce_wakeups<Items, IdleMicroseconds>;
+};
+
+TEMPLATE_TEST_CASE("Wait strategy tests", "", SpinningPolicy<mpsc::default_policy>, SpinningPolicy<NodesPolicy>,
+                   SpinningPolicy<mpsc::lock_free_policy>, SpinningPolicy<mpsc::spsc_policy>, mpsc::spinning_policy,
+                   CoalescingPolicy<mpsc::default_policy>, CoalescingPolicy<mpsc::lock_free_policy>,
+                   CoalescingPolicy<mpsc::bounded_policy>, CoalescingPolicy<mpsc::spsc_policy>, mpsc::coalescing_policy) {
+    SECTION("Values can bounce between two channels") {
+        auto [ping_tx, ping_rx] = make_test_channel<int, TestType>();
+        auto [pong_tx, pong_rx] = make_test_channel<int, TestType>();
+
+        std::thread echo{[&, rx = std::move(ping_rx)]() mutable {
+            for (int v: rx) {
+                pong_tx.send(v + 1);
+            }
+        }};
+
+        for (int i = 0; i < 1000; ++i) {
+            ping_tx.send(i);
+            REQUIRE(i + 1 == pong_rx.receive().value());
+        }
+        ping_tx.close();
+        echo.join();
+    }
+
+    SECTION("Closing sender wakes up a waiting receiver") {
+        auto [tx, rx] = make_test_channel<int, TestType>();
+
+        std::thread closer{[&] {
+            std::this_thread::sleep_for(20ms);
+            tx.close();
+        }};
+        REQUIRE_FALSE(rx.receive().has_value());
+        closer.join();
+    }
+
+    SECTION("A receiver which gave up spinning is woken up for every value") {
+        auto [tx, rx] = make_test_channel<int, TestType>();
+
+        std::thread producer{[&] {
+            for (int i = 0; i < 100; ++i) {
+                std::this_thread::sleep_for(100us);
+                tx.send(i);
+            }
+        }};
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(i == rx.receive().value());
+        }
+        producer.join();
+    }
+}
+
+TEMPLATE_TEST_CASE("Wakeup coalescing tests", "", mpsc::default_policy, NodesPolicy, mpsc::lock_free_policy, mpsc::bounded_policy,
+                   mpsc::spsc_policy, mpsc::priority_policy<2>) {
+    SECTION("A parked receiver is only woken up by a full batch") {
+        auto [tx, rx] = make_test_channel<int, CoalescingPolicy<TestType, 4, 10'000'000>>();
+        auto async_drain = std::async(std::launch::async, [&rx] {
+            auto values = std::vector<int>{};
+            rx.drain_into(values);
+            return values;
+        });
+
+        std::this_thread::sleep_for(20ms);
+        tx.send(1).send(2).send(3);
+        REQUIRE(std::future_status::timeout == async_drain.wait_for(20ms));
+        tx.send(4);
+        REQUIRE(std::future_status::ready == async_drain.wait_for(1s));
+        REQUIRE(std::vector<int>{1, 2, 3, 4} == async_drain.get());
+    }
+
+    SECTION("A value is received after the idle timeout, and after the channel went idle") {
+        auto [tx, rx] = make_test_channel<int, CoalescingPolicy<TestType, 64, 1000>>();
+        for (int i = 0; i < 3; ++i) {
+            auto async_receive = std::async(std::launch::async, [&rx] { return rx.receive(); });
+            std::this_thread::sleep_for(i * 10ms);
+            tx.send(i);
+            REQUIRE(std::future_status::ready == async_receive.wait_for(1s));
+            REQUIRE(i == async_receive.get().value());
+        }
+    }
+
+    SECTION("Closing wakes up a receiver waiting for a batch") {
+        auto [tx, rx] = make_test_channel<int, CoalescingPolicy<TestType, 4, 10'000'000>>();
+        auto async_receive = std::async(std::launch::async, [&rx] { return rx.receive(); });
+
+        std::this_thread::sleep_for(10ms);
+        tx.close();
+        REQUIRE(std::future_status::ready == async_receive.wait_for(1s));
+        REQUIRE_FALSE(async_receive.get().has_value());
+    }
+
+    SECTION("Bursts and pauses of a producer all get through") {
+        auto [tx, rx] = make_test_channel<int, CoalescingPolicy<TestType, 16, 200>>();
+        std::thread producer{[&tx] {
+            for (int i = 0; i < 20000; ++i) {
+                tx.send(i);
+                if (0 == i % 1000) {
+                    std::this_thread::sleep_for(1ms);
+                }
+            }
+        }};
+
+        auto in_order = true;
+        for (int i = 0; i < 20000; ++i) {
+            in_order = in_order and i == rx.receive().value();
+        }
+        producer.join();
+        REQUIRE(in_order);
+    }
+}
+
+TEMPLATE_TEST_CASE("Timed receive tests", "", mpsc::default_policy, NodesPolicy, mpsc::lock_free_policy, mpsc::bounded_policy,
+                   mpsc::spsc_policy, mpsc::mpmc_policy, mpsc::broadcast_policy, mpsc::priority_policy<3>,
+                   mpsc::sharded_policy<4>,
+                   mpsc::shm_policy, mpsc::spinning_policy) {
+    auto [tx, rx] = make_test_channel<int, TestType>();
+
+    SECTION("receive_for times out on an empty channel") {
+        const auto start = std::chrono::steady_clock::now();
+        REQUIRE_FALSE(rx.receive_for(20ms).has_value());
+        REQUIRE(std::chrono::steady_clock::now() - start >= 20ms);
+    }
+
+    SECTION("receive_for returns a present value right away") {
+        tx.send(1);
+        REQUIRE(1 == rx.receive_for(1h).value());
+    }
+
+    SECTION("receive_until wakes up when a value arrives") {
+        std::thread producer{[&] {
+            std::this_thread::sleep_for(10ms);
+            tx.send(2);
+        }};
+        REQUIRE(2 == rx.receive_until(std::chrono::system_clock::now() + 1h).value());
+        producer.join();
+    }
+
+    SECTION("receive_for wakes up when the channel is closed") {
+        std::thread closer{[&] {
+            std::this_thread::sleep_for(10ms);
+            tx.close();
+        }};
+        const auto start = std::chrono::steady_clock::now();
+        REQUIRE_FALSE(rx.receive_for(1h).has_value());
+        REQUIRE(std::chrono::steady_clock::now() - start < 1h);
+        closer.join();
+    }
+
+    SECTION("A receiver can alternate between timeouts and values") {
+        for (int i = 0; i < 20; ++i) {
+            REQUIRE_FALSE(rx.receive_for(100us).has_value());
+            tx.send(i);
+            REQUIRE(i == rx.receive_for(1h).value());
+        }
+    }
+
+    SECTION("Nothing is lost while receive_for keeps timing out") {
+        std::thread producer{[&] {
+            for (int i = 0; i < 200; ++i) {
+                if (i % 8 == 0) {
+                    std::this_thread::sleep_for(200us);
+                }
+                tx.send(i);
+            }
+        }};
+        for (int expected = 0; expected < 200;) {
+            if (auto v = rx.receive_for(50us); v.has_value()) {
+                REQUIRE(expected++ == *v);
+            }
+        }
+        producer.join();
+    }
+}
+
+TEMPLATE_TEST_CASE("Polling tests", "", mpsc::default_policy, NodesPolicy, mpsc::lock_free_policy, mpsc::bounded_policy,
+                   mpsc::priority_policy<3>, mpsc::sharded_policy<4>) {
+    auto [tx, rx] = make_test_channel<int, TestType>();
+
+    SECTION("try_receive finds a value sent under contention") {
+        // A full bounded channel has something to receive too.
+        auto send = [](auto& sender, int value) {
+            if constexpr (std::is_same_v<typename TestType::backend, mpsc::bounded_backend>) {
+                (void)sender.try_send(value);
+            }
+            else {
+                sender.send(value);
+            }
+        };
+        auto flood = [send, tx = tx]() mutable {
+            for (int i = 0; i < 5000; ++i) {
+                send(tx, -1);
+            }
+        };
+        std::vector<std::thread> producers;
+        for (int p = 0; p < 3; ++p) {
+            producers.emplace_back(flood);
+        }
+
+        for (int i = 0; i < 2000; ++i) {
+            send(tx, i);
+            REQUIRE(rx.try_receive().has_value());
+        }
+        for (auto& t: producers) {
+            t.join();
+        }
+    }
+
+    SECTION("try_receive and try_receive_many on an empty channel return nothing") {
+        REQUIRE_FALSE(rx.try_receive().has_value());
+        auto vals = std::vector<int>{};
+        REQUIRE(0 == rx.try_drain_into(vals));
+        tx.send(1);
+        REQUIRE(1 == rx.try_drain_into(vals));
+        REQUIRE_FALSE(rx.try_receive().has_value());
+    }
+}
+
+template <typename Base>
+struct DrainingPolicy : Base {
+    static constexpr bool drain_on_close = true;
+};
+
+TEMPLATE_TEST_CASE("Drain on close tests", "", DrainingPolicy<mpsc::default_policy>, DrainingPolicy<NodesPolicy>,
+                   DrainingPolicy<mpsc::lock_free_policy>, DrainingPolicy<mpsc::bounded_policy>,
+                   DrainingPolicy<mpsc::mpmc_policy>, DrainingPolicy<mpsc::broadcast_policy>,
+                   DrainingPolicy<mpsc::priority_policy<3>>, DrainingPolicy<mpsc::sharded_policy<4>>,
+                   DrainingPolicy<mpsc::shm_policy>) {
+    auto [tx, rx] = make_test_channel<int, TestType>();
+
+    SECTION("Values sent before close are still received") {
+        tx.send_bulk({1, 2, 3});
+        tx.close();
+        REQUIRE(rx.closed());
+        REQUIRE(1 == rx.receive().value());
+        REQUIRE(2 == rx.try_receive().value());
+        REQUIRE(3 == rx.receive_for(1h).value());
+        REQUIRE_FALSE(rx.receive().has_value());
+        REQUIRE_FALSE(rx.try_receive().has_value());
+        REQUIRE_FALSE(rx.receive_for(1h).has_value());
+    }
+
+    SECTION("The iterator ends after the last value") {
+        tx.send_bulk({1, 2, 3});
+        tx.close();
+        auto vals = std::vector<int>{};
+        std::copy(rx.begin(), rx.end(), std::back_inserter(vals));
+        REQUIRE(std::vector{1, 2, 3} == vals);
+    }
+
+    SECTION("Batch receives drain what is left") {
+        tx.send_bulk({1, 2, 3, 4});
+        tx.close();
+        auto vals = std::vector<int>{};
+        REQUIRE(1 == rx.receive_many(std::back_inserter(vals), 1));
+        REQUIRE(1 == rx.try_receive_many(std::back_inserter(vals), 1));
+        REQUIRE(2 == rx.drain_into(vals));
+        REQUIRE(0 == rx.drain_into(vals));
+        REQUIRE(0 == rx.try_drain_into(vals));
+        REQUIRE(std::vector{1, 2, 3, 4} == vals);
+    }
+
+    SECTION("The receiver gets everything from producers which are gone") {
+        auto producers = std::vector<std::thread>{};
+        for (int p = 0; p < 3; ++p) {
+            producers.emplace_back([tx = tx]() mutable {
+                for (int i = 0; i < 1000; ++i) {
+                    tx.send(i);
+                }
+            });
+        }
+        { auto last = std::move(tx); }
+
+        long long sum = 0;
+        for (int v: rx) {
+            sum += v;
+        }
+        REQUIRE(3LL * (999 * 1000 / 2) == sum);
+        for (auto& t: producers) {
+            t.join();
+        }
+    }
+
+    SECTION("Sending to a closed channel still throws") {
+        tx.close();
+        REQUIRE_THROWS_AS(tx.send(1), mpsc::channel_closed_exception);
+    }
+}
+
+TEMPLATE_TEST_CASE("Non-throwing send tests", "", mpsc::default_policy, NodesPolicy, mpsc::lock_free_policy, mpsc::bounded_policy,
+                   mpsc::spsc_policy, mpsc::mpmc_policy, mpsc::broadcast_policy, mpsc::priority_policy<3>,
+                   mpsc::sharded_policy<4>, mpsc::shm_policy) {
+    auto [tx, rx] = make_test_channel<int, TestType>();
+
+    SECTION("A sent value isn't handed back") {
+        const mpsc::send_result<int> result = tx.try_send(1, std::nothrow);
+        REQUIRE(result);
+        REQUIRE(mpsc::send_status::sent == result.status);
+        REQUIRE_FALSE(result.value.has_value());
+
+        const int two = 2;
+        REQUIRE(tx.try_send(two, std::nothrow));
+        REQUIRE(1 == rx.receive().value());
+        REQUIRE(2 == rx.receive().value());
+    }
+
+    SECTION("A closed channel hands the value back instead of throwing") {
+        tx.close();
+        const mpsc::send_result<int> result = tx.try_send(1, std::nothrow);
+        REQUIRE_FALSE(result);
+        REQUIRE(mpsc::send_status::closed == result.status);
+        REQUIRE(1 == result.value.value());
+
+        const int two = 2;
+        REQUIRE(2 == tx.try_send(two, std::nothrow).value.value());
+        REQUIRE_FALSE(rx.receive().has_value());
+    }
+
+    SECTION("An empty sender is reported as closed") {
+        auto moved = std::move(tx);
+        const mpsc::send_result<int> result = tx.try_send(1, std::nothrow);
+        REQUIRE(mpsc::send_status::closed == result.status);
+        REQUIRE(1 == result.value.value());
+        REQUIRE(moved.try_send(2, std::nothrow));
+    }
+
+    static_assert(noexcept(tx.try_send(1, std::nothrow)), "Sending an int can't throw.");
+}
+
+TEST_CASE("Non-throwing send of a full or move-only channel") {
+    SECTION("A full bounded channel hands the value back") {
+        auto [tx, rx] = mpsc::make_bounded_channel<int>(1);
+        REQUIRE(tx.try_send(1, std::nothrow));
+        const mpsc::send_result<int> result = tx.try_send(2, std::nothrow);
+        REQUIRE(mpsc::send_status::full == result.status);
+        REQUIRE(2 == result.value.value());
+        REQUIRE(1 == rx.receive().value());
+        REQUIRE(tx.try_send(3, std::nothrow));
+    }
+
+    SECTION("A move-only value is handed back as it was") {
+        auto [tx, rx] = mpsc::make_channel<std::unique_ptr<Frame>, mpsc::intrusive_policy>();
+        tx.close();
+        auto frame       = std::make_unique<Frame>(1);
+        Frame* const raw = frame.get();
+        auto result      = tx.try_send(std::move(frame), std::nothrow);
+        REQUIRE(mpsc::send_status::closed == result.status);
+        REQUIRE(raw == result.value.value().get());
+    }
+
+    SECTION("A value is moved into the channel when sent, and out of it when handed back") {
+        auto [tx, rx] = mpsc::make_channel<std::string>();
+        auto sent     = std::string(64, 'x');
+        REQUIRE(tx.try_send(std::move(sent), std::nothrow));
+        REQUIRE(std::string(64, 'x') == rx.receive().value());
+
+        tx.close();
+        auto rejected = std::string(64, 'y');
+        auto result   = tx.try_send(std::move(rejected), std::nothrow);
+        REQUIRE(std::string(64, 'y') == result.value.value());
+    }
+
+    SECTION("channel_closed_exception is a std::logic_error") {
+        auto [tx, rx] = mpsc::make_channel<int>();
+        tx.close();
+        REQUIRE_THROWS_AS(tx.send(1), std::logic_error);
+    }
+}
+
+TEMPLATE_TEST_CASE("Worker pool tests", "", DrainingPolicy<mpsc::default_policy>, DrainingPolicy<NodesPolicy>,
+                   DrainingPolicy<mpsc::lock_free_policy>, DrainingPolicy<mpsc::bounded_policy>) {
+    auto [tx, rx] = make_test_channel<int, TestType>();
+
+    SECTION("Every value is handled once") {
+        constexpr int count = 10000;
+        auto handled = std::vector<std::atomic<int>>(count);
+        {
+            auto pool = mpsc::WorkerPool{std::move(rx), [&](int v) { handled[v].fetch_add(1); }, 4, 16};
+            REQUIRE(4 == pool.workers());
+
+            auto producers = std::vector<std::thread>{};
+            for (int p = 0; p < 2; ++p) {
+                producers.emplace_back([&tx, p] {
+                    for (int i = p; i < count; i += 2) {
+                        tx.send(i);
+                    }
+                });
+            }
+            for (auto& t: producers) {
+                t.join();
+            }
+            tx.close();
+            pool.join();
+        }
+        REQUIRE(std::all_of(handled.begin(), handled.end(), [](const auto& n) { return 1 == n.load(); }));
+    }
+
+    SECTION("Idle workers steal from a busy one") {
+        // The first worker pulls the whole batch, then waits for the others to handle half of it.
+        for (int i = 0; i < 64; ++i) {
+            tx.send(i);
+        }
+        std::atomic<int> handled{0};
+        std::atomic<bool> first{true};
+        auto pool = mpsc::WorkerPool{std::move(rx),
+                                     [&](int) {
+                                         if (first.exchange(false)) {
+                                             while (handled.load() < 32) {
+                                                 std::this_thread::yield();
+                                             }
+                                         }
+                                         handled.fetch_add(1);
+                                     },
+                                     3, 64};
+        while (handled.load() < 64) {
+            std::this_thread::yield();
+        }
+        tx.close();
+        pool.join();
+        REQUIRE(64 == handled.load());
+    }
+
+    SECTION("Every idle worker takes part in a burst, although the channel goes quiet") {
+        // The first value keeps its worker busy until the others are handled. The channel stays open, so whoever pulls
+        // next blocks in receive_many: only steals can wake the idle workers up.
+        for (int i = 0; i < 64; ++i) {
+            tx.send(i);
+        }
+        std::atomic<int> handled{0};
+        std::atomic<bool> first{true};
+        std::mutex mutex;
+        auto helpers = std::set<std::thread::id>{};
+        auto pool    = mpsc::WorkerPool{std::move(rx),
+                                     [&](int) {
+                                         if (first.exchange(false)) {
+                                             while (handled.load() < 63) {
+                                                 std::this_thread::yield();
+                                             }
+                                             return;
+                                         }
+                                         std::this_thread::sleep_for(1ms);
+                                         {
+                                             std::scoped_lock lock{mutex};
+                                             helpers.insert(std::this_thread::get_id());
+                                         }
+                                         handled.fetch_add(1);
+                                     },
+                                     4, 64};
+        while (handled.load() < 63) {
+            std::this_thread::yield();
+        }
+        tx.close();
+        pool.join();
+        REQUIRE(3 == helpers.size());
+    }
+
+    SECTION("join rethrows what a handler threw") {
+        tx.send(1).send(2).send(3);
+        tx.close();
+        auto pool = mpsc::WorkerPool{std::move(rx), [](int v) {
+                                         if (2 == v) {
+                                             throw std::runtime_error{"handler"};
+                                         }
+                                     },
+                                     2};
+        REQUIRE_THROWS_AS(pool.join(), std::runtime_error);
+        REQUIRE_NOTHROW(pool.join());
+    }
+
+    SECTION("A pool needs a worker and a receiver") {
+        REQUIRE_THROWS_AS((mpsc::WorkerPool{std::move(rx), [](int) {}, 0}), std::invalid_argument);
+        REQUIRE_THROWS_AS((mpsc::WorkerPool{std::move(rx), [](int) {}, 1}), std::invalid_argument);
+    }
+}
+
+TEMPLATE_TEST_CASE("Buffered sender tests", "", mpsc::default_policy, NodesPolicy, mpsc::lock_free_policy, mpsc::bounded_policy) {
+    auto [tx, rx] = make_test_channel<int, TestType>();
+
+    SECTION("Values are sent once a batch is full") {
+        auto buffered = mpsc::BufferedSender{tx, 3};
+        buffered.send(1).send(2);
+        REQUIRE(2 == buffered.buffered());
+        REQUIRE_FALSE(rx.try_receive().has_value());
+
+        buffered.emplace(3);
+        REQUIRE(0 == buffered.buffered());
+        auto values = std::vector<int>{};
+        REQUIRE(3 == rx.try_drain_into(values));
+        REQUIRE(std::vector<int>{1, 2, 3} == values);
+    }
+
+    SECTION("flush, close and destruction send what is buffered") {
+        {
+            auto buffered = mpsc::BufferedSender{tx, 10};
+            buffered.send(1);
+            buffered.flush();
+            REQUIRE(1 == rx.try_receive().value());
+
+            buffered.send(2);
+        }
+        REQUIRE(2 == rx.try_receive().value());
+
+        auto [draining_tx, draining_rx] = make_test_channel<int, DrainingPolicy<TestType>>();
+        auto buffered = mpsc::BufferedSender{std::move(draining_tx), 10};
+        buffered.send(3);
+        buffered.close();
+        REQUIRE(draining_rx.closed());
+        REQUIRE(3 == draining_rx.receive().value());
+        REQUIRE_THROWS_AS(buffered.send(4), mpsc::channel_closed_exception);
+    }
+
+    SECTION("A value buffered for longer than the delay is sent by the next send") {
+        auto buffered = mpsc::BufferedSender{tx, 10, 1ms};
+        buffered.send(1);
+        std::this_thread::sleep_for(2ms);
+        REQUIRE_FALSE(rx.try_receive().has_value());
+
+        buffered.send(2);
+        REQUIRE(1 == rx.try_receive().value());
+        REQUIRE(2 == rx.try_receive().value());
+    }
+
+    SECTION("Many producers buffer on their own") {
+        constexpr int producers_count = 4;
+        constexpr int per_producer = 5000;
+        auto producers = std::vector<std::thread>{};
+        for (int p = 0; p < producers_count; ++p) {
+            producers.emplace_back([buffered = mpsc::BufferedSender{tx, 16}, p]() mutable {
+                for (int i = 0; i < per_producer; ++i) {
+                    buffered.send(p * per_producer + i);
+                }
+            });
+        }
+
+        auto last = std::vector<int>(producers_count, -1);
+        auto in_order = true;
+        for (int i = 0; i < producers_count * per_producer; ++i) {
+            const int value = rx.receive().value();
+            in_order = in_order and last[value / per_producer] < value;
+            last[value / per_producer] = value;
+        }
+        for (auto& t: producers) {
+            t.join();
+        }
+        REQUIRE(in_order);
+        REQUIRE_FALSE(rx.try_receive().has_value());
+    }
+
+    SECTION("A batch has at least one value") {
+        REQUIRE_THROWS_AS(mpsc::BufferedSender(tx, 0), std::invalid_argument);
+    }
+}
+
+#if defined(__linux__)
+TEST_CASE("Shared memory channel tests") {
+    const auto name = unique_shm_name();
+
+    SECTION("Values go through the ring, whose capacity is rounded up") {
+        auto [tx, rx] = mpsc::make_shm_channel<int>(name, 3);
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE_FALSE(tx.try_send(i).has_value());
+        }
+        REQUIRE(4 == tx.try_send(4).value());
+
+        auto values = std::vector<int>{};
+        REQUIRE(4 == rx.try_drain_into(values));
+        REQUIRE(std::vector<int>{0, 1, 2, 3} == values);
+        REQUIRE_FALSE(rx.receive_for(1ms).has_value());
+    }
+
+    SECTION("Opening the same name maps the same ring") {
+        auto [tx, rx] = mpsc::make_shm_channel<int>(name, 16);
+        auto [other_tx, other_rx] = mpsc::make_shm_channel<int>(name, 16);
+        other_tx.send(1);
+        tx.send(2);
+        REQUIRE(1 == rx.receive().value());
+        REQUIRE(2 == rx.receive().value());
+
+        REQUIRE_THROWS_AS((mpsc::make_shm_channel<int>(name, 64)), std::invalid_argument);
+        REQUIRE_THROWS_AS((mpsc::make_shm_channel<std::int64_t>(name, 16)), std::invalid_argument);
+    }
+
+    SECTION("Only one receiver takes from the ring at a time") {
+        auto [tx, rx] = mpsc::make_shm_channel<int>(name, 16);
+        tx.send(1).send(2);
+        {
+            auto [other_tx, other_rx] = mpsc::make_shm_channel<int>(name, 16);
+            REQUIRE(1 == other_rx.receive().value());
+            REQUIRE_THROWS_AS(rx.receive(), std::invalid_argument);
+            REQUIRE_THROWS_AS(rx.try_receive(), std::invalid_argument);
+        }
+        REQUIRE(2 == rx.receive().value());
+    }
+
+    SECTION("A sender blocked on a full ring waits for the receiver") {
+        auto [tx, rx] = mpsc::make_shm_channel<int>(name, 2);
+        tx.send(0).send(1);
+        REQUIRE(2 == tx.send_for(2, 1ms).value());
+
+        auto async_send = std::async(std::launch::async, [&tx] { tx.send(2); });
+        REQUIRE(std::future_status::timeout == async_send.wait_for(10ms));
+        REQUIRE(0 == rx.receive().value());
+        REQUIRE(std::future_status::ready == async_send.wait_for(1s));
+        REQUIRE(1 == rx.receive().value());
+        REQUIRE(2 == rx.receive().value());
+    }
+
+    SECTION("Another process sends to the receiver until it closes") {
+        using Policy = DrainingPolicy<mpsc::shm_policy>;
+        constexpr int count = 20000;
+        auto [tx, rx] = mpsc::make_shm_channel<int, Policy>(name, 64);
+
+        const pid_t child = ::fork();
+        REQUIRE(child >= 0);
+        if (0 == child) {
+            {
+                auto [child_tx, child_rx] = mpsc::make_shm_channel<int, Policy>(name, 64);
+                for (int i = 0; i < count; ++i) {
+                    child_tx.send(i);
+                }
+            }
+            ::_exit(0);
+        }
+
+        // The child opened the channel once its first value arrived, so this process may let go of the stream.
+        auto in_order = 0 == rx.receive().value();
+        auto received = 1;
+        tx.close();
+        for (int value: rx) {
+            in_order = in_order and received == value;
+            ++received;
+        }
+        int status = 0;
+        REQUIRE(child == ::waitpid(child, &status, 0));
+        REQUIRE(WIFEXITED(status));
+        REQUIRE(in_order);
+        REQUIRE(count == received);
+        REQUIRE(rx.closed());
+    }
+
+    SECTION("The name is removed once no process has the channel open") {
+        {
+            auto [tx, rx] = mpsc::make_shm_channel<int>(name, 16);
+            tx.send(1);
+        }
+        REQUIRE(-1 == ::shm_open(name.c_str(), O_RDONLY, 0));
+        REQUIRE(ENOENT == errno);
+    }
+}
+#endif
+
+template <typename Base>
+struct StatsPolicy : Base {
+    static constexpr bool collect_stats = true;
+};
+
+TEMPLATE_TEST_CASE("Stats tests", "", StatsPolicy<mpsc::default_policy>, StatsPolicy<NodesPolicy>,
+                   StatsPolicy<mpsc::lock_free_policy>, StatsPolicy<mpsc::bounded_policy>) {
+    auto [tx, rx] = make_test_channel<int, TestType>();
+
+    SECTION("Sends, receives, depth and high-water mark are counted") {
+        tx.send(1);
+        tx.send_bulk({2, 3, 4});
+        REQUIRE(1 == rx.receive().value());
+        auto reservation = tx.reserve(5);
+        reservation.commit();
+        auto vals = std::vector<int>{};
+        REQUIRE(2 == rx.receive_many(std::back_inserter(vals), 2));
+
+        const mpsc::channel_stats stats = rx.stats();
+        REQUIRE(5 == stats.sends);
+        REQUIRE(3 == stats.receives);
+        REQUIRE(2 == stats.depth);
+        REQUIRE(4 == stats.high_water_mark);
+        REQUIRE(0 == stats.blocked_receives);
+        REQUIRE(0 == stats.notifies);
+        REQUIRE(tx.stats().sends == stats.sends);
+    }
+
+    SECTION("A receive which has to wait is counted, with its wait time and its wakeup") {
+        auto sender = std::async(std::launch::async, [&tx] {
+            std::this_thread::sleep_for(20ms);
+            tx.send(1);
+        });
+        REQUIRE(1 == rx.receive().value());
+        sender.get();
+
+        REQUIRE_FALSE(rx.receive_for(1ms).has_value());
+
+        const mpsc::channel_stats stats = rx.stats();
+        REQUIRE(2 == stats.blocked_receives);
+        REQUIRE(stats.wait_time >= 1ms);
+        REQUIRE(stats.notifies <= 1);
+        REQUIRE(0 == stats.depth);
+    }
+}
+
+static_assert(std::is_empty_v<mpsc::detail::Stats<false>>, "Channels without stats count nothing.");
+
+template <typename Base>
+struct TracingPolicy : Base {
+    static constexpr bool trace_latency = true;
+};
+
+TEMPLATE_TEST_CASE("Latency tracing tests", "", TracingPolicy<mpsc::default_policy>,
+                   TracingPolicy<mpsc::lock_free_policy>, TracingPolicy<mpsc::priority_policy<3>>,
+                   TracingPolicy<mpsc::sharded_policy<4>>) {
+    auto [tx, rx] = make_test_channel<int, TestType>();
+
+    SECTION("Nothing is traced before anything is received") {
+        tx.send(1);
+        REQUIRE(0 == rx.latencies().total());
+        REQUIRE(0ns == rx.latencies().percentile(0.5));
+    }
+
+    SECTION("Every received value is traced, however it's sent and received") {
+        tx.send(1);
+        tx.send_bulk({2, 3, 4});
+        REQUIRE(1 == rx.receive().value());
+        auto vals = std::vector<int>{};
+        REQUIRE(3 == rx.receive_many(std::back_inserter(vals), 8));
+        REQUIRE(4 == rx.latencies().total());
+    }
+
+    if constexpr (std::is_same_v<typename TestType::backend, mpsc::locked_backend> ||
+                  std::is_same_v<typename TestType::backend, mpsc::lock_free_backend>) {
+        SECTION("A reserved value is traced from its commit, not from its reservation") {
+            auto reservation = tx.reserve(1);
+            std::this_thread::sleep_for(20ms);
+            reservation.commit();
+            REQUIRE(1 == rx.receive().value());
+            REQUIRE(1 == rx.latencies().total());
+            REQUIRE(rx.latencies().percentile(1.0) < 20ms);
+        }
+    }
+
+    SECTION("The time a value waits is traced") {
+        tx.send(1);
+        std::this_thread::sleep_for(2ms);
+        REQUIRE(1 == rx.receive().value());
+
+        const mpsc::latency_histogram latencies = rx.latencies();
+        REQUIRE(1 == latencies.total());
+        REQUIRE(latencies.percentile(0.5) >= 2ms);
+        REQUIRE(latencies.percentile(0.5) == latencies.percentile(0.99));
+    }
+
+    SECTION("Latencies can be read while values are sent and received") {
+        auto producer = std::async(std::launch::async, [&tx] {
+            for (int i = 0; i < 1000; ++i) {
+                tx.send(i);
+            }
+        });
+        auto scraper = std::async(std::launch::async, [&rx] {
+            std::uint64_t seen = 0;
+            while (seen < 1000) {
+                const std::uint64_t total = rx.latencies().total();
+                if (total < seen) {
+                    return false;
+                }
+                seen = total;
+            }
+            return true;
+        });
+        for (int i = 0; i < 1000; ++i) {
+            REQUIRE(rx.receive().has_value());
+        }
+        producer.get();
+        REQUIRE(scraper.get());
+        REQUIRE(1000 == rx.latencies().total());
+    }
+}
+
+static_assert(std::is_empty_v<mpsc::detail::Latencies<false>>, "Channels without tracing read no clock.");
+
+TEST_CASE("Select tests") {
+    using namespace std::string_literals;
+
+    auto [int_tx, int_rx] = mpsc::make_channel<int>();
+    auto [str_tx, str_rx] = mpsc::make_channel<std::string, mpsc::lock_free_policy>();
+    auto [dbl_tx, dbl_rx] = mpsc::make_bounded_channel<double>(4);
+
+    SECTION("select returns the first ready receiver right away") {
+        dbl_tx.send(1.5);
+        REQUIRE(2 == mpsc::select(int_rx, str_rx, dbl_rx));
+        str_tx.send("a"s);
+        REQUIRE(1 == mpsc::select(int_rx, str_rx, dbl_rx));
+        REQUIRE(0 == mpsc::select(dbl_rx, str_rx));
+    }
+
+    SECTION("select wakes up for whichever channel gets a value") {
+        std::thread producer{[&] {
+            std::this_thread::sleep_for(5ms);
+            str_tx.send("b"s);
+            std::this_thread::sleep_for(5ms);
+            int_tx.send(1);
+            std::this_thread::sleep_for(5ms);
+            dbl_tx.send(2.5);
+        }};
+
+        REQUIRE(1 == mpsc::select(int_rx, str_rx, dbl_rx));
+        REQUIRE("b"s == str_rx.receive().value());
+        REQUIRE(0 == mpsc::select(int_rx, str_rx, dbl_rx));
+        REQUIRE(1 == int_rx.receive().value());
+        REQUIRE(2 == mpsc::select(int_rx, str_rx, dbl_rx));
+        REQUIRE(2.5 == dbl_rx.receive().value());
+        producer.join();
+    }
+
+    SECTION("A closed channel is ready") {
+        std::thread closer{[&] {
+            std::this_thread::sleep_for(5ms);
+            dbl_tx.close();
+        }};
+        REQUIRE(2 == mpsc::select(int_rx, str_rx, dbl_rx));
+        REQUIRE_FALSE(dbl_rx.receive().has_value());
+        closer.join();
+    }
+
+    SECTION("select_for times out when no channel gets ready") {
+        REQUIRE_FALSE(mpsc::select_for(10ms, int_rx, str_rx, dbl_rx).has_value());
+        int_tx.send(3);
+        REQUIRE(0 == mpsc::select_for(10ms, int_rx, str_rx, dbl_rx));
+    }
+
+    SECTION("Everything from many producers arrives through select") {
+        auto producers = std::vector<std::thread>{};
+        producers.emplace_back([tx = int_tx]() mutable {
+            for (int i = 0; i < 2000; ++i) {
+                tx.send(i);
+            }
+        });
+        producers.emplace_back([tx = str_tx]() mutable {
+            for (int i = 0; i < 2000; ++i) {
+                tx.send(std::to_string(i));
+            }
+        });
+        producers.emplace_back([tx = dbl_tx]() mutable {
+            for (int i = 0; i < 2000; ++i) {
+                tx.send(i);
+            }
+        });
+
+        int received[3] = {0, 0, 0};
+        while (received[0] + received[1] + received[2] < 3 * 2000) {
+            switch (const auto index = mpsc::select(int_rx, str_rx, dbl_rx); index) {
+                case 0:
+                    REQUIRE(received[0]++ == int_rx.receive().value());
+                    break;
+                case 1:
+                    REQUIRE(std::to_string(received[1]++) == str_rx.receive().value());
+                    break;
+                default:
+                    REQUIRE(received[2]++ == dbl_rx.receive().value());
+                    break;
+            }
+        }
+        for (auto& t: producers) {
+            t.join();
+        }
+    }
+}
+
+// Starts running right away, and destroys itself when done.
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+// Runs the coroutines posted to it when asked to.
+struct ManualExecutor {
+    std::mutex* mutex;
+    std::vector<std::coroutine_handle<>>* posted;
+
+    void operator()(std::coroutine_handle<> handle) const {
+        std::lock_guard lock{*mutex};
+        posted->push_back(handle);
+    }
+};
+
+template <typename Policy, typename Executor = mpsc::inline_executor>
+Detached collect(mpsc::Receiver<int, Policy>& rx, std::vector<int>& out, std::atomic<bool>& done, Executor executor = {}) {
+    while (auto value = co_await rx.async_receive(executor)) {
+        out.push_back(*value);
+    }
+    done = true;
+}
+
+#if defined(__linux__)
+// Whether `fd` is readable right now.
+bool readable(int fd) {
+    pollfd entry{fd, POLLIN, 0};
+    return 1 == ::poll(&entry, 1, 0) and 0 != (entry.revents & POLLIN);
+}
+
+TEMPLATE_TEST_CASE("Native handle tests", "", mpsc::default_policy, NodesPolicy, mpsc::lock_free_policy, mpsc::bounded_policy,
+                   mpsc::spsc_policy, mpsc::priority_policy<3>, mpsc::sharded_policy<4>) {
+    auto [tx, rx] = make_test_channel<int, TestType>();
+    const int fd = rx.native_handle();
+    REQUIRE(0 <= fd);
+
+    SECTION("It's the same handle every time") {
+        REQUIRE(fd == rx.native_handle());
+    }
+
+    SECTION("It's readable while values are present, until a receive finds the channel empty") {
+        REQUIRE(readable(fd));
+        REQUIRE_FALSE(rx.try_receive().has_value());
+        REQUIRE_FALSE(readable(fd));
+
+        tx.send(1);
+        tx.send(2);
+        REQUIRE(readable(fd));
+        REQUIRE(1 == rx.try_receive().value());
+        REQUIRE(readable(fd));
+        REQUIRE(2 == rx.try_receive().value());
+        REQUIRE_FALSE(rx.try_receive().has_value());
+        REQUIRE_FALSE(readable(fd));
+
+        tx.send(3);
+        REQUIRE(readable(fd));
+        std::vector<int> values;
+        REQUIRE(1 == rx.try_receive_many(std::back_inserter(values), 16));
+        REQUIRE(std::vector<int>{3} == values);
+        REQUIRE_FALSE(readable(fd));
+    }
+
+    SECTION("Values sent before the handle was created aren't missed") {
+        auto [tx2, rx2] = make_test_channel<int, TestType>();
+        tx2.send(1);
+        const int fd2 = rx2.native_handle();
+        REQUIRE(readable(fd2));
+        REQUIRE(1 == rx2.try_receive().value());
+        REQUIRE_FALSE(rx2.try_receive().has_value());
+        REQUIRE_FALSE(readable(fd2));
+    }
+
+    SECTION("epoll wakes up for values sent by another thread") {
+        REQUIRE_FALSE(rx.try_receive().has_value());
+
+        const int epoll = ::epoll_create1(EPOLL_CLOEXEC);
+        REQUIRE(0 <= epoll);
+        epoll_event event{};
+        event.events  = EPOLLIN | EPOLLET;
+        event.data.fd = fd;
+        REQUIRE(0 == ::epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event));
+
+        constexpr int count = 10000;
+        std::thread producer{[&tx = tx] {
+            for (int value = 0; value < count; ++value) {
+                tx.send(value);
+            }
+        }};
+
+        // Sharded channels don't keep the order across shards, which a migrating producer may use.
+        int received  = 0;
+        long long sum = 0;
+        while (received < count) {
+            epoll_event ready{};
+            REQUIRE(1 == ::epoll_wait(epoll, &ready, 1, 10000));
+            while (std::optional<int> value = rx.try_receive()) {
+                ++received;
+                sum += *value;
+            }
+        }
+        producer.join();
+        ::close(epoll);
+        REQUIRE(count == received);
+        REQUIRE(static_cast<long long>(count) * (count - 1) / 2 == sum);
+    }
+
+    SECTION("It stays readable once the channel is closed") {
+        REQUIRE_FALSE(rx.try_receive().has_value());
+        tx.close();
+        REQUIRE(readable(fd));
+        REQUIRE_FALSE(rx.try_receive().has_value());
+        REQUIRE(readable(fd));
+    }
+}
+#endif
+
+TEMPLATE_TEST_CASE("Coroutine receive tests", "", mpsc::default_policy, NodesPolicy, mpsc::lock_free_policy, mpsc::bounded_policy,
+                   mpsc::priority_policy<3>, mpsc::sharded_policy<4>) {
+    auto [tx, rx] = make_test_channel<int, TestType>();
+    auto vals = std::vector<int>{};
+    std::atomic<bool> done{false};
+
+    SECTION("Sending resumes a suspended receiver") {
+        tx.send(1);
+        collect(rx, vals, done);
+        REQUIRE(std::vector{1} == vals);
+
+        tx.send(2);
+        tx.send_bulk({3, 4});
+        REQUIRE(std::vector{1, 2, 3, 4} == vals);
+        REQUIRE_FALSE(done);
+
+        tx.close();
+        REQUIRE(done);
+    }
+
+    SECTION("A receiver can be resumed through an executor") {
+        std::mutex mutex;
+        std::vector<std::coroutine_handle<>> posted;
+        collect(rx, vals, done, ManualExecutor{&mutex, &posted});
+
+        auto run_posted = [&] {
+            std::unique_lock lock{mutex};
+            auto runnable = std::exchange(posted, {});
+            lock.unlock();
+            for (auto handle: runnable) {
+                handle.resume();
+            }
+        };
+
+        std::thread producer{[&] {
+            for (int i = 0; i < 3; ++i) {
+                tx.send(i);
+            }
+        }};
+        while (vals.size() < 3) {
+            run_posted();
+            std::this_thread::yield();
+        }
+        producer.join();
+        REQUIRE(std::vector{0, 1, 2} == vals);
+
+        tx.close();
+        REQUIRE_FALSE(done);
+        run_posted();
+        REQUIRE(done);
+    }
+
+    SECTION("Values sent from many threads all arrive") {
+        // The receiver may still be running on one producer thread when the last one closes the channel.
+        auto [tx, rx] = make_test_channel<int, DrainingPolicy<TestType>>();
+        collect(rx, vals, done);
+
+        auto producers = std::vector<std::thread>{};
+        for (int p = 0; p < 3; ++p) {
+            producers.emplace_back([tx = tx, p]() mutable {
+                for (int i = 0; i < 1000; ++i) {
+                    tx.send(p);
+                }
+            });
+        }
+        { auto last = std::move(tx); }
+        for (auto& t: producers) {
+            t.join();
+        }
+        REQUIRE(done);
+        REQUIRE(3000 == vals.size());
+        REQUIRE(3000 == std::accumulate(vals.begin(), vals.end(), 0));
+    }
+}
+
+template <typename Policy>
+Detached produce(mpsc::Sender<int, Policy>& tx, int n, std::atomic<bool>& done, bool& refused) {
+    try {
+        for (int i = 0; i < n; ++i) {
+            co_await tx.async_send(i);
+        }
+    }
+    catch (const mpsc::channel_closed_exception&) {
+        refused = true;
+    }
+    done = true;
+}
+
+TEST_CASE("Coroutine send tests") {
+    auto [tx, rx] = mpsc::make_bounded_channel<int>(2);
+    std::atomic<bool> done{false};
+    bool refused = false;
+
+    SECTION("A sender suspends while the channel is full, and is resumed by the receiver") {
+        produce(tx, 5, done, refused);
+        REQUIRE_FALSE(done);
+
+        for (int i = 0; i < 5; ++i) {
+            REQUIRE(i == rx.receive().value());
+        }
+        REQUIRE(done);
+        REQUIRE_FALSE(refused);
+        REQUIRE_FALSE(rx.try_receive().has_value());
+    }
+
+    SECTION("Draining the channel admits suspended senders in order") {
+        std::atomic<bool> other_done{false};
+        bool other_refused = false;
+        auto other_tx = tx;
+
+        tx.send_bulk({0, 1});
+        produce(tx, 1, done, refused);
+        produce(other_tx, 2, other_done, other_refused);
+
+        auto vals = std::vector<int>{};
+        REQUIRE(2 == rx.drain_into(vals));
+        REQUIRE(std::vector{0, 1} == vals);
+        REQUIRE(done);
+        REQUIRE(2 == rx.drain_into(vals));
+        REQUIRE(std::vector{0, 1, 0, 0} == vals);
+        REQUIRE(1 == rx.receive().value());
+        REQUIRE(other_done);
+    }
+
+    SECTION("Closing the channel resumes suspended senders with an exception") {
+        tx.send_bulk({0, 1});
+        produce(tx, 1, done, refused);
+        REQUIRE_FALSE(done);
+
+        rx.receive();
+        rx.receive();
+        REQUIRE(done);
+        REQUIRE_FALSE(refused);
+
+        produce(tx, 3, done, refused);
+        tx.close();
+        REQUIRE(refused);
     }
 }